@@ -0,0 +1,432 @@
+#include <Arduino.h>
+#include <Preferences.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "host_seams.h"
+#include "dashboard_fuzz.h"
+#include "config.h"
+#include "app_log.h"
+#include "dashboard_extract.h"
+#include "dashboard_json.h"
+#include "dashboard_widgets.h"
+#include "lamarzocco_websocket.h"
+#include "lamarzocco_machine.h"
+#include "lamarzocco_auth.h"
+#include "machine_events.h"
+#include "json_allocator.h"
+#include "update_trace.h"
+
+// Host micro-benchmarks for the message path: STOMP codec, both dashboard
+// parsers, the dashboard message handler (diff, parse, widgets, state,
+// display events) and request signing. Dashboard bodies come from a device log (output.txt), so the
+// numbers track what the machine actually sends. Frames go in as WebSocket
+// events through the real LaMarzoccoWebSocket (see shim/WebSocketsClient.h).
+//
+//   pio run -e native && .pio/build/native/program [output.txt]
+//
+// With --replay, a capture file (stomp_capture.h, e.g. rebuilt from a serial
+// log by tools/capture_from_log.py) is fed through the same path instead, as
+// STOMP_REPLAY_SPEEDUP 0 does on the device:
+//
+//   .pio/build/native/program --replay capture.bin
+//
+// --fuzz runs the parser fuzzer on the same bodies (dashboard_fuzz.cpp).
+//
+// --log-stress has four threads log at once through app_log and checks that
+// every line was either written or counted as dropped. Build it with the ring
+// (APP_LOG_ASYNC 1) under ThreadSanitizer:
+//
+//   pio run -e native_tsan && .pio/build/native_tsan/program --log-stress | tail -n 2
+//
+// Absolute rates are the host's; compare runs on the same machine. Allocation
+// counts include everything the operation asked the heap for.
+
+// Each benchmark repeats its pass until at least this long has been measured
+#ifndef BENCH_MIN_MS
+#define BENCH_MIN_MS 500
+#endif
+// WebSocket fragment size for the reassembly benchmark
+#ifndef BENCH_FRAGMENT_BYTES
+#define BENCH_FRAGMENT_BYTES 512
+#endif
+// Threads and lines per thread for --log-stress
+#ifndef LOG_STRESS_PRODUCERS
+#define LOG_STRESS_PRODUCERS 4
+#endif
+#ifndef LOG_STRESS_LINES
+#define LOG_STRESS_LINES 5000
+#endif
+
+typedef std::chrono::steady_clock BenchClock;
+
+static volatile size_t g_sink;  // Keeps results observable
+
+// "... -> Body: {...}" lines of a serial log. Bodies cut short by the log
+// (not ending in '}') are skipped.
+static std::vector<std::string> load_bodies(const char* path, size_t& truncated) {
+    std::vector<std::string> bodies;
+    std::ifstream in(path);
+    std::string line;
+    truncated = 0;
+    while (std::getline(in, line)) {
+        size_t at = line.find("Body: {");
+        if (at == std::string::npos) {
+            continue;
+        }
+        std::string body = line.substr(at + 6);
+        while (!body.empty() && (body.back() == '\r' || body.back() == ' ')) {
+            body.pop_back();
+        }
+        if (body.empty() || body.back() != '}') {
+            truncated++;
+            continue;
+        }
+        bodies.push_back(body);
+    }
+    return bodies;
+}
+
+// A dashboard MESSAGE frame as the broker sends it
+static std::string stomp_message(const std::string& body, size_t seq) {
+    std::string frame = "MESSAGE\n"
+                        "destination:/ws/sn/MR000000/dashboard\n"
+                        "content-type:application/json\n"
+                        "subscription:d968cc75-0708-4513-9ea3-f15682e267b5\n"
+                        "message-id:073f23f7-6448-ecb5-2e04-93766a89df95-";
+    frame += std::to_string(seq);
+    frame += "\ncontent-length:";
+    frame += std::to_string(body.size());
+    frame += "\n\n";
+    frame += body;
+    frame += '\0';
+    return frame;
+}
+
+// Run `pass` (ops_per_pass operations) until BENCH_MIN_MS have elapsed and
+// print the rate. The first pass is a warm-up and is not counted.
+template <typename Pass>
+static void run(const char* name, const char* unit, size_t ops_per_pass, Pass pass) {
+    pass();
+    HostAllocCount before = host_alloc_count();
+    BenchClock::time_point start = BenchClock::now();
+    uint64_t ops = 0;
+    double elapsed_us = 0;
+    do {
+        pass();
+        ops += ops_per_pass;
+        elapsed_us = std::chrono::duration<double, std::micro>(BenchClock::now() - start).count();
+    } while (elapsed_us < BENCH_MIN_MS * 1000.0);
+    HostAllocCount after = host_alloc_count();
+
+    printf("%-20s %12.0f %s/s %9.2f us/op", name, ops * 1e6 / elapsed_us, unit, elapsed_us / ops);
+    if (host_alloc_counting()) {
+        printf(" %7.2f allocs/op %9.1f B/op\n",
+               (double)(after.calls - before.calls) / ops,
+               (double)(after.bytes - before.bytes) / ops);
+    } else {
+        printf("   allocations not counted\n");
+    }
+}
+
+// Message callback for the codec benchmarks: just the body span
+static void count_body(const char* body, size_t length) {
+    (void)body;
+    g_sink += length;
+}
+
+// One frame as a single TEXT message
+static void deliver_text(std::string& frame) {
+    host_websocket_event(WStype_TEXT, (uint8_t*)&frame[0], frame.size());
+}
+
+// One frame as a fragmented TEXT message of BENCH_FRAGMENT_BYTES pieces
+static void deliver_fragmented(std::string& frame) {
+    if (frame.size() <= BENCH_FRAGMENT_BYTES) {
+        deliver_text(frame);
+        return;
+    }
+    for (size_t offset = 0; offset < frame.size(); offset += BENCH_FRAGMENT_BYTES) {
+        size_t length = std::min((size_t)BENCH_FRAGMENT_BYTES, frame.size() - offset);
+        WStype_t type = offset == 0 ? WStype_FRAGMENT_TEXT_START :
+                        offset + length == frame.size() ? WStype_FRAGMENT_FIN : WStype_FRAGMENT;
+        host_websocket_event(type, (uint8_t*)&frame[offset], length);
+    }
+}
+
+// Producers race for ring slots and, when it is full, the drop counter; the
+// drain task writes the lines to stdout
+static int log_stress() {
+    app_log_begin();
+    AppLogStats before = app_log_get_stats();
+    std::vector<std::thread> producers;
+    for (int p = 0; p < LOG_STRESS_PRODUCERS; p++) {
+        producers.emplace_back([p]() {
+            for (int line = 0; line < LOG_STRESS_LINES; line++) {
+                // Mostly keep pace with the drain task so the ring wraps many
+                // times, with a burst every 1000 lines that overflows it
+                while (line % 1000 < 900 && app_log_pending() >= APP_LOG_RING_SLOTS - 1) {
+                    std::this_thread::yield();
+                }
+                app_log_write(APP_LOG_INFO, "STRESS", "producer %d line %d", p, line);
+            }
+        });
+    }
+    for (size_t p = 0; p < producers.size(); p++) {
+        producers[p].join();
+    }
+    while (app_log_pending() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(APP_LOG_DRAIN_MS));
+    }
+    // Let the drain task report drops before the summary
+    std::this_thread::sleep_for(std::chrono::milliseconds(4 * APP_LOG_DRAIN_MS));
+    AppLogStats after = app_log_get_stats();
+    uint32_t written = after.written - before.written;
+    uint32_t dropped = after.dropped - before.dropped;
+    uint32_t expected = LOG_STRESS_PRODUCERS * LOG_STRESS_LINES;
+    printf("Log stress (%s, %u slots): %u producers, %u lines written, %u dropped, ring peak %u\n",
+           APP_LOG_ASYNC ? "async" : "sync", (unsigned)APP_LOG_RING_SLOTS,
+           LOG_STRESS_PRODUCERS, written, dropped, after.high_water);
+    if (written + dropped != expected) {
+        printf("FAILED: %u lines unaccounted for\n", expected - written - dropped);
+        return 1;
+    }
+    printf("OK: all %u lines accounted for\n", expected);
+    return 0;
+}
+
+// Replay a capture through the WebSocket, the machine's message handler and
+// a Task_LVGL stand-in draining the display events
+static int replay_capture(const char* path) {
+    json_dashboard_arena.begin();
+    json_api_arena.begin();
+
+    Preferences prefs;
+    LaMarzoccoClient client(prefs);
+    LaMarzoccoWebSocket websocket(client);
+    LaMarzoccoMachine machine(client, websocket);
+
+    std::atomic<bool> done(false);
+    std::thread display([&done]() {
+        while (!done) {
+            update_trace_apply_begin();
+            machine_events_drain();
+            update_trace_apply_end(true);
+            update_trace_flushed();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    HostAllocCount before = host_alloc_count();
+    bool replayed = websocket.replay(path, 0);
+    HostAllocCount after = host_alloc_count();
+    done = true;
+    display.join();
+    if (!replayed) {
+        return 1;
+    }
+
+    const WebSocketMetrics& ws = websocket.get_metrics();
+    printf("WebSocket: %u frames decoded (%u reassembled), %u failed, %u overflows, %u length mismatches\n",
+           ws.frames_decoded, ws.frames_reassembled, ws.decode_failures, ws.assembler_overflows,
+           ws.length_mismatches);
+    const DashboardDiffStats& diff = machine.get_dashboard_stats();
+    const DashboardParseStats& parse = machine.get_parse_stats();
+    MachineEventStats events = machine_events_get_stats();
+    printf("Dashboards: %u processed, %u skipped as identical; parse max %u us, JSON peak %u bytes\n",
+           diff.processed, diff.skipped, parse.parse_us_max, parse.json_peak_max);
+    printf("Display events: %u queued, %u applied, %u dropped; %u display updates\n",
+           events.pushed, events.applied, events.dropped, host_display_calls);
+    if (host_alloc_counting()) {
+        printf("Heap: %llu allocations, %llu bytes\n",
+               (unsigned long long)(after.calls - before.calls),
+               (unsigned long long)(after.bytes - before.bytes));
+    }
+    update_trace_print("TRACE");
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    const char* path = "output.txt";
+    bool fuzz = false;
+    uint32_t seed = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            return replay_capture(argv[i + 1]);
+        } else if (strcmp(argv[i], "--log-stress") == 0) {
+            return log_stress();
+        } else if (strcmp(argv[i], "--fuzz") == 0) {
+            fuzz = true;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoul(argv[++i], nullptr, 10);
+        } else {
+            path = argv[i];
+        }
+    }
+    size_t truncated = 0;
+    std::vector<std::string> bodies = load_bodies(path, truncated);
+    if (bodies.empty()) {
+        printf("No dashboard bodies found in %s\n", path);
+        return 1;
+    }
+    size_t body_bytes = 0;
+    std::vector<std::string> frames;
+    for (size_t i = 0; i < bodies.size(); i++) {
+        body_bytes += bodies[i].size();
+        frames.push_back(stomp_message(bodies[i], i));
+    }
+    printf("%s: %u dashboard bodies, %u bytes on average (%u truncated, skipped)\n", path,
+           (unsigned)bodies.size(), (unsigned)(body_bytes / bodies.size()), (unsigned)truncated);
+    if (fuzz) {
+        return dashboard_fuzz(bodies, seed) == 0 ? 0 : 1;
+    }
+    printf("Parser: %s\n\n",
+           DASHBOARD_PARSER == DASHBOARD_PARSER_STREAM ? "stream extractor" :
+           DASHBOARD_JSON_FILTER ? "ArduinoJson, filtered" : "ArduinoJson");
+
+    json_dashboard_arena.begin();
+    json_api_arena.begin();
+
+    Preferences prefs;
+    LaMarzoccoClient client(prefs);
+    LaMarzoccoWebSocket websocket(client);
+    if (!host_websocket_event) {
+        printf("WebSocket did not register an event handler\n");
+        return 1;
+    }
+
+    // --- STOMP codec (event handler, decoder, reassembly) ---
+    websocket.set_message_callback(count_body);
+    run("stomp_parse", "frames", frames.size(), [&]() {
+        for (std::string& frame : frames) {
+            deliver_text(frame);
+        }
+    });
+
+    run("stomp_reassembly", "frames", frames.size(), [&]() {
+        for (std::string& frame : frames) {
+            deliver_fragmented(frame);
+        }
+    });
+
+    // --- Both dashboard parsers, widgets included (the handler uses one) ---
+    DashboardWidgets json_widgets, extract_widgets;
+    WidgetRegistry json_registry, extract_registry;
+    // Same handlers as the message handler registers
+#if DASHBOARD_LOG_ALL_WIDGETS
+    json_widgets.register_all(json_registry);
+    extract_widgets.register_all(extract_registry);
+#else
+    json_widgets.register_displayed(json_registry);
+    extract_widgets.register_displayed(extract_registry);
+#endif
+    DashboardCommands commands;
+    run("parse_arduinojson", "msgs", bodies.size(), [&]() {
+        for (const std::string& body : bodies) {
+            json_dashboard_arena.reset();
+            json_registry.begin_frame();
+            g_sink += dashboard_parse_json(body.data(), body.size(), json_registry, commands);
+            json_registry.end_frame();
+        }
+    });
+
+    run("parse_extract", "msgs", bodies.size(), [&]() {
+        for (const std::string& body : bodies) {
+            extract_registry.begin_frame();
+            g_sink += dashboard_extract(body.data(), body.size(), extract_registry, commands);
+            extract_registry.end_frame();
+        }
+    });
+
+    // --- ArduinoJson with and without the handler-derived filter (deserialize only) ---
+    const JsonDocument& filter = dashboard_json_filter(json_registry);
+    run("deserialize_filtered", "msgs", bodies.size(), [&]() {
+        for (const std::string& body : bodies) {
+            json_dashboard_arena.reset();
+            JsonDocument doc(&json_dashboard_arena);
+            g_sink += (bool)deserializeJson(doc, body.data(), body.size(), DeserializationOption::Filter(filter));
+        }
+    });
+
+    run("deserialize_full", "msgs", bodies.size(), [&]() {
+        for (const std::string& body : bodies) {
+            json_dashboard_arena.reset();
+            JsonDocument doc(&json_dashboard_arena);
+            g_sink += (bool)deserializeJson(doc, body.data(), body.size());
+        }
+    });
+
+    // Arena bytes held by each body's document
+    size_t peak_sum[2] = { 0, 0 }, peak_max[2] = { 0, 0 };
+    for (const std::string& body : bodies) {
+        for (int filtered = 0; filtered < 2; filtered++) {
+            json_dashboard_arena.reset();
+            json_dashboard_arena.reset_peak();
+            JsonDocument doc(&json_dashboard_arena);
+            if (filtered) {
+                deserializeJson(doc, body.data(), body.size(), DeserializationOption::Filter(filter));
+            } else {
+                deserializeJson(doc, body.data(), body.size());
+            }
+            peak_sum[filtered] += json_dashboard_arena.peak();
+            peak_max[filtered] = std::max(peak_max[filtered], json_dashboard_arena.peak());
+        }
+    }
+    printf("%-20s filtered %u bytes average, %u max; full %u bytes average, %u max\n", "JSON document",
+           (unsigned)(peak_sum[1] / bodies.size()), (unsigned)peak_max[1],
+           (unsigned)(peak_sum[0] / bodies.size()), (unsigned)peak_max[0]);
+
+    // --- Dashboard message handler (decode included, see stomp_parse) ---
+    LaMarzoccoMachine machine(client, websocket);  // Registers its message handler
+    // One Task_LVGL iteration per message keeps the event ring from filling
+    run("dashboard_handler", "msgs", frames.size(), [&]() {
+        for (std::string& frame : frames) {
+            deliver_text(frame);
+            update_trace_apply_begin();
+            machine_events_drain();
+            update_trace_apply_end(true);
+            update_trace_flushed();
+        }
+    });
+
+    // --- Request signing ---
+    InstallationKey key;
+    if (!LaMarzoccoAuth::generate_installation_key(LaMarzoccoAuth::generate_uuid(), key)) {
+        printf("Installation key generation failed\n");
+        return 1;
+    }
+    String base_string = LaMarzoccoAuth::generate_base_string(key);
+    run("request_proof", "proofs", 1, [&]() {
+        g_sink += LaMarzoccoAuth::generate_request_proof(base_string, key.secret).length();
+    });
+
+    String installation_id, timestamp, nonce, signature;
+    LaMarzoccoAuth::generate_extra_request_headers(key, installation_id, timestamp, nonce, signature);
+    if (signature.length() == 0) {
+        printf("Request signing failed\n");
+        return 1;
+    }
+    run("request_signature", "sigs", 1, [&]() {
+        LaMarzoccoAuth::generate_extra_request_headers(key, installation_id, timestamp, nonce, signature);
+        g_sink += signature.length();
+    });
+
+    // --- Side statistics ---
+    const WebSocketMetrics& ws = websocket.get_metrics();
+    printf("\nWebSocket: %u frames decoded (%u reassembled), %u failed, %u overflows, %u length mismatches\n",
+           ws.frames_decoded, ws.frames_reassembled, ws.decode_failures, ws.assembler_overflows,
+           ws.length_mismatches);
+    const DashboardDiffStats& diff = machine.get_dashboard_stats();
+    const DashboardParseStats& parse = machine.get_parse_stats();
+    JsonArenaStats arena = json_dashboard_arena.get_stats();
+    printf("Dashboards: %u processed, %u skipped as identical; parse max %u us, JSON peak %u bytes\n",
+           diff.processed, diff.skipped, parse.parse_us_max, parse.json_peak_max);
+    printf("Dashboard arena: %u resets, %u heap fallbacks, high water %u bytes\n",
+           arena.resets, arena.fallbacks, arena.high_water);
+    printf("Display updates applied: %u\n", host_display_calls);
+    update_trace_print("TRACE");
+    return 0;
+}
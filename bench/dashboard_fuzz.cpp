@@ -0,0 +1,653 @@
+#include <Arduino.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "dashboard_fuzz.h"
+#include "config.h"
+#include "dashboard_codes.h"
+#include "dashboard_extract.h"
+#include "dashboard_json.h"
+#include "dashboard_widgets.h"
+#include "json_allocator.h"
+
+// Differential and mutation fuzzing of the dashboard parsers: the ArduinoJson
+// reader (dashboard_json.h) and the stream extractor (dashboard_extract.h).
+//
+// Valid cases are corpus bodies (plus FUZZ_EXTRA_BODY) rebuilt with changed, dropped, reordered and
+// unknown members, extra or missing widgets, random commands, whitespace and
+// escapes. Both engines must accept each one and leave every handler in the
+// same state with the same commands.
+//
+// Mutated cases are valid cases with bytes changed, inserted or cut off. Any
+// verdict is fine as long as neither engine reads outside the body; run the
+// native_asan build to catch that. Bodies sit in heap blocks of their exact
+// size, without a terminating NUL.
+//
+// Kept out of the valid cases, as the engines differ there by design:
+// \uXXXX escapes in values the handlers read (the extractor stores '?'),
+// exponents in integer fields (it keeps the integer part), escaped or
+// duplicate keys and "commands" entries that are not objects.
+//
+//   pio run -e native_asan && .pio/build/native_asan/program --fuzz [output.txt] [--seed N]
+
+#ifndef FUZZ_VALID_CASES
+#define FUZZ_VALID_CASES 5000
+#endif
+#ifndef FUZZ_MUTATED_CASES
+#define FUZZ_MUTATED_CASES 20000
+#endif
+
+// Containers below the root object. ArduinoJson refuses more than 10.
+static const int FUZZ_MAX_DEPTH = 9;
+
+typedef std::mt19937 FuzzRng;
+
+static bool chance(FuzzRng& rng, double p) {
+    return std::uniform_real_distribution<double>(0.0, 1.0)(rng) < p;
+}
+
+static size_t pick(FuzzRng& rng, size_t n) {
+    return rng() % n;
+}
+
+// JSON tree just big enough to take a body apart and put it back together
+struct FuzzValue {
+    enum Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+    Type type;
+    std::string text;  // Number literal, "true" / "false" or decoded string
+    std::vector<FuzzValue> items;
+    std::vector<std::pair<std::string, FuzzValue> > members;
+
+    explicit FuzzValue(Type t = NUL, const std::string& s = std::string()) : type(t), text(s) {}
+};
+
+// --- Reading the corpus ---
+
+struct FuzzReader {
+    const char* p;
+    const char* end;
+};
+
+static void read_space(FuzzReader& r) {
+    while (r.p < r.end && (*r.p == ' ' || *r.p == '\t' || *r.p == '\r' || *r.p == '\n')) {
+        r.p++;
+    }
+}
+
+static void append_utf8(std::string& out, unsigned cp) {
+    if (cp < 0x80) {
+        out += (char)cp;
+    } else if (cp < 0x800) {
+        out += (char)(0xC0 | (cp >> 6));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else {
+        out += (char)(0xE0 | (cp >> 12));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    }
+}
+
+static bool read_string(FuzzReader& r, std::string& out) {
+    if (r.p >= r.end || *r.p != '"') {
+        return false;
+    }
+    r.p++;
+    while (r.p < r.end && *r.p != '"') {
+        char ch = *r.p++;
+        if (ch != '\\') {
+            out += ch;
+            continue;
+        }
+        if (r.p >= r.end) {
+            return false;
+        }
+        char esc = *r.p++;
+        switch (esc) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'u': {
+                if (r.end - r.p < 4) {
+                    return false;
+                }
+                append_utf8(out, (unsigned)strtoul(std::string(r.p, 4).c_str(), nullptr, 16));
+                r.p += 4;
+                break;
+            }
+            default: out += esc; break;
+        }
+    }
+    if (r.p >= r.end) {
+        return false;
+    }
+    r.p++;
+    return true;
+}
+
+static bool read_value(FuzzReader& r, FuzzValue& out) {
+    read_space(r);
+    if (r.p >= r.end) {
+        return false;
+    }
+    char ch = *r.p;
+    if (ch == '{' || ch == '[') {
+        bool object = ch == '{';
+        out.type = object ? FuzzValue::OBJECT : FuzzValue::ARRAY;
+        r.p++;
+        read_space(r);
+        if (r.p < r.end && *r.p == (object ? '}' : ']')) {
+            r.p++;
+            return true;
+        }
+        while (true) {
+            FuzzValue item;
+            if (object) {
+                std::string key;
+                read_space(r);
+                if (!read_string(r, key)) {
+                    return false;
+                }
+                read_space(r);
+                if (r.p >= r.end || *r.p++ != ':' || !read_value(r, item)) {
+                    return false;
+                }
+                out.members.push_back(std::make_pair(key, item));
+            } else {
+                if (!read_value(r, item)) {
+                    return false;
+                }
+                out.items.push_back(item);
+            }
+            read_space(r);
+            if (r.p >= r.end) {
+                return false;
+            }
+            char next = *r.p++;
+            if (next == ',') {
+                continue;
+            }
+            return next == (object ? '}' : ']');
+        }
+    }
+    if (ch == '"') {
+        out.type = FuzzValue::STRING;
+        return read_string(r, out.text);
+    }
+    const char* start = r.p;
+    while (r.p < r.end && strchr("+-.0123456789eEtruefalsn", *r.p)) {
+        r.p++;
+    }
+    out.text.assign(start, r.p - start);
+    if (out.text == "null") {
+        out.type = FuzzValue::NUL;
+    } else if (out.text == "true" || out.text == "false") {
+        out.type = FuzzValue::BOOL;
+    } else {
+        out.type = FuzzValue::NUMBER;
+    }
+    return !out.text.empty();
+}
+
+// --- Writing a case ---
+
+static void write_space(std::string& out, FuzzRng& rng) {
+    static const char* const SPACE[] = { "", "", "", "", " ", "  ", "\n", "\t", "\r\n  " };
+    out += SPACE[pick(rng, sizeof(SPACE) / sizeof(SPACE[0]))];
+}
+
+// `skipped`: no handler reads the value, so \uXXXX escapes are fair game
+static void write_string(std::string& out, const std::string& s, FuzzRng& rng, bool skipped) {
+    out += '"';
+    for (char ch : s) {
+        switch (ch) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            case '\r': out += "\\r"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '/': out += chance(rng, 0.5) ? "\\/" : "/"; break;
+            default:
+                if ((unsigned char)ch < 0x20 || (skipped && (unsigned char)ch < 0x80 && chance(rng, 0.1))) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)ch);
+                    out += escaped;
+                } else {
+                    out += ch;
+                }
+                break;
+        }
+    }
+    out += '"';
+}
+
+static bool is_unknown_key(const std::string& key) {
+    return key.compare(0, 2, "x-") == 0;
+}
+
+static void write_value(std::string& out, const FuzzValue& value, FuzzRng& rng, bool skipped) {
+    switch (value.type) {
+        case FuzzValue::NUL:
+            out += "null";
+            break;
+        case FuzzValue::BOOL:
+        case FuzzValue::NUMBER:
+            out += value.text;
+            break;
+        case FuzzValue::STRING:
+            write_string(out, value.text, rng, skipped);
+            break;
+        case FuzzValue::ARRAY:
+            out += '[';
+            for (size_t i = 0; i < value.items.size(); i++) {
+                write_space(out, rng);
+                write_value(out, value.items[i], rng, skipped);
+                write_space(out, rng);
+                if (i + 1 < value.items.size()) {
+                    out += ',';
+                }
+            }
+            out += ']';
+            break;
+        case FuzzValue::OBJECT:
+            out += '{';
+            for (size_t i = 0; i < value.members.size(); i++) {
+                const std::string& key = value.members[i].first;
+                write_space(out, rng);
+                out += '"';
+                out += key;
+                out += '"';
+                write_space(out, rng);
+                out += ':';
+                write_space(out, rng);
+                write_value(out, value.members[i].second, rng, skipped || is_unknown_key(key));
+                write_space(out, rng);
+                if (i + 1 < value.members.size()) {
+                    out += ',';
+                }
+            }
+            out += '}';
+            break;
+    }
+}
+
+// --- Mutating the tree ---
+
+static const char* const FUZZ_STRINGS[] = {
+    "Ready", "HeatingUp", "Off", "StandBy", "Brewing", "PoweredOn", "BrewingMode",
+    "NoWater", "Level1", "Level3", "Enabled", "", "quote\" back\\slash /", "tab\tnew\nline",
+    "Caf\xc3\xa9 Gr\xc3\xb6\xc3\x9f" "e", "A status longer than the twenty bytes kept",
+};
+
+static const char* const FUZZ_NUMBERS[] = {
+    "0", "-0", "1", "-1", "3", "94", "94.5", "93.55", "-0.25", "0.001", "123.000",
+    "1762927151195", "-1762927151195", "9007199254740991",
+};
+
+// Exponents only appear where no handler reads them
+static const char* const FUZZ_SKIPPED_NUMBERS[] = {
+    "1e3", "-2.5E-7", "6.02e+23", "0e0", "1E400", "-1e-400",
+};
+
+static const char* const FUZZ_STATUSES[] = {
+    "Pending", "InProgress", "Success", "Error", "Timeout", "", "An unexpectedly long status",
+};
+
+// A value a handler might read
+static FuzzValue random_value(FuzzRng& rng) {
+    size_t kind = pick(rng, 20);
+    if (kind < 8) {
+        return FuzzValue(FuzzValue::STRING, FUZZ_STRINGS[pick(rng, sizeof(FUZZ_STRINGS) / sizeof(FUZZ_STRINGS[0]))]);
+    }
+    if (kind < 15) {
+        return FuzzValue(FuzzValue::NUMBER, FUZZ_NUMBERS[pick(rng, sizeof(FUZZ_NUMBERS) / sizeof(FUZZ_NUMBERS[0]))]);
+    }
+    if (kind < 17) {
+        return FuzzValue(FuzzValue::BOOL, chance(rng, 0.5) ? "true" : "false");
+    }
+    if (kind < 18) {
+        return FuzzValue(FuzzValue::NUL);
+    }
+    return FuzzValue(kind == 18 ? FuzzValue::OBJECT : FuzzValue::ARRAY);
+}
+
+// A value no handler reads, at most `levels` containers deep
+static FuzzValue random_unknown(FuzzRng& rng, int levels) {
+    size_t kind = pick(rng, levels > 0 ? 6 : 4);
+    switch (kind) {
+        case 0:
+            return FuzzValue(FuzzValue::NUMBER, FUZZ_SKIPPED_NUMBERS[pick(rng, sizeof(FUZZ_SKIPPED_NUMBERS) /
+                                                                                sizeof(FUZZ_SKIPPED_NUMBERS[0]))]);
+        case 1:
+        case 2:
+        case 3:
+            return random_value(rng);
+        case 4: {
+            FuzzValue array(FuzzValue::ARRAY);
+            for (size_t i = pick(rng, 4); i > 0; i--) {
+                array.items.push_back(random_unknown(rng, levels - 1));
+            }
+            return array;
+        }
+        default: {
+            FuzzValue object(FuzzValue::OBJECT);
+            for (size_t i = pick(rng, 4); i > 0; i--) {
+                object.members.push_back(std::make_pair("k" + std::to_string(i), random_unknown(rng, levels - 1)));
+            }
+            return object;
+        }
+    }
+}
+
+// Change, drop, add and reorder members; `depth` counts the containers around `object`
+static void mutate_members(FuzzValue& object, FuzzRng& rng, int depth, int& serial) {
+    for (size_t i = object.members.size(); i-- > 0;) {
+        FuzzValue& value = object.members[i].second;
+        if (chance(rng, 0.05)) {
+            object.members.erase(object.members.begin() + i);
+        } else if (value.type == FuzzValue::OBJECT) {
+            mutate_members(value, rng, depth + 1, serial);
+        } else if (value.type == FuzzValue::ARRAY) {
+            for (FuzzValue& item : value.items) {
+                if (item.type == FuzzValue::OBJECT) {
+                    mutate_members(item, rng, depth + 2, serial);
+                }
+            }
+        } else if (chance(rng, 0.15)) {
+            value = random_value(rng);
+        }
+    }
+    if (chance(rng, 0.2)) {
+        size_t at = pick(rng, object.members.size() + 1);
+        object.members.insert(object.members.begin() + at,
+                              std::make_pair("x-" + std::to_string(serial++),
+                                             random_unknown(rng, FUZZ_MAX_DEPTH - depth - 1)));
+    }
+    if (chance(rng, 0.3)) {
+        std::shuffle(object.members.begin(), object.members.end(), rng);
+    }
+}
+
+static FuzzValue* find_member(FuzzValue& object, const char* key) {
+    for (size_t i = 0; i < object.members.size(); i++) {
+        if (object.members[i].first == key) {
+            return &object.members[i].second;
+        }
+    }
+    return nullptr;
+}
+
+static FuzzValue random_commands(FuzzRng& rng) {
+    FuzzValue commands(FuzzValue::ARRAY);
+    for (size_t n = pick(rng, 7); n > 0; n--) {
+        FuzzValue command(FuzzValue::OBJECT);
+        std::string id;
+        for (size_t len = 1 + pick(rng, 50); len > 0; len--) {
+            id += "0123456789abcdef-"[pick(rng, 17)];
+        }
+        command.members.push_back(std::make_pair("id", FuzzValue(FuzzValue::STRING, id)));
+        command.members.push_back(std::make_pair(
+            "status", chance(rng, 0.9) ? FuzzValue(FuzzValue::STRING,
+                                                   FUZZ_STATUSES[pick(rng, sizeof(FUZZ_STATUSES) /
+                                                                               sizeof(FUZZ_STATUSES[0]))])
+                                       : random_value(rng)));
+        if (chance(rng, 0.3)) {
+            command.members.push_back(std::make_pair("x-args", random_unknown(rng, 3)));
+        }
+        std::shuffle(command.members.begin(), command.members.end(), rng);
+        commands.items.push_back(command);
+    }
+    return commands;
+}
+
+static std::string valid_case(const std::vector<FuzzValue>& corpus, FuzzRng& rng) {
+    FuzzValue root = corpus[pick(rng, corpus.size())];
+    int serial = 0;
+    FuzzValue* widgets = find_member(root, "widgets");
+    if (widgets && widgets->type == FuzzValue::ARRAY) {
+        std::vector<FuzzValue>& items = widgets->items;
+        for (FuzzValue& widget : items) {
+            if (widget.type == FuzzValue::OBJECT) {
+                mutate_members(widget, rng, 3, serial);
+            }
+        }
+        if (!items.empty() && chance(rng, 0.1)) {
+            items.erase(items.begin() + pick(rng, items.size()));
+        }
+        if (!items.empty() && chance(rng, 0.1)) {
+            items.push_back(items[pick(rng, items.size())]);  // Same code twice
+        }
+        if (chance(rng, 0.05)) {
+            items.insert(items.begin() + pick(rng, items.size() + 1), random_value(rng));
+        }
+        std::shuffle(items.begin(), items.end(), rng);
+    }
+    FuzzValue* commands = find_member(root, "commands");
+    if (commands && chance(rng, 0.8)) {
+        *commands = random_commands(rng);
+    }
+    for (size_t i = root.members.size(); i-- > 0;) {
+        if (chance(rng, 0.03)) {
+            root.members.erase(root.members.begin() + i);
+        }
+    }
+    if (chance(rng, 0.3)) {
+        root.members.push_back(std::make_pair("x-" + std::to_string(serial++),
+                                              random_unknown(rng, FUZZ_MAX_DEPTH - 1)));
+    }
+    std::shuffle(root.members.begin(), root.members.end(), rng);
+
+    std::string out;
+    write_space(out, rng);
+    write_value(out, root, rng, false);
+    write_space(out, rng);
+    return out;
+}
+
+static std::string mutated_case(const std::string& valid, FuzzRng& rng) {
+    static const char* const INSERTS[] = {
+        "[[[[[[[[[[[[", "{\"a\":", "\"", "\\", "\\u12", "1e999999", "-", "}", "]", ",", ":", "\"widgets\":[",
+    };
+    std::string s = valid;
+    for (size_t edits = 1 + pick(rng, 8); edits > 0 && !s.empty(); edits--) {
+        size_t at = pick(rng, s.size());
+        size_t op = pick(rng, 10);
+        if (op < 4) {
+            s[at] = "{}[]\",:\\-0123456789etnul \x00"[pick(rng, 26)];
+        } else if (op < 7) {
+            s.erase(at, 1 + pick(rng, 50));
+        } else {
+            s.insert(at, INSERTS[pick(rng, sizeof(INSERTS) / sizeof(INSERTS[0]))]);
+        }
+    }
+    if (chance(rng, 0.3)) {
+        s.resize(pick(rng, s.size() + 1));
+    }
+    return s;
+}
+
+// Widgets the corpus logs only list under removedWidgets, with outputs shaped
+// like the cloud's. CMGroupDoses keeps "doses" whole while
+// CMBrewByWeightDoses asks for paths inside its own "doses", which is what
+// the merged ArduinoJson filter has to get right.
+static const char FUZZ_EXTRA_BODY[] =
+    "{\"connected\":true,\"removedWidgets\":[],\"widgets\":["
+    "{\"code\":\"CMMachineStatus\",\"index\":1,\"output\":{\"status\":\"PoweredOn\",\"mode\":\"BrewingMode\","
+    "\"brewingStartTime\":null}},"
+    "{\"code\":\"CMSteamBoilerTemperature\",\"index\":1,\"output\":{\"status\":\"HeatingUp\",\"enabled\":true,"
+    "\"targetTemperature\":123.5,\"targetTemperatureMin\":95,\"readyStartTime\":1761071774016}},"
+    "{\"code\":\"CMPreBrewing\",\"index\":1,\"output\":{\"availableModes\":[\"PreBrewing\",\"Disabled\"],"
+    "\"mode\":\"PreBrewing\",\"times\":{\"PreBrewing\":[{\"doseIndex\":\"ByGroup\","
+    "\"seconds\":{\"Out\":3.5,\"In\":2},\"secondsMin\":{\"Out\":1,\"In\":1}}]}}},"
+    "{\"code\":\"CMBackFlush\",\"index\":1,\"output\":{\"lastCleaningStartTime\":1761071774016,\"status\":\"Off\"}},"
+    "{\"code\":\"CMGroupDoses\",\"index\":1,\"output\":{\"mode\":\"PulsesType\",\"doses\":{\"PulsesType\":"
+    "[{\"doseIndex\":\"DoseA\",\"dose\":126.5,\"doseMin\":0},{\"doseIndex\":\"DoseB\",\"dose\":150}]}}},"
+    "{\"code\":\"CMBrewByWeightDoses\",\"index\":1,\"output\":{\"scaleConnected\":true,\"mode\":\"Dose1\","
+    "\"doses\":{\"Dose1\":{\"dose\":32.5,\"doseMin\":5},\"Dose2\":{\"dose\":36}}}},"
+    "{\"code\":\"GMachineStatus\",\"index\":1,\"output\":{\"status\":\"StandBy\",\"mode\":\"Auto\",\"enabled\":true}}"
+    "],\"commands\":[]}";
+
+// --- Running the engines ---
+
+struct FuzzEngine {
+    DashboardWidgets widgets;
+    WidgetRegistry registry;
+    DashboardCommands commands;
+
+    FuzzEngine() : commands() { widgets.register_all(registry); }
+};
+
+static bool parse_case(FuzzEngine& engine, bool arduinojson, const std::string& body) {
+    // Exact-size copy without a NUL, so a read past the end is out of bounds
+    std::unique_ptr<char[]> copy(new char[body.empty() ? 1 : body.size()]);
+    char* json = copy.get();
+    memcpy(json, body.data(), body.size());
+    engine.registry.begin_frame();
+    bool parsed;
+    if (arduinojson) {
+        json_dashboard_arena.reset();
+        parsed = dashboard_parse_json(json, body.size(), engine.registry, engine.commands);
+    } else {
+        parsed = dashboard_extract(json, body.size(), engine.registry, engine.commands);
+    }
+    engine.registry.end_frame();
+    return parsed;
+}
+
+template <typename Widget>
+static bool same_widget(const Widget& a, const Widget& b) {
+    return a.present() == b.present() && memcmp(&a.state(), &b.state(), sizeof(a.state())) == 0;
+}
+
+// What differs between the engines' results, nullptr if nothing
+static const char* first_difference(const FuzzEngine& a, const FuzzEngine& b) {
+    const DashboardWidgets& x = a.widgets;
+    const DashboardWidgets& y = b.widgets;
+    if (!same_widget(x.machine, y.machine)) return dashboard_widget_name(WIDGET_MACHINE_STATUS);
+    if (!same_widget(x.coffee, y.coffee)) return dashboard_widget_name(WIDGET_COFFEE_BOILER);
+    if (!same_widget(x.steam, y.steam)) return dashboard_widget_name(WIDGET_STEAM_BOILER_LEVEL);
+    if (!same_widget(x.no_water, y.no_water)) return dashboard_widget_name(WIDGET_NO_WATER);
+    if (!same_widget(x.steam_temperature, y.steam_temperature)) {
+        return dashboard_widget_name(WIDGET_STEAM_BOILER_TEMPERATURE);
+    }
+    if (!same_widget(x.pre_brewing, y.pre_brewing)) return dashboard_widget_name(WIDGET_PRE_BREWING);
+    if (!same_widget(x.back_flush, y.back_flush)) return dashboard_widget_name(WIDGET_BACK_FLUSH);
+    if (!same_widget(x.group_doses, y.group_doses)) return dashboard_widget_name(WIDGET_GROUP_DOSES);
+    if (!same_widget(x.brew_by_weight, y.brew_by_weight)) {
+        return dashboard_widget_name(WIDGET_BREW_BY_WEIGHT_DOSES);
+    }
+    for (int code = WIDGET_GRINDER_FIRST; code <= WIDGET_GRINDER_LAST; code++) {
+        if (memcmp(&x.grinders.state((DashboardWidgetCode)code), &y.grinders.state((DashboardWidgetCode)code),
+                   sizeof(GrinderWidgetState)) != 0) {
+            return dashboard_widget_name((DashboardWidgetCode)code);
+        }
+    }
+    if (a.commands.count != b.commands.count) {
+        return "commands";
+    }
+    for (size_t i = 0; i < a.commands.count; i++) {
+        if (strcmp(a.commands.items[i].id, b.commands.items[i].id) != 0 ||
+            strcmp(a.commands.items[i].status, b.commands.items[i].status) != 0) {
+            return "commands";
+        }
+    }
+    return nullptr;
+}
+
+// FUZZ_EXTRA_BODY as is: both engines read it, agree and find every dose
+static size_t check_extra_body() {
+    std::unique_ptr<FuzzEngine> json(new FuzzEngine());
+    std::unique_ptr<FuzzEngine> extract(new FuzzEngine());
+    std::string body(FUZZ_EXTRA_BODY);
+    if (!parse_case(*json, true, body) || !parse_case(*extract, false, body)) {
+        printf("Fuzz: extra widgets body rejected\n");
+        return 1;
+    }
+    const char* difference = first_difference(*json, *extract);
+    if (difference) {
+        printf("Fuzz mismatch (%s) on the extra widgets body\n", difference);
+        return 1;
+    }
+    const DashboardWidgets& w = json->widgets;
+    if (w.group_doses.state().dose != 126.5f || w.brew_by_weight.state().dose1 != 32.5f ||
+        w.brew_by_weight.state().dose2 != 36.0f || w.pre_brewing.state().seconds_out != 3.5f ||
+        w.steam_temperature.state().target_temperature != 123.5f) {
+        printf("Fuzz: extra widgets read wrong (group dose %.1f, doses %.1f / %.1f, pre-brewing out %.1f, "
+               "steam %.1f)\n", w.group_doses.state().dose, w.brew_by_weight.state().dose1,
+               w.brew_by_weight.state().dose2, w.pre_brewing.state().seconds_out,
+               w.steam_temperature.state().target_temperature);
+        return 1;
+    }
+    return 0;
+}
+
+size_t dashboard_fuzz(const std::vector<std::string>& bodies, uint32_t seed) {
+    json_dashboard_arena.begin();
+    size_t mismatches = check_extra_body();
+
+    std::vector<FuzzValue> corpus;
+    std::vector<std::string> all_bodies(bodies);
+    all_bodies.push_back(FUZZ_EXTRA_BODY);
+    for (const std::string& body : all_bodies) {
+        FuzzReader reader = { body.data(), body.data() + body.size() };
+        FuzzValue root;
+        if (read_value(reader, root) && root.type == FuzzValue::OBJECT) {
+            corpus.push_back(root);
+        }
+    }
+    if (corpus.empty()) {
+        printf("Fuzz: no usable corpus bodies\n");
+        return 1;
+    }
+    FuzzRng rng(seed);
+
+    // Valid cases: same verdict, same handler states and commands
+    std::unique_ptr<FuzzEngine> json(new FuzzEngine());
+    std::unique_ptr<FuzzEngine> extract(new FuzzEngine());
+    std::vector<std::string> cases;
+    for (int n = 0; n < FUZZ_VALID_CASES; n++) {
+        std::string body = valid_case(corpus, rng);
+        bool json_ok = parse_case(*json, true, body);
+        bool extract_ok = parse_case(*extract, false, body);
+        const char* difference = json_ok && extract_ok ? first_difference(*json, *extract)
+                                                       : (json_ok ? "extractor rejected it" : "ArduinoJson rejected it");
+        if (difference) {
+            if (mismatches++ < 3) {
+                printf("Fuzz mismatch (%s) on: %.400s\n", difference, body.c_str());
+            }
+            // Start both over from the same (empty) state
+            json.reset(new FuzzEngine());
+            extract.reset(new FuzzEngine());
+        }
+        cases.push_back(body);
+    }
+
+    // Mutated cases: anything but a crash goes; verdicts are counted
+    uint32_t both = 0, neither = 0, json_only = 0, extract_only = 0;
+    for (int n = 0; n < FUZZ_MUTATED_CASES; n++) {
+        std::string body = mutated_case(cases[pick(rng, cases.size())], rng);
+        bool json_ok = parse_case(*json, true, body);
+        bool extract_ok = parse_case(*extract, false, body);
+        if (json_ok && extract_ok) {
+            both++;
+        } else if (json_ok) {
+            json_only++;
+        } else if (extract_ok) {
+            extract_only++;
+        } else {
+            neither++;
+        }
+    }
+
+    printf("Fuzz (seed %u): %d valid cases, %u mismatches\n", (unsigned)seed, FUZZ_VALID_CASES, (unsigned)mismatches);
+    printf("Fuzz: %d mutated cases, accepted by both %u, by neither %u, by ArduinoJson only %u, "
+           "by the extractor only %u\n",
+           FUZZ_MUTATED_CASES, both, neither, json_only, extract_only);
+    return mismatches;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * Differential and mutation fuzzing of the two dashboard parsers on
+ * variations of `bodies` (see dashboard_fuzz.cpp)
+ *
+ * @return number of valid cases on which the parsers disagreed
+ */
+size_t dashboard_fuzz(const std::vector<std::string>& bodies, uint32_t seed);
@@ -0,0 +1,53 @@
+#include "host_seams.h"
+#include <atomic>
+#include <stdlib.h>
+
+// Count every heap request by wrapping glibc's allocator. operator new and
+// mbedTLS both end up here. Not under AddressSanitizer or ThreadSanitizer,
+// which have to see every block themselves.
+
+static std::atomic<uint64_t> g_calls(0);
+static std::atomic<uint64_t> g_bytes(0);
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+static void count_request(size_t bytes) {
+    g_calls.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void* malloc(size_t size) {
+    count_request(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    count_request(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    count_request(size);
+    return __libc_realloc(ptr, size);
+}
+}
+
+bool host_alloc_counting() {
+    return true;
+}
+#else
+bool host_alloc_counting() {
+    return false;
+}
+#endif
+
+HostAllocCount host_alloc_count() {
+    HostAllocCount count;
+    count.calls = g_calls.load(std::memory_order_relaxed);
+    count.bytes = g_bytes.load(std::memory_order_relaxed);
+    return count;
+}
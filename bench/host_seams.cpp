@@ -0,0 +1,34 @@
+#include "host_seams.h"
+#include "boiler_display.h"
+#include "brewing_display.h"
+#include "water_alarm.h"
+#include <WebSocketsClient.h>
+
+// Stand-ins for the display code that is not built for the host. The client,
+// WebSocket and machine are the real ones over the transport shims; the
+// benchmark feeds WebSocket events through host_websocket_event.
+
+WebSocketClientEvent host_websocket_event = nullptr;
+uint32_t host_websocket_sent = 0;
+uint32_t host_display_calls = 0;
+
+void boiler_display_update(BoilerType type, MachineStatus machine_status,
+                           BoilerStatus boiler_status, int64_t ready_start_time) {
+    (void)type; (void)machine_status; (void)boiler_status; (void)ready_start_time;
+    host_display_calls++;
+}
+
+void boiler_display_set_target(BoilerType type, const char* target_value) {
+    (void)type; (void)target_value;
+    host_display_calls++;
+}
+
+void brewing_display_update(bool is_brewing, int64_t brewing_start_time) {
+    (void)is_brewing; (void)brewing_start_time;
+    host_display_calls++;
+}
+
+void water_alarm_set(bool alarm_active) {
+    (void)alarm_active;
+    host_display_calls++;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Display updates applied by machine_events_drain()
+extern uint32_t host_display_calls;
+
+struct HostAllocCount {
+    uint64_t calls;   // malloc / calloc / realloc
+    uint64_t bytes;   // Bytes requested by those calls
+};
+
+// Heap activity since start (glibc only; always zero elsewhere)
+HostAllocCount host_alloc_count();
+bool host_alloc_counting();
@@ -0,0 +1,47 @@
+#pragma once
+
+// Host stand-in for the parts of the Arduino core the benchmarked modules
+// use. Timing comes from the monotonic clock; Serial writes to stdout.
+
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "WString.h"
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+class HardwareSerial {
+public:
+    void begin(unsigned long) {}
+    int printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+    size_t print(const char* text) { return fputs(text, stdout) < 0 ? 0 : strlen(text); }
+    size_t print(const String& text) { return print(text.c_str()); }
+    size_t print(char c) { return putchar(c) == EOF ? 0 : 1; }
+    size_t print(long value) { return ::printf("%ld", value); }
+    size_t print(unsigned long value) { return ::printf("%lu", value); }
+    size_t print(int value) { return print((long)value); }
+    size_t print(unsigned int value) { return print((unsigned long)value); }
+    size_t print(double value) { return ::printf("%.2f", value); }
+    size_t write(const uint8_t* data, size_t length) { return fwrite(data, 1, length, stdout); }
+    template <typename T>
+    size_t println(const T& value) { size_t n = print(value); return n + println(); }
+    size_t println() { return print('\n'); }
+    void flush() { fflush(stdout); }
+};
+
+extern HardwareSerial Serial;
+
+// Plenty of heap: the transport's low-memory checks never trigger
+class EspClass {
+public:
+    uint32_t getFreeHeap() { return 256 * 1024; }
+};
+
+extern EspClass ESP;
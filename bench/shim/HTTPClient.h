@@ -0,0 +1,22 @@
+#pragma once
+
+// No network on the host: every request fails to connect
+
+#include <Arduino.h>
+#include "WiFiClientSecure.h"
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+class HTTPClient {
+public:
+    void setReuse(bool reuse) { (void)reuse; }
+    bool begin(WiFiClientSecure& client, const String& url) { (void)client; (void)url; return true; }
+    void addHeader(const String& name, const String& value) { (void)name; (void)value; }
+    int sendRequest(const char* method, const String& body) {
+        (void)method; (void)body;
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+    String getString() { return String(); }
+    void end() {}
+};
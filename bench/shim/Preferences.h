@@ -0,0 +1,81 @@
+#pragma once
+
+// In-memory NVS: every namespace lives for the lifetime of the process
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+class Preferences {
+public:
+    bool begin(const char* name, bool read_only = false) {
+        _ns = &store()[name];
+        _read_only = read_only;
+        return true;
+    }
+    void end() { _ns = nullptr; }
+    bool clear() { if (!_writable()) return false; _ns->clear(); return true; }
+    bool remove(const char* key) { return _writable() && _ns->erase(key) > 0; }
+    bool isKey(const char* key) const { return _ns && _ns->count(key) > 0; }
+
+    size_t putBytes(const char* key, const void* value, size_t len) {
+        if (!_writable()) return 0;
+        const uint8_t* bytes = (const uint8_t*)value;
+        (*_ns)[key].assign(bytes, bytes + len);
+        return len;
+    }
+    size_t getBytesLength(const char* key) const {
+        const std::vector<uint8_t>* value = _get(key);
+        return value ? value->size() : 0;
+    }
+    size_t getBytes(const char* key, void* buf, size_t max_len) const {
+        const std::vector<uint8_t>* value = _get(key);
+        if (!value || value->size() > max_len) return 0;
+        memcpy(buf, value->data(), value->size());
+        return value->size();
+    }
+
+    size_t putString(const char* key, const String& value) { return putBytes(key, value.c_str(), value.length() + 1); }
+    String getString(const char* key, const String& default_value = String()) const {
+        const std::vector<uint8_t>* value = _get(key);
+        return value && !value->empty() ? String((const char*)value->data()) : default_value;
+    }
+
+    size_t putUInt(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+    uint32_t getUInt(const char* key, uint32_t default_value = 0) const { return _get_pod(key, default_value); }
+    size_t putULong(const char* key, uint32_t value) { return putUInt(key, value); }
+    uint32_t getULong(const char* key, uint32_t default_value = 0) const { return getUInt(key, default_value); }
+    size_t putULong64(const char* key, uint64_t value) { return putBytes(key, &value, sizeof(value)); }
+    uint64_t getULong64(const char* key, uint64_t default_value = 0) const { return _get_pod(key, default_value); }
+    size_t putBool(const char* key, bool value) { uint8_t v = value; return putBytes(key, &v, 1); }
+    bool getBool(const char* key, bool default_value = false) const { return _get_pod<uint8_t>(key, default_value) != 0; }
+
+private:
+    typedef std::map<std::string, std::vector<uint8_t>> Namespace;
+
+    Namespace* _ns = nullptr;
+    bool _read_only = false;
+
+    static std::map<std::string, Namespace>& store() {
+        static std::map<std::string, Namespace> namespaces;
+        return namespaces;
+    }
+
+    bool _writable() const { return _ns && !_read_only; }
+
+    const std::vector<uint8_t>* _get(const char* key) const {
+        if (!_ns) return nullptr;
+        Namespace::const_iterator it = _ns->find(key);
+        return it == _ns->end() ? nullptr : &it->second;
+    }
+
+    template <typename T>
+    T _get_pod(const char* key, T default_value) const {
+        const std::vector<uint8_t>* value = _get(key);
+        if (!value || value->size() != sizeof(T)) return default_value;
+        T out;
+        memcpy(&out, value->data(), sizeof(T));
+        return out;
+    }
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+// Arduino String over std::string. Same interface for the calls the
+// benchmarked modules make; allocation behaviour follows libstdc++ (small
+// strings stay inline), so per-operation byte counts are an estimate of the
+// device's WString.
+
+#include <stdlib.h>
+#include <string>
+
+class String {
+public:
+    String(const char* text = "") : _s(text ? text : "") {}
+    String(const std::string& text) : _s(text) {}
+    explicit String(char c) : _s(1, c) {}
+    String(int value, unsigned char base = 10) : String((long)value, base) {}
+    String(unsigned int value, unsigned char base = 10) : String((unsigned long)value, base) {}
+    String(long value, unsigned char base = 10) {
+        char buf[34];
+        if (base == 10) {
+            snprintf(buf, sizeof(buf), "%ld", value);
+            _s = buf;
+        } else {
+            _s = value < 0 ? "-" + String((unsigned long)-value, base)._s
+                           : String((unsigned long)value, base)._s;
+        }
+    }
+    String(unsigned long value, unsigned char base = 10) {
+        char buf[66];
+        char* p = buf + sizeof(buf) - 1;
+        *p = '\0';
+        do {
+            unsigned digit = value % base;
+            *--p = digit < 10 ? '0' + digit : 'a' + digit - 10;
+            value /= base;
+        } while (value);
+        _s = p;
+    }
+
+    bool reserve(unsigned int size) { _s.reserve(size); return true; }
+    unsigned int length() const { return _s.length(); }
+    bool isEmpty() const { return _s.empty(); }
+    const char* c_str() const { return _s.c_str(); }
+
+    String& operator+=(const String& rhs) { _s += rhs._s; return *this; }
+    String& operator+=(const char* rhs) { _s += rhs ? rhs : ""; return *this; }
+    String& operator+=(char rhs) { _s += rhs; return *this; }
+    String& operator+=(int rhs) { return *this += String(rhs); }
+    String& operator+=(unsigned long rhs) { return *this += String(rhs); }
+    bool concat(const String& rhs) { _s += rhs._s; return true; }
+    bool concat(const char* rhs) { *this += rhs; return true; }
+    bool concat(char rhs) { _s += rhs; return true; }
+
+    bool operator==(const String& rhs) const { return _s == rhs._s; }
+    bool operator==(const char* rhs) const { return _s == (rhs ? rhs : ""); }
+    bool operator!=(const String& rhs) const { return _s != rhs._s; }
+    bool operator!=(const char* rhs) const { return !(*this == rhs); }
+    char operator[](unsigned int index) const { return index < _s.length() ? _s[index] : '\0'; }
+    char charAt(unsigned int index) const { return (*this)[index]; }
+
+    bool startsWith(const String& prefix) const { return _s.compare(0, prefix._s.length(), prefix._s) == 0; }
+    bool endsWith(const String& suffix) const {
+        return _s.length() >= suffix._s.length() &&
+               _s.compare(_s.length() - suffix._s.length(), std::string::npos, suffix._s) == 0;
+    }
+    int indexOf(char c, unsigned int from = 0) const { return _found(_s.find(c, from)); }
+    int indexOf(const String& text, unsigned int from = 0) const { return _found(_s.find(text._s, from)); }
+    int lastIndexOf(char c) const { return _found(_s.rfind(c)); }
+    String substring(unsigned int from) const { return from < _s.length() ? String(_s.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) std::swap(from, to);
+        return from < _s.length() ? String(_s.substr(from, to - from)) : String();
+    }
+    void trim() {
+        size_t begin = _s.find_first_not_of(" \t\r\n");
+        size_t end = _s.find_last_not_of(" \t\r\n");
+        _s = begin == std::string::npos ? std::string() : _s.substr(begin, end - begin + 1);
+    }
+    long toInt() const { return strtol(_s.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(_s.c_str(), nullptr); }
+
+    friend String operator+(const String& lhs, const String& rhs) { String s(lhs); s += rhs; return s; }
+    friend String operator+(const String& lhs, const char* rhs) { String s(lhs); s += rhs; return s; }
+    friend String operator+(const char* lhs, const String& rhs) { String s(lhs); s += rhs; return s; }
+    friend String operator+(const String& lhs, char rhs) { String s(lhs); s += rhs; return s; }
+
+private:
+    std::string _s;
+
+    static int _found(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+};
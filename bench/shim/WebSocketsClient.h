@@ -0,0 +1,42 @@
+#pragma once
+
+// No socket on the host. onEvent() hands the handler to the bench
+// (host_websocket_event), which feeds events through the real
+// LaMarzoccoWebSocket; what it sends is counted and dropped.
+
+#include <Arduino.h>
+
+enum WStype_t {
+    WStype_ERROR,
+    WStype_DISCONNECTED,
+    WStype_CONNECTED,
+    WStype_TEXT,
+    WStype_BIN,
+    WStype_FRAGMENT_TEXT_START,
+    WStype_FRAGMENT_BIN_START,
+    WStype_FRAGMENT,
+    WStype_FRAGMENT_FIN,
+    WStype_PING,
+    WStype_PONG,
+};
+
+typedef void (*WebSocketClientEvent)(WStype_t type, uint8_t* payload, size_t length);
+
+// Handler of the most recently created client's owner
+extern WebSocketClientEvent host_websocket_event;
+// Text frames the code under test sent
+extern uint32_t host_websocket_sent;
+
+class WebSocketsClient {
+public:
+    void onEvent(WebSocketClientEvent event) { host_websocket_event = event; }
+    void setReconnectInterval(unsigned long ms) { (void)ms; }
+    void setExtraHeaders(const char* headers) { (void)headers; }
+    void beginSSL(const char* host, uint16_t port, const char* url) { (void)host; (void)port; (void)url; }
+    void enableHeartbeat(uint32_t ping_ms, uint32_t pong_timeout_ms, uint8_t disconnect_after) {
+        (void)ping_ms; (void)pong_timeout_ms; (void)disconnect_after;
+    }
+    bool sendTXT(String& payload) { (void)payload; host_websocket_sent++; return true; }
+    void disconnect() {}
+    void loop() {}
+};
@@ -0,0 +1,3 @@
+#pragma once
+
+// Included by lamarzocco_auth.cpp; nothing in the benchmarked code uses it
@@ -0,0 +1,9 @@
+#pragma once
+
+// No network on the host: never connected
+class WiFiClientSecure {
+public:
+    void setInsecure() {}
+    bool connected() { return false; }
+    void stop() {}
+};
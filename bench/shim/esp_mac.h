@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdint.h>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+
+// Fixed MAC: storage keys are only derived, never compared with a device's
+esp_err_t esp_efuse_mac_get_default(uint8_t* mac);
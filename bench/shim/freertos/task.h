@@ -0,0 +1,22 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+typedef struct HostTask* TaskHandle_t;
+
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+
+// Runs `task` on a detached std::thread; stack size, priority and core are ignored
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stack_depth,
+                                   void* parameters, UBaseType_t priority,
+                                   TaskHandle_t* handle, BaseType_t core);
+
+// Threads cannot be stopped from outside: the task keeps running until the
+// process exits, only its notifications are dropped
+void vTaskDelete(TaskHandle_t task);
+
+// Direct-to-task notification used as a counting semaphore
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
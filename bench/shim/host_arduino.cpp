@@ -0,0 +1,158 @@
+#include <Arduino.h>
+#include <esp_random.h>
+#include <esp_mac.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <chrono>
+#include <condition_variable>
+#include <random>
+#include <thread>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+static const std::chrono::steady_clock::time_point g_boot = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - g_boot).count();
+}
+
+unsigned long micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - g_boot).count();
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+int HardwareSerial::printf(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int written = vprintf(fmt, args);
+    va_end(args);
+    return written;
+}
+
+uint32_t esp_random(void) {
+    static std::mt19937 rng(std::random_device{}());
+    return rng();
+}
+
+void esp_fill_random(void* buf, size_t len) {
+    uint8_t* out = (uint8_t*)buf;
+    while (len) {
+        uint32_t word = esp_random();
+        size_t n = len < sizeof(word) ? len : sizeof(word);
+        memcpy(out, &word, n);
+        out += n;
+        len -= n;
+    }
+}
+
+esp_err_t esp_efuse_mac_get_default(uint8_t* mac) {
+    static const uint8_t host_mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    memcpy(mac, host_mac, sizeof(host_mac));
+    return ESP_OK;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    delay(ticks * portTICK_PERIOD_MS);
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return millis() / portTICK_PERIOD_MS;
+}
+
+struct HostTask {
+    std::mutex lock;
+    std::condition_variable notified;
+    uint32_t notifications = 0;
+};
+
+static thread_local HostTask* g_current_task = nullptr;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char* name, uint32_t stack_depth,
+                                   void* parameters, UBaseType_t priority,
+                                   TaskHandle_t* handle, BaseType_t core) {
+    (void)name; (void)stack_depth; (void)priority; (void)core;
+    HostTask* host_task = new HostTask();  // Lives as long as the thread, i.e. the process
+    std::thread([task, parameters, host_task]() {
+        g_current_task = host_task;
+        task(parameters);
+    }).detach();
+    if (handle) {
+        *handle = host_task;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    (void)task;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    {
+        std::lock_guard<std::mutex> guard(task->lock);
+        task->notifications++;
+    }
+    task->notified.notify_one();
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    HostTask* task = g_current_task;
+    if (!task) {
+        vTaskDelay(ticks == portMAX_DELAY ? 0 : ticks);  // Not a task: nobody can notify it
+        return 0;
+    }
+    std::unique_lock<std::mutex> guard(task->lock);
+    if (ticks == portMAX_DELAY) {
+        task->notified.wait(guard, [task]() { return task->notifications > 0; });
+    } else {
+        task->notified.wait_for(guard, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS),
+                                [task]() { return task->notifications > 0; });
+    }
+    uint32_t count = task->notifications;
+    if (count > 0) {
+        task->notifications = clear_on_exit ? 0 : count - 1;
+    }
+    return count;
+}
+
+struct HostSemaphore {
+    std::recursive_mutex mutex;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return new HostSemaphore();
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) {
+    return new HostSemaphore();
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    delete semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    if (ticks == portMAX_DELAY) {
+        semaphore->mutex.lock();
+        return pdTRUE;
+    }
+    // Polled: sanitizers do not follow the lock try_lock_for() takes
+    for (TickType_t waited = 0; !semaphore->mutex.try_lock(); waited++) {
+        if (waited >= ticks) {
+            return pdFALSE;
+        }
+        vTaskDelay(1);
+    }
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    semaphore->mutex.unlock();
+    return pdTRUE;
+}
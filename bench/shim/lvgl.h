@@ -0,0 +1,6 @@
+#pragma once
+
+// Display modules are not built for the host: only the handle types their
+// headers mention
+typedef struct _lv_obj_t lv_obj_t;
+typedef struct _lv_timer_t lv_timer_t;
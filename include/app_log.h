@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stdint.h>
+#include "config.h"
+
+// Leveled, per-module logging.
+//
+//   APP_LOGI(MACHINE, "Changed fields: 0x%02x", changes);
+//
+// Each module has a level (APP_LOG_LEVEL_<MODULE>, config.h). A call above
+// that level is a constant-false branch and compiles out together with its
+// format string; its arguments are still type-checked.
+//
+// Lines are formatted into a lock-free ring by the calling task and written
+// to Serial by a low-priority task (app_log_begin), so a log call costs a
+// vsnprintf and never waits for the UART / USB CDC. When the ring is full the
+// line is dropped and counted. Any task may log; ISRs may not.
+//
+// Not named log_*: the ESP32 core already uses those (esp32-hal-log.h).
+
+#define APP_LOG_NONE 0
+#define APP_LOG_ERROR 1
+#define APP_LOG_WARN 2
+#define APP_LOG_INFO 3
+#define APP_LOG_DEBUG 4
+#define APP_LOG_VERBOSE 5
+
+#define APP_LOG_ENABLED(module, level) (APP_LOG_LEVEL_##module >= (level))
+
+#define APP_LOG(level, module, fmt, ...)                                    \
+    do {                                                                    \
+        if (APP_LOG_ENABLED(module, level)) {                               \
+            app_log_write((level), #module, fmt, ##__VA_ARGS__);            \
+        }                                                                   \
+    } while (0)
+
+#define APP_LOGE(module, fmt, ...) APP_LOG(APP_LOG_ERROR, module, fmt, ##__VA_ARGS__)
+#define APP_LOGW(module, fmt, ...) APP_LOG(APP_LOG_WARN, module, fmt, ##__VA_ARGS__)
+#define APP_LOGI(module, fmt, ...) APP_LOG(APP_LOG_INFO, module, fmt, ##__VA_ARGS__)
+#define APP_LOGD(module, fmt, ...) APP_LOG(APP_LOG_DEBUG, module, fmt, ##__VA_ARGS__)
+#define APP_LOGV(module, fmt, ...) APP_LOG(APP_LOG_VERBOSE, module, fmt, ##__VA_ARGS__)
+
+struct AppLogStats {
+    uint32_t written;      // Lines queued
+    uint32_t dropped;      // Lines lost to a full ring
+    uint32_t truncated;    // Lines cut at APP_LOG_LINE_LEN
+    uint32_t high_water;   // Most lines waiting at once
+};
+
+/**
+ * Start the drain task (call first thing in setup). Lines logged before
+ * this wait in the ring.
+ */
+void app_log_begin();
+
+/**
+ * Queue one line (no trailing newline needed). Use the APP_LOG* macros.
+ */
+void app_log_write(uint8_t level, const char* module, const char* fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+void app_log_vwrite(uint8_t level, const char* module, const char* fmt, va_list args);
+
+AppLogStats app_log_get_stats();
+
+/**
+ * Lines queued but not yet written (always 0 without APP_LOG_ASYNC). Lets a
+ * long report wait for the drain task instead of overflowing the ring.
+ */
+uint32_t app_log_pending();
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "machine_state.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -70,14 +72,20 @@ void boiler_display_init(void);
  * - Arc is most accurate when actual warmup is close to 5 minutes
  * 
  * @param type Boiler type (BOILER_COFFEE or BOILER_STEAM)
- * @param machine_status Machine status string ("Off", "StandBy", "PoweredOn", etc.)
- * @param boiler_status Boiler status string ("Off", "StandBy", "HeatingUp", "Ready", etc.)
+ * @param machine_status Machine status (OFF/STANDBY turn the boiler display off)
+ * @param boiler_status Boiler status (OFF, STANDBY, HEATING_UP, READY, etc.)
  * @param ready_start_time Time when boiler will be ready in ms (GMT Unix timestamp), 0 if not available/null
- * @param target_value Target temperature (for coffee) or level string (for steam), can be NULL
  */
-void boiler_display_update(BoilerType type, const char* machine_status, 
-                           const char* boiler_status, int64_t ready_start_time,
-                           const char* target_value);
+void boiler_display_update(BoilerType type, MachineStatus machine_status, 
+                           BoilerStatus boiler_status, int64_t ready_start_time);
+
+/**
+ * Set the target temperature (coffee, e.g. "94°C") or level (steam, e.g. "L2") label
+ * 
+ * @param type Boiler type (BOILER_COFFEE or BOILER_STEAM)
+ * @param target_value Label text, ignored if NULL or empty
+ */
+void boiler_display_set_target(BoilerType type, const char* target_value);
 
 /**
  * Update all boilers to OFF state
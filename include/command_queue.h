@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "command_tracker.h"
+
+class LaMarzoccoMachine;
+
+// Power / steam commands from the touch screen. A tap only queues the
+// request, shows the requested state (LaMarzoccoMachine::request_control())
+// and marks its button busy; a worker task sends the POST and the
+// command is followed by the machine's CommandTracker. When the outcome is
+// known (confirmed, failed, timed out) it is queued back to Task_LVGL, which
+// releases the button.
+//
+// One command per kind is in flight at a time: taps on a busy button are
+// ignored (the button is disabled until the outcome arrives).
+
+struct CommandQueueStats {
+    uint32_t submitted;
+    uint32_t rejected;        // Busy, queue full or worker not started
+    uint32_t expired;         // Waited longer than COMMAND_QUEUE_TIMEOUT_MS, not sent
+    uint32_t wait_ms_max;     // Tap to worker picking the request up
+    uint32_t send_ms_last;    // Worker: POST and response handling
+    uint32_t send_ms_max;
+};
+
+/**
+ * Create the queues and the worker task for `machine`
+ */
+bool command_queue_begin(LaMarzoccoMachine* machine);
+
+/**
+ * Queue a toggle of the power / steam state the button shows. Call from an
+ * LVGL event callback (Task_LVGL, GUI mutex held); returns at once.
+ * `callback` gets the outcome on the worker or network task (see
+ * command_tracker.h); it must not touch LVGL.
+ *
+ * @return false if a command of this kind is in flight or nothing could be queued
+ */
+bool command_queue_toggle(CommandKind kind, CommandCallback callback = nullptr, void* context = nullptr);
+
+/**
+ * True from the tap until the command's outcome is known
+ */
+bool command_queue_busy(CommandKind kind);
+
+/**
+ * Release the buttons of finished commands
+ * Must be called from Task_LVGL with the GUI mutex held
+ */
+void command_queue_drain(void);
+
+CommandQueueStats command_queue_get_stats(void);
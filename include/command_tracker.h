@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include "dashboard_extract.h"
+#include "config.h"
+
+// Round trip of machine commands. The command POST answers with an id and
+// "Pending"; the machine's verdict arrives later in the dashboard's
+// commands[] array under the same id. Each POST is added here with the time
+// the user asked for it, and the entry is completed when the dashboard
+// reports a final status, or expired after COMMAND_CONFIRM_TIMEOUT_MS.
+//
+// add() runs on whichever task sent the POST, update() and expire() on the
+// network task. Callbacks run with no lock held, on the network task (or on
+// the sending task when the outcome is known by the time the POST returns):
+// they must not touch LVGL directly (queue a display event instead).
+
+enum CommandKind {
+    COMMAND_POWER = 0,
+    COMMAND_STEAM,
+    COMMAND_KIND_COUNT
+};
+
+enum CommandOutcome {
+    COMMAND_CONFIRMED = 0,    // Dashboard reported Success
+    COMMAND_FAILED,           // POST failed, or the dashboard reported Error / Timeout
+    COMMAND_TIMED_OUT,        // No final status within COMMAND_CONFIRM_TIMEOUT_MS
+    COMMAND_UNTRACKED         // POST accepted without an id to follow
+};
+
+// Final command statuses sent by the cloud (see dashboard_codes.h for the
+// lookup). It gives up on an unresponsive machine with "Timeout".
+#define COMMAND_STATUS_CODES(X)         \
+    X(COMMAND_CONFIRMED, "Success")     \
+    X(COMMAND_FAILED, "Error")          \
+    X(COMMAND_FAILED, "Timeout")
+
+struct CommandResult {
+    CommandKind kind;
+    bool value;               // Requested state (on / off)
+    CommandOutcome outcome;
+    uint32_t latency_ms;      // Request to outcome
+};
+
+typedef void (*CommandCallback)(const CommandResult& result, void* context);
+
+struct CommandTrackerStats {
+    uint32_t issued;          // Commands added with an id
+    uint32_t confirmed;
+    uint32_t failed;
+    uint32_t timed_out;
+    uint32_t unknown;         // Final statuses for ids not in the table (other clients)
+    uint32_t confirm_ms_last; // Request to Success
+    uint32_t confirm_ms_max;
+    uint32_t confirm_ms_avg;
+    uint32_t post_ms_last;    // Request to POST response
+};
+
+class CommandTracker {
+public:
+    CommandTracker();
+
+    /**
+     * Follow a command whose POST returned `id`. `requested_ms` is millis()
+     * when the user asked for it, before the POST was sent.
+     * If the dashboard already reported this id, completes right away.
+     *
+     * @return false if the table is full (the callback gets COMMAND_UNTRACKED)
+     */
+    bool add(const char* id, CommandKind kind, bool value, uint32_t requested_ms,
+             CommandCallback callback, void* context);
+
+    /**
+     * Match the commands[] of a dashboard message against the table
+     */
+    void update(const DashboardCommands& commands);
+
+    /**
+     * Time out entries older than COMMAND_CONFIRM_TIMEOUT_MS (call from loop)
+     */
+    void expire();
+
+    // Commands still waiting for a final status
+    size_t pending() const { return _count; }
+
+    CommandTrackerStats get_stats();
+
+private:
+    struct Entry {
+        char id[DASHBOARD_ID_LEN];
+        CommandKind kind;
+        bool value;
+        uint32_t requested_ms;
+        CommandCallback callback;
+        void* context;
+    };
+
+    // Recent final statuses. Snapshots repeat them, and one may arrive
+    // before the POST response has told us the id (not claimed yet).
+    struct RecentResult {
+        char id[DASHBOARD_ID_LEN];
+        CommandOutcome outcome;
+        bool claimed;
+    };
+
+    portMUX_TYPE _lock;
+    Entry _entries[COMMAND_TRACKER_SLOTS];
+    size_t _count;
+    RecentResult _recent[COMMAND_TRACKER_SLOTS];
+    size_t _recent_next;
+    CommandTrackerStats _stats;
+    uint64_t _confirm_ms_total;
+
+    void _record(CommandOutcome outcome, uint32_t latency_ms);
+    void _remember(const char* id, CommandOutcome outcome, bool claimed);
+};
+
+/**
+ * Final outcome for a dashboard command status; false while it is still
+ * Pending / InProgress (or unrecognised)
+ */
+bool command_status_outcome(const char* status, CommandOutcome& outcome);
+
+const char* command_kind_name(CommandKind kind);
+const char* command_outcome_name(CommandOutcome outcome);
@@ -11,6 +11,62 @@
 #define debugln(x)
 #endif
 
+// Log levels per module (see app_log.h): 0 = off, 1 = error, 2 = warn,
+// 3 = info, 4 = debug, 5 = verbose. Anything above a module's level is
+// compiled out.
+#ifndef APP_LOG_DEFAULT_LEVEL
+#ifdef DEBUG
+#define APP_LOG_DEFAULT_LEVEL 4
+#else
+#define APP_LOG_DEFAULT_LEVEL 3
+#endif
+#endif
+#ifndef APP_LOG_LEVEL_WS
+#define APP_LOG_LEVEL_WS APP_LOG_DEFAULT_LEVEL
+#endif
+#ifndef APP_LOG_LEVEL_MACHINE
+#define APP_LOG_LEVEL_MACHINE APP_LOG_DEFAULT_LEVEL
+#endif
+#ifndef APP_LOG_LEVEL_WIDGETS
+#define APP_LOG_LEVEL_WIDGETS APP_LOG_DEFAULT_LEVEL
+#endif
+#ifndef APP_LOG_LEVEL_BOILER
+#define APP_LOG_LEVEL_BOILER APP_LOG_DEFAULT_LEVEL
+#endif
+#ifndef APP_LOG_LEVEL_BREWING
+#define APP_LOG_LEVEL_BREWING APP_LOG_DEFAULT_LEVEL
+#endif
+#ifndef APP_LOG_LEVEL_WATER
+#define APP_LOG_LEVEL_WATER APP_LOG_DEFAULT_LEVEL
+#endif
+#ifndef APP_LOG_LEVEL_HTTP
+#define APP_LOG_LEVEL_HTTP APP_LOG_DEFAULT_LEVEL
+#endif
+// Periodic status report (main.cpp), info level
+#ifndef APP_LOG_LEVEL_STATUS
+#define APP_LOG_LEVEL_STATUS APP_LOG_DEFAULT_LEVEL
+#endif
+// STOMP capture and replay status (not the [CAP] records themselves)
+#ifndef APP_LOG_LEVEL_CAPTURE
+#define APP_LOG_LEVEL_CAPTURE APP_LOG_DEFAULT_LEVEL
+#endif
+
+// 1 = lines are queued and written by a low-priority task,
+// 0 = written from the calling task before the call returns
+#ifndef APP_LOG_ASYNC
+#define APP_LOG_ASYNC 1
+#endif
+#ifndef APP_LOG_RING_SLOTS
+#define APP_LOG_RING_SLOTS 32
+#endif
+#ifndef APP_LOG_LINE_LEN
+#define APP_LOG_LINE_LEN 128
+#endif
+// How often the drain task looks for new lines when the ring is empty (ms)
+#ifndef APP_LOG_DRAIN_MS
+#define APP_LOG_DRAIN_MS 20
+#endif
+
 // Captive portal redirection
 #define REDIRECT_URL "http://192.168.4.1/"
 static constexpr const char *NTP_SERVER = "pool.ntp.org";
@@ -20,4 +76,142 @@ static constexpr const char *NTP_SERVER = "pool.ntp.org";
 
 #define uS_TO_S_FACTOR 1000000ULL
 
+// Cloud endpoints. Override with -D to point the firmware at a local stand-in
+// such as tools/stomp_emulator.py (TLS is still used, certificates are not checked)
+#ifndef WS_BASE_URL
+#define WS_BASE_URL "lion.lamarzocco.io"  // Same base URL for both REST API and WebSocket
+#endif
+#ifndef WS_PORT
+#define WS_PORT 443
+#endif
+#ifndef CUSTOMER_APP_URL
+#define CUSTOMER_APP_URL "https://lion.lamarzocco.io/api/customer-app"
+#endif
+
+// Keep the access / refresh tokens (encrypted) and the registration in NVS,
+// so a reboot goes straight to the WebSocket (0 = register and sign in on
+// every boot, for comparison)
+#ifndef AUTH_PERSIST
+#define AUTH_PERSIST 1
+#endif
+
+// Keep the API's TLS connection open between requests (0 = new connection
+// and handshake for every request, for comparison)
+#ifndef API_KEEPALIVE
+#define API_KEEPALIVE 1
+#endif
+
+// STOMP heart-beat intervals offered in CONNECT (ms, 0 = none)
+// The effective intervals are negotiated with the server's CONNECTED frame
+#ifndef STOMP_HEARTBEAT_SEND_MS
+#define STOMP_HEARTBEAT_SEND_MS 10000
+#endif
+#ifndef STOMP_HEARTBEAT_RECV_MS
+#define STOMP_HEARTBEAT_RECV_MS 10000
+#endif
+
+// Upper bound on inbound silence before the link is considered dead and a
+// reconnect is forced (ms). WebSocket pings keep traffic flowing when the
+// server declines STOMP heart-beats.
+#ifndef STOMP_STALE_LINK_TIMEOUT_MS
+#define STOMP_STALE_LINK_TIMEOUT_MS 30000
+#endif
+
+// WebSocket reconnect controller: exponential backoff with jitter (ms)
+#ifndef WS_BACKOFF_BASE_MS
+#define WS_BACKOFF_BASE_MS 1000
+#endif
+#ifndef WS_BACKOFF_MAX_MS
+#define WS_BACKOFF_MAX_MS 60000
+#endif
+// Give up on a TLS handshake / STOMP CONNECT that takes longer than this (ms)
+#ifndef WS_CONNECT_TIMEOUT_MS
+#define WS_CONNECT_TIMEOUT_MS 20000
+#endif
+
+// Pre-signed request header pool: number of sets kept ready, and how long a
+// set may wait before its timestamp is considered too old to send (ms)
+#ifndef SIGNED_HEADER_POOL_SIZE
+#define SIGNED_HEADER_POOL_SIZE 3
+#endif
+#ifndef SIGNED_HEADER_MAX_AGE_MS
+#define SIGNED_HEADER_MAX_AGE_MS 30000
+#endif
+
+// Capture of inbound WebSocket events for offline replay (see stomp_capture.h)
+// 0 = off, 1 = binary file on SPIFFS, 2 = base64 "[CAP]" lines on Serial
+#ifndef STOMP_CAPTURE_MODE
+#define STOMP_CAPTURE_MODE 0
+#endif
+#ifndef STOMP_CAPTURE_PATH
+#define STOMP_CAPTURE_PATH "/capture.bin"
+#endif
+#ifndef STOMP_CAPTURE_MAX_BYTES
+#define STOMP_CAPTURE_MAX_BYTES (256 * 1024)
+#endif
+// Define STOMP_REPLAY_SPEEDUP (1 = real time, 0 = as fast as possible) to
+// replay STOMP_CAPTURE_PATH through the WebSocket handler at boot
+//#define STOMP_REPLAY_SPEEDUP 10
+// Define STOMP_SOAK_HOURS as well to keep replaying the capture for that long,
+// reporting the largest free internal heap block after every pass
+//#define STOMP_SOAK_HOURS 24
+
+// Dashboard parse engine: an ArduinoJson document (dashboard_json.h), or the
+// allocation-free single-pass extractor (dashboard_extract.h). The native
+// bench times and fuzzes both.
+#define DASHBOARD_PARSER_ARDUINOJSON 0
+#define DASHBOARD_PARSER_STREAM 1
+#ifndef DASHBOARD_PARSER
+#define DASHBOARD_PARSER DASHBOARD_PARSER_ARDUINOJSON
+#endif
+
+// Parse dashboard messages through an ArduinoJson filter that keeps only the
+// fields the handler reads (0 = parse the full document, for comparison)
+#ifndef DASHBOARD_JSON_FILTER
+#define DASHBOARD_JSON_FILTER 1
+#endif
+
+// 1 = also parse the widgets nothing displays yet (pre-brewing, back flush,
+// doses, grinders) and log them at debug level. Off, they are skipped unread.
+#ifndef DASHBOARD_LOG_ALL_WIDGETS
+#define DASHBOARD_LOG_ALL_WIDGETS 0
+#endif
+
+// PSRAM arenas for ArduinoJson documents (bytes, see json_allocator.h)
+#ifndef JSON_ARENA_DASHBOARD_SIZE
+#define JSON_ARENA_DASHBOARD_SIZE (32 * 1024)
+#endif
+#ifndef JSON_ARENA_API_SIZE
+#define JSON_ARENA_API_SIZE (16 * 1024)
+#endif
+
+// Machine commands followed until the dashboard reports their result
+// (see command_tracker.h), and how long to wait for it (ms)
+#ifndef COMMAND_TRACKER_SLOTS
+#define COMMAND_TRACKER_SLOTS 4
+#endif
+#ifndef COMMAND_CONFIRM_TIMEOUT_MS
+#define COMMAND_CONFIRM_TIMEOUT_MS 15000
+#endif
+// A tap still waiting for the command worker after this long is dropped (ms)
+#ifndef COMMAND_QUEUE_TIMEOUT_MS
+#define COMMAND_QUEUE_TIMEOUT_MS 5000
+#endif
+// Buttons show a requested power / steam state until a dashboard reports it;
+// after this long without it they go back to the reported state (ms)
+#ifndef CONTROL_RECONCILE_TIMEOUT_MS
+#define CONTROL_RECONCILE_TIMEOUT_MS 20000
+#endif
+
+// Serve update latency histograms (update_trace.h) at GET /latency while
+// connected to the machine
+#ifndef TRACE_HTTP
+#define TRACE_HTTP 1
+#endif
+
+// Reassembly buffer for fragmented / concatenated STOMP frames (bytes, PSRAM)
+#ifndef STOMP_ASSEMBLER_CAPACITY
+#define STOMP_ASSEMBLER_CAPACITY (16 * 1024)
+#endif
+
 #endif
\ No newline at end of file
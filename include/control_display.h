@@ -0,0 +1,21 @@
+#pragma once
+
+#include "lvgl.h"
+
+class LaMarzoccoMachine;
+
+// Power and steam buttons: checked (outlined) while on, dimmed while a
+// requested state waits for the dashboard to report it. They show
+// LaMarzoccoMachine::get_control(), so a tap changes them right away.
+
+/**
+ * Set up the on / off look of the buttons
+ * Must be called from Task_LVGL after ui_init()
+ */
+void control_display_init(void);
+
+/**
+ * Redraw the buttons if the machine's control state changed since the last call
+ * Must be called from Task_LVGL with the GUI mutex held
+ */
+void control_display_refresh(LaMarzoccoMachine* machine);
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Compile-time lookup of dashboard widget codes and status strings.
+//
+// Each table is an X-macro list of (enum value, string) pairs. The lookup is
+// a switch over the FNV-1a hash of the string (the same hash as
+// dashboard_hash()), with the case labels computed by the compiler, followed
+// by one memcmp to reject collisions. Two entries with the same hash fail to
+// compile as duplicate case labels. Registering a new code is one line in its
+// list; dispatching it costs one hash and one compare whatever the list size.
+
+// FNV-1a, usable in constant expressions (C++11: single return statement)
+constexpr uint32_t dashboard_code_hash(const char* str, uint32_t hash = 2166136261u) {
+    return *str ? dashboard_code_hash(str + 1, (hash ^ (uint8_t)*str) * 16777619u) : hash;
+}
+
+// Entry point for the lists below: X(value, "string")
+#define DASHBOARD_ENUM_ENTRY(value, name) value,
+
+#define DASHBOARD_LOOKUP_CASE(value, name)                                   \
+    case dashboard_code_hash(name):                                          \
+        if (length == sizeof(name) - 1 && memcmp(str, name, length) == 0) {  \
+            return value;                                                    \
+        }                                                                    \
+        break;
+
+#define DASHBOARD_NAME_CASE(value, name) \
+    case value:                          \
+        return name;
+
+// Widgets the display understands. Add new codes here.
+// Grinder (G*) codes must stay contiguous, see GrinderWidgets.
+#define DASHBOARD_WIDGET_CODES(X)                                      \
+    X(WIDGET_MACHINE_STATUS, "CMMachineStatus")                        \
+    X(WIDGET_COFFEE_BOILER, "CMCoffeeBoiler")                          \
+    X(WIDGET_STEAM_BOILER_LEVEL, "CMSteamBoilerLevel")                 \
+    X(WIDGET_NO_WATER, "CMNoWater")                                    \
+    X(WIDGET_STEAM_BOILER_TEMPERATURE, "CMSteamBoilerTemperature")     \
+    X(WIDGET_PRE_BREWING, "CMPreBrewing")                              \
+    X(WIDGET_BACK_FLUSH, "CMBackFlush")                                \
+    X(WIDGET_GROUP_DOSES, "CMGroupDoses")                              \
+    X(WIDGET_BREW_BY_WEIGHT_DOSES, "CMBrewByWeightDoses")              \
+    X(WIDGET_GRINDER_STATUS, "GMachineStatus")                         \
+    X(WIDGET_GRINDER_DOSES, "GDoses")                                  \
+    X(WIDGET_GRINDER_SINGLE_DOSE_MODE, "GSingleDoseMode")              \
+    X(WIDGET_GRINDER_BARISTA_LIGHT, "GBaristaLight")                   \
+    X(WIDGET_GRINDER_HOPPER_OPENED, "GHopperOpened")                   \
+    X(WIDGET_GRINDER_SPEED, "GSpeed")                                  \
+    X(WIDGET_GRINDER_MIRROR_DOSES, "GMirrorDoses")                     \
+    X(WIDGET_GRINDER_MORE_DOSE, "GMoreDose")                           \
+    X(WIDGET_GRINDER_GRIND_WITH, "GGrindWith")
+
+typedef enum {
+    WIDGET_UNKNOWN = 0,
+    DASHBOARD_WIDGET_CODES(DASHBOARD_ENUM_ENTRY)
+    WIDGET_CODE_COUNT
+} DashboardWidgetCode;
+
+/**
+ * Map a widget code (not necessarily null-terminated) to its enum
+ *
+ * @return WIDGET_UNKNOWN for codes that are not registered
+ */
+DashboardWidgetCode dashboard_widget_code(const char* str, size_t length);
+
+/**
+ * Widget code string for logging ("Unknown" for WIDGET_UNKNOWN)
+ */
+const char* dashboard_widget_name(DashboardWidgetCode code);
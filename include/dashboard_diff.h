@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct DashboardDiffStats {
+    uint32_t skipped;            // Identical snapshots dropped before parsing
+    uint32_t processed;          // Snapshots that went on to the JSON parser
+};
+
+// FNV-1a over a byte range; pass the previous result as seed to chain ranges
+uint32_t dashboard_hash(const char* data, size_t length, uint32_t seed = 2166136261u);
+
+// Change detection over raw dashboard JSON, without parsing it.
+// Only "widgets", "removedWidgets" and "commands" are hashed: "uuid" and
+// "connectionDate" change on every message and carry no machine state.
+// Which widgets changed is the widget handlers' business (widget_handler.h).
+class DashboardDiff {
+public:
+    DashboardDiff();
+
+    // Hash a snapshot; returns false if it is identical to the previous one
+    bool update(const char* json, size_t length);
+
+    // Forget the previous snapshot (e.g. it could not be applied)
+    void invalidate() { _valid = false; }
+
+    const DashboardDiffStats& get_stats() const { return _stats; }
+
+private:
+    uint32_t _snapshot_hash;
+    bool _valid;
+    DashboardDiffStats _stats;
+};
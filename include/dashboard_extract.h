@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "widget_handler.h"
+
+// Allocation-free dashboard reader. dashboard_extract() walks the STOMP body
+// once, hands each widget's output span to the registry and copies the
+// command results; strings are copied (truncated) so nothing points into the
+// body once it returns.
+
+#define DASHBOARD_STR_LEN 20
+#define DASHBOARD_ID_LEN 40
+#define DASHBOARD_MAX_COMMANDS 4
+
+struct DashboardCommand {
+    char id[DASHBOARD_ID_LEN];
+    char status[DASHBOARD_STR_LEN];
+};
+
+// commands[] (first DASHBOARD_MAX_COMMANDS entries)
+struct DashboardCommands {
+    size_t count;
+    DashboardCommand items[DASHBOARD_MAX_COMMANDS];
+};
+
+// Most paths a handler's fields() may list for the extractor
+#define WIDGET_MAX_FIELDS 8
+
+// WidgetOutput over the raw JSON of one "output" object. The constructor
+// walks the span once and notes where the value of each of the handler's
+// fields() lies; a getter then only descends inside that value (e.g. the
+// "seconds" object of a pre-brewing time table), never from the start of the
+// output. Paths outside fields() fall back to a scan of the whole span.
+class JsonSpanOutput : public WidgetOutput {
+public:
+    JsonSpanOutput(const char* json, size_t length, const char* const* fields);
+
+    bool get_string(const char* path, char* out, size_t size) const override;
+    bool get_int(const char* path, int64_t& out) const override;
+    bool get_float(const char* path, float& out) const override;
+    bool get_bool(const char* path, bool& out) const override;
+
+private:
+    struct Span {
+        const char* json;   // nullptr: the field is not in the output
+        size_t length;
+    };
+
+    const char* _json;
+    size_t _length;
+    const char* const* _fields;
+    size_t _field_count;
+    Span _spans[WIDGET_MAX_FIELDS];
+
+    // Value at `path`: [value, end) is the rest of its span
+    bool _find(const char* path, const char*& value, const char*& end) const;
+};
+
+/**
+ * Clear all commands
+ */
+void dashboard_commands_clear(DashboardCommands& commands);
+
+/**
+ * Copy a (possibly null) string into a fixed field, truncating if needed
+ */
+void dashboard_copy_str(char* dest, size_t size, const char* src);
+
+/**
+ * Single-pass, allocation-free extraction from raw dashboard JSON.
+ * Widgets are dispatched to `registry` (between the caller's begin_frame()
+ * and end_frame()); unknown keys and widgets are skipped without being stored.
+ *
+ * @return false if the JSON is malformed (some widgets may have been dispatched)
+ */
+bool dashboard_extract(const char* json, size_t length,
+                       WidgetRegistry& registry, DashboardCommands& commands);
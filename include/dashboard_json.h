@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stddef.h>
+#include <ArduinoJson.h>
+
+#include "dashboard_extract.h"
+#include "widget_handler.h"
+
+// ArduinoJson dashboard reader: the body is parsed into a JsonDocument on
+// json_dashboard_arena, then each widget's "output" object is handed to the
+// registry. Same contract as dashboard_extract(); config.h DASHBOARD_PARSER
+// picks the one the firmware uses.
+
+/**
+ * Filter keeping only what the handlers in `registry` read: widget codes,
+ * their fields() paths and command results. Built on the first call.
+ */
+const JsonDocument& dashboard_json_filter(const WidgetRegistry& registry);
+
+/**
+ * Parse into a JsonDocument (filtered if DASHBOARD_JSON_FILTER) and dispatch
+ * the widgets to `registry` (between the caller's begin_frame() and end_frame())
+ *
+ * @return false if the JSON could not be parsed (logged, nothing dispatched)
+ */
+bool dashboard_parse_json(const char* json, size_t length,
+                          WidgetRegistry& registry, DashboardCommands& commands);
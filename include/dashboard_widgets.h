@@ -0,0 +1,210 @@
+#pragma once
+
+#include "widget_handler.h"
+#include "machine_state.h"
+#include "dashboard_extract.h"
+
+// Handlers for the dashboard widgets. The machine status, boiler and water
+// widgets feed MachineState (and through it the display). The others only
+// keep their state for logging until a screen shows them, and are registered
+// only with DASHBOARD_LOG_ALL_WIDGETS.
+
+// CMMachineStatus
+struct MachineStatusWidgetState {
+    MachineStatus status;
+    char mode[DASHBOARD_STR_LEN];
+    int64_t brewing_start_time;      // 0 if null / absent
+};
+
+class MachineStatusWidget : public StatefulWidget<MachineStatusWidgetState> {
+public:
+    const char* const* fields() const override;
+    void print(DashboardWidgetCode code) const override;
+protected:
+    void read(const WidgetOutput& output, MachineStatusWidgetState& state) override;
+};
+
+// CMCoffeeBoiler
+struct CoffeeBoilerWidgetState {
+    BoilerStatus status;
+    int64_t ready_start_time;
+    float target_temperature;        // 0 if absent
+};
+
+class CoffeeBoilerWidget : public StatefulWidget<CoffeeBoilerWidgetState> {
+public:
+    const char* const* fields() const override;
+    void print(DashboardWidgetCode code) const override;
+protected:
+    void read(const WidgetOutput& output, CoffeeBoilerWidgetState& state) override;
+};
+
+// CMSteamBoilerLevel
+struct SteamBoilerLevelWidgetState {
+    BoilerStatus status;
+    int64_t ready_start_time;
+    char target_level[DASHBOARD_STR_LEN];  // "Level2", empty if absent
+};
+
+class SteamBoilerLevelWidget : public StatefulWidget<SteamBoilerLevelWidgetState> {
+public:
+    const char* const* fields() const override;
+    void print(DashboardWidgetCode code) const override;
+protected:
+    void read(const WidgetOutput& output, SteamBoilerLevelWidgetState& state) override;
+};
+
+// CMNoWater
+struct NoWaterWidgetState {
+    bool alarm;
+};
+
+class NoWaterWidget : public StatefulWidget<NoWaterWidgetState> {
+public:
+    const char* const* fields() const override;
+    void print(DashboardWidgetCode code) const override;
+protected:
+    void read(const WidgetOutput& output, NoWaterWidgetState& state) override;
+};
+
+// CMSteamBoilerTemperature (machines with a temperature-controlled steam
+// boiler): shown as the steam boiler when CMSteamBoilerLevel is absent
+struct SteamBoilerTemperatureWidgetState {
+    BoilerStatus status;
+    bool enabled;
+    int64_t ready_start_time;
+    float target_temperature;
+};
+
+class SteamBoilerTemperatureWidget : public StatefulWidget<SteamBoilerTemperatureWidgetState> {
+public:
+    const char* const* fields() const override;
+    void print(DashboardWidgetCode code) const override;
+protected:
+    void read(const WidgetOutput& output, SteamBoilerTemperatureWidgetState& state) override;
+};
+
+// CMPreBrewing: mode and the group's In/Out seconds for that mode
+struct PreBrewingWidgetState {
+    char mode[DASHBOARD_STR_LEN];    // "PreBrewing", "PreInfusion" or "Disabled"
+    float seconds_in;
+    float seconds_out;
+};
+
+class PreBrewingWidget : public StatefulWidget<PreBrewingWidgetState> {
+public:
+    const char* const* fields() const override;
+    void print(DashboardWidgetCode code) const override;
+protected:
+    void read(const WidgetOutput& output, PreBrewingWidgetState& state) override;
+};
+
+// CMBackFlush
+struct BackFlushWidgetState {
+    char status[DASHBOARD_STR_LEN];
+    int64_t last_cleaning_start_time;
+};
+
+class BackFlushWidget : public StatefulWidget<BackFlushWidgetState> {
+public:
+    const char* const* fields() const override;
+    void print(DashboardWidgetCode code) const override;
+protected:
+    void read(const WidgetOutput& output, BackFlushWidgetState& state) override;
+};
+
+// CMGroupDoses: dose mode and the first programmed dose
+struct GroupDosesWidgetState {
+    char mode[DASHBOARD_STR_LEN];
+    float dose;
+};
+
+class GroupDosesWidget : public StatefulWidget<GroupDosesWidgetState> {
+public:
+    const char* const* fields() const override;
+    void print(DashboardWidgetCode code) const override;
+protected:
+    void read(const WidgetOutput& output, GroupDosesWidgetState& state) override;
+};
+
+// CMBrewByWeightDoses
+struct BrewByWeightWidgetState {
+    char mode[DASHBOARD_STR_LEN];    // "Dose1", "Dose2" or "Continuous"
+    float dose1;                     // Grams
+    float dose2;
+    bool scale_connected;
+};
+
+class BrewByWeightWidget : public StatefulWidget<BrewByWeightWidgetState> {
+public:
+    const char* const* fields() const override;
+    void print(DashboardWidgetCode code) const override;
+protected:
+    void read(const WidgetOutput& output, BrewByWeightWidgetState& state) override;
+};
+
+// Grinder G* widgets. Their output layouts differ per grinder model, so one
+// handler serves all of them and keeps the common fields per code.
+#define WIDGET_GRINDER_FIRST WIDGET_GRINDER_STATUS
+#define WIDGET_GRINDER_LAST WIDGET_GRINDER_GRIND_WITH
+#define GRINDER_WIDGET_COUNT (WIDGET_GRINDER_LAST - WIDGET_GRINDER_FIRST + 1)
+
+struct GrinderWidgetState {
+    bool present;
+    char status[DASHBOARD_STR_LEN];
+    char mode[DASHBOARD_STR_LEN];
+    bool enabled;
+};
+
+class GrinderWidgets : public WidgetHandler {
+public:
+    GrinderWidgets();
+
+    // Register every G* code with the registry
+    void register_all(WidgetRegistry& registry);
+
+    const GrinderWidgetState& state(DashboardWidgetCode code) const {
+        return _states[code - WIDGET_GRINDER_FIRST];
+    }
+
+    bool update(DashboardWidgetCode code, const WidgetOutput& output) override;
+    bool clear(DashboardWidgetCode code) override;
+    const char* const* fields() const override;
+    void print(DashboardWidgetCode code) const override;
+
+private:
+    GrinderWidgetState _states[GRINDER_WIDGET_COUNT];
+
+    bool _commit(DashboardWidgetCode code, const GrinderWidgetState& next);
+};
+
+// Every handler the firmware has, one instance each
+struct DashboardWidgets {
+    MachineStatusWidget machine;
+    CoffeeBoilerWidget coffee;
+    SteamBoilerLevelWidget steam;
+    NoWaterWidget no_water;
+    SteamBoilerTemperatureWidget steam_temperature;
+    // No display of their own yet: parsed and logged when they change
+    PreBrewingWidget pre_brewing;
+    BackFlushWidget back_flush;
+    GroupDosesWidget group_doses;
+    BrewByWeightWidget brew_by_weight;
+    GrinderWidgets grinders;
+
+    // Register the handlers that feed MachineState
+    void register_displayed(WidgetRegistry& registry);
+
+    // Register each handler under its code(s)
+    void register_all(WidgetRegistry& registry);
+};
+
+/**
+ * Build the display snapshot from the machine widgets
+ */
+void machine_state_from_widgets(const MachineStatusWidget& machine,
+                                const CoffeeBoilerWidget& coffee,
+                                const SteamBoilerLevelWidget& steam,
+                                const SteamBoilerTemperatureWidget& steam_temperature,
+                                const NoWaterWidget& no_water,
+                                MachineState& state);
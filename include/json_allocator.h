@@ -0,0 +1,64 @@
+#pragma once
+
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+
+// ArduinoJson allocator backed by one PSRAM block. Allocations are bumped
+// off the block and nothing is returned to the heap: freeing the newest
+// block rolls the top back, and once every block is freed the arena rewinds
+// to empty. Documents are short-lived (one message, one HTTP call), so the
+// internal heap never sees their pools and strings and cannot fragment.
+//
+// When the arena is full (or PSRAM is missing) blocks come from the heap
+// instead and are counted as fallbacks. Each block carries an 8-byte header
+// with its size so reallocate() can copy and deallocate() can count.
+// Safe to share between tasks.
+
+struct JsonArenaStats {
+    uint32_t resets;       // Times the arena rewound to empty
+    uint32_t fallbacks;    // Blocks that did not fit and went to the heap
+    uint32_t high_water;   // Most arena bytes in use at once
+};
+
+class JsonArena : public ArduinoJson::Allocator {
+public:
+    explicit JsonArena(size_t capacity);
+
+    // Allocate the PSRAM block (call once from setup)
+    bool begin();
+
+    void* allocate(size_t size) override;
+    void deallocate(void* ptr) override;
+    void* reallocate(void* ptr, size_t new_size) override;
+
+    // Rewind before a new message; refused (false) while blocks are still live
+    bool reset();
+
+    // Start a new measurement window (peak = what is held right now)
+    void reset_peak() { _peak = _current; }
+
+    size_t current() const { return _current; }
+    size_t peak() const { return _peak; }
+    size_t capacity() const { return _capacity; }
+    const JsonArenaStats& get_stats() const { return _stats; }
+
+private:
+    uint8_t* _buffer;
+    size_t _capacity;
+    size_t _top;       // Next free offset in _buffer
+    size_t _live;      // Arena blocks not yet freed
+    size_t _current;   // Bytes held by live blocks (arena and heap)
+    size_t _peak;
+    JsonArenaStats _stats;
+    portMUX_TYPE _lock;
+
+    bool _owns(const void* ptr) const;
+    void* _heap_allocate(size_t size);
+    void _add(size_t size);
+};
+
+// Dashboard documents (network task)
+extern JsonArena json_dashboard_arena;
+
+// REST request / response documents (auth, commands)
+extern JsonArena json_api_arena;
@@ -49,8 +49,19 @@ public:
     // Generate UUID v4
     static String generate_uuid();
     
+    // Encrypt data kept in NVS (AES-256-GCM, key derived from the installation
+    // secret and this chip's MAC). `aad` is authenticated but not stored: a
+    // blob only opens with the same key and aad. Returns base64, empty on failure.
+    static String seal(const InstallationKey& key, const String& aad, const String& plain);
+    
+    // Decrypt and verify a sealed blob
+    static bool unseal(const InstallationKey& key, const String& aad, const String& sealed, String& plain);
+    
 private:
     // Derive secret bytes from installation_id and public key
     static void derive_secret_bytes(const String& installation_id, const uint8_t* pub_der_bytes, size_t pub_len, uint8_t* secret_out);
+    
+    // AES key for seal() / unseal()
+    static bool derive_storage_key(const InstallationKey& key, uint8_t* key_out);
 };
 
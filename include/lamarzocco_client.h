@@ -5,18 +5,59 @@
 #include <WiFiClientSecure.h>
 #include <ArduinoJson.h>
 #include "lamarzocco_auth.h"
+#include "signed_header_pool.h"
 #include "Preferences.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 struct AccessToken {
     String access_token;
     String refresh_token;
     unsigned long expires_at;  // Unix timestamp in seconds
+    unsigned long refresh_at;  // Renew from here on (same clock)
     
     bool isValid() const {
         return access_token.length() > 0 && expires_at > (unsigned long)(millis() / 1000);
     }
 };
 
+// Connection reuse and timing of the HTTPS requests
+struct HttpClientStats {
+    uint32_t requests;
+    uint32_t reused;            // Sent on a connection kept alive from an earlier request
+    uint32_t handshakes;        // New TLS connections
+    uint32_t retries;           // Kept-alive connection found closed, resent on a new one
+    uint32_t failures;          // No HTTP response (connect, send or read error)
+    uint32_t request_ms_last;   // Connect (if needed) to response body read
+    uint32_t request_ms_max;
+    uint32_t reused_ms_avg;     // Requests on a kept-alive connection
+    uint32_t handshake_ms_avg;  // Requests that opened a connection
+};
+
+// Access-token renewal by the background refresh task
+struct TokenRefreshStats {
+    uint32_t refreshes;         // Refresh-token exchanges that succeeded
+    uint32_t sign_ins;          // Full sign-ins (no or rejected refresh token)
+    uint32_t failures;          // Renewals that ended without a token
+    uint32_t inline_renewals;   // Renewals a caller had to wait for (token missing or expiring)
+    uint32_t refresh_ms_last;   // Renewal request(s), sign-in fallback included
+    uint32_t refresh_ms_max;
+    uint32_t refresh_ms_avg;
+    int32_t expires_in_s;       // Validity left on the current token
+};
+
+// One HTTPS connection
+struct HttpConnection {
+    WiFiClientSecure client;
+    HTTPClient http;  // Outlives requests: destroying it closes the connection
+};
+
+// Customer app API client. One HTTPClient / TLS connection is kept open
+// between requests (keep-alive), so only the first request after the server
+// closed it pays for the handshake. Safe to call from any task: requests are
+// serialised. A background task renews the access token ahead of expiry on a
+// connection of its own, so API calls and WebSocket connects only wait on
+// auth when there is no usable token at all.
 class LaMarzoccoClient {
 public:
     LaMarzoccoClient(Preferences& prefs);
@@ -28,7 +69,7 @@ public:
     // Register client (call after generating installation key)
     bool register_client();
     
-    // Get access token (sign in or refresh)
+    // Make sure there is a usable access token (sign in or refresh if not)
     bool get_access_token();
     
     // Make authenticated API call
@@ -44,7 +85,23 @@ public:
     String get_serial_number() const { return _serial_number; }
     
     // Get access token string (for websocket)
-    String get_access_token_string() const { return _access_token.access_token; }
+    String get_access_token_string();
+    
+    // Take a pre-signed header set (signs inline if the pool is empty)
+    bool take_signed_headers(SignedHeaders& headers) { return _header_pool.take(headers); }
+    
+    // Signature pool hit rate and time saved
+    SignedHeaderPoolStats get_signed_header_stats() { return _header_pool.get_stats(); }
+    
+    // Connection reuse and request timing
+    const HttpClientStats& get_http_stats() const { return _http_stats; }
+    
+    // Background token renewal
+    TokenRefreshStats get_token_stats();
+    
+    // This boot started from the stored tokens / registration (AUTH_PERSIST)
+    bool tokens_restored() const { return _tokens_restored; }
+    bool registration_skipped() const { return _registration_skipped; }
     
 private:
     Preferences& _prefs;
@@ -54,12 +111,43 @@ private:
     String _password;
     String _serial_number;
     bool _initialized;
-    WiFiClientSecure _client;
+    HttpConnection _api;            // API calls and registration, kept alive
+    HttpConnection _auth;           // Token renewals, closed after each one
+    SemaphoreHandle_t _http_mutex;  // _api, shared by the network and UI tasks
+    SemaphoreHandle_t _auth_mutex;  // _auth; one renewal at a time
+    SemaphoreHandle_t _token_mutex; // _access_token and _token_stats, held briefly
+    portMUX_TYPE _stats_lock;       // _http_stats, updated from both connections
+    HttpClientStats _http_stats;
+    uint64_t _reused_ms_total;
+    uint64_t _handshake_ms_total;
+    SignedHeaderPool _header_pool;
+    TaskHandle_t _refresh_task;
+    TokenRefreshStats _token_stats;
+    uint64_t _refresh_ms_total;
+    bool _tokens_restored;
+    bool _expiry_unchecked;         // Restored before NTP synced; checked lazily
+    bool _registration_skipped;
+    
+    // Extra header for _request()
+    struct RequestHeader {
+        const char* name;
+        String value;
+    };
     
     // Internal helpers
     bool _sign_in();
-    bool _refresh_token();
-    bool _make_request(const String& method, const String& url, JsonDocument* request_body, JsonDocument* response_body, bool needs_auth);
+    bool _refresh_token(const String& refresh_token);
+    void _store_token(const JsonDocument& response, bool refreshed);
+    bool _renew_token(bool background);
+    long _token_seconds_left() const;
+    bool _token_expiry_known();
+    uint32_t _refresh_wait_ms();
+    static void _refresh_task_main(void* arg);
+    String _token_store_aad() const;
+    void _load_tokens();
+    void _save_tokens();
+    int _request(HttpConnection& conn, const char* method, const String& endpoint, const String& body,
+                 bool signed_headers, const RequestHeader* headers, size_t header_count, String& response);
     void _add_auth_headers(HTTPClient& http);
 };
 
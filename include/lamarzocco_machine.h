@@ -3,28 +3,74 @@
 #include <Arduino.h>
 #include "lamarzocco_client.h"
 #include "lamarzocco_websocket.h"
+#include "dashboard_diff.h"
+#include "machine_state.h"
+#include "dashboard_widgets.h"
+#include "command_tracker.h"
+
+// Dashboard JSON parse cost (last / worst message)
+struct DashboardParseStats {
+    uint32_t parse_us_last;
+    uint32_t parse_us_max;
+    uint32_t json_peak_last;  // Bytes held by the JsonDocument after parsing
+    uint32_t json_peak_max;
+    uint32_t handler_us_last; // Whole message handler, logging included
+    uint32_t handler_us_max;
+};
+
+// Power / steam as the buttons show it: the requested state while a command
+// is pending, otherwise what the dashboard last reported
+struct ControlView {
+    bool on;
+    bool pending;
+};
+
+// Optimistic control state against the dashboard
+struct ControlStats {
+    uint32_t requested;
+    uint32_t reconciled;        // Dashboard reported the requested state
+    uint32_t rolled_back;       // Command failed / timed out, back to the reported state
+    uint32_t reconcile_ms_last; // Request to the dashboard reporting it
+    uint32_t reconcile_ms_max;
+};
 
 class LaMarzoccoMachine {
 public:
     LaMarzoccoMachine(LaMarzoccoClient& client, LaMarzoccoWebSocket& websocket);
     
-    // Set power on/off
-    bool set_power(bool enabled);
+    // Set power on/off. `callback` gets the machine's verdict once the
+    // dashboard reports it (or the POST failure / timeout), see command_tracker.h
+    bool set_power(bool enabled, CommandCallback callback = nullptr, void* context = nullptr);
     
-    // Get current power state (from last command or websocket update)
-    bool get_power_state() const { return _power_state; }
+    // Get current power state (requested, or reported by the websocket)
+    bool get_power_state() { return get_control(COMMAND_POWER).on; }
     
     // Toggle power
-    bool toggle_power();
+    bool toggle_power(CommandCallback callback = nullptr, void* context = nullptr);
     
-    // Set steam boiler on/off
-    bool set_steam(bool enabled);
+    // Set steam boiler on/off (callback as for set_power)
+    bool set_steam(bool enabled, CommandCallback callback = nullptr, void* context = nullptr);
     
     // Get current steam boiler state
-    bool get_steam_state() const { return _steam_state; }
+    bool get_steam_state() { return get_control(COMMAND_STEAM).on; }
     
     // Toggle steam boiler
-    bool toggle_steam();
+    bool toggle_steam(CommandCallback callback = nullptr, void* context = nullptr);
+    
+    // Show `on` for power / steam right away: the view stays pending until a
+    // dashboard reports that state, and rolls back to the reported state if
+    // the command fails or nothing is reported within CONTROL_RECONCILE_TIMEOUT_MS
+    void request_control(CommandKind kind, bool on);
+    
+    // Outcome of the command sent after request_control()
+    void control_result(const CommandResult& result);
+    
+    ControlView get_control(CommandKind kind);
+    
+    // Changes whenever a ControlView changes (for redrawing)
+    uint32_t get_control_version();
+    
+    ControlStats get_control_stats();
     
     // Connect websocket and start listening
     bool connect_websocket();
@@ -38,14 +84,59 @@ public:
     // Loop (call in main loop)
     void loop();
     
+    // Skipped vs processed dashboard snapshots
+    const DashboardDiffStats& get_dashboard_stats() const { return _dashboard_diff.get_stats(); }
+    
+    // JSON parse time and memory
+    const DashboardParseStats& get_parse_stats() const { return _parse_stats; }
+    
+    // Uptime when the first dashboard was parsed (0 = none yet)
+    uint32_t get_first_dashboard_ms() const { return _first_dashboard_ms; }
+    
+    // Command round trips (request to dashboard confirmation)
+    CommandTrackerStats get_command_stats() { return _commands.get_stats(); }
+    
+    // Widgets dispatched to handlers
+    const WidgetRegistryStats& get_widget_stats() const { return _widgets.get_stats(); }
+    
 private:
     LaMarzoccoClient& _client;
     LaMarzoccoWebSocket& _websocket;
-    bool _power_state;
-    bool _steam_state;
+    // Requested vs. reported state per CommandKind, under _control_lock
+    struct ControlState {
+        bool reported;
+        bool desired;
+        bool pending;
+        uint32_t requested_ms;
+    };
+    ControlState _controls[COMMAND_KIND_COUNT];
+    uint32_t _control_version;
+    ControlStats _control_stats;
+    portMUX_TYPE _control_lock;
+    DashboardDiff _dashboard_diff;
+    DashboardParseStats _parse_stats;
+    MachineState _state;       // Last snapshot queued for the display
+    bool _state_valid;
+    uint32_t _first_dashboard_ms;
+    CommandTracker _commands;  // Sent commands awaiting their dashboard result
+    
+    // Dashboard widget handlers, dispatched by code
+    WidgetRegistry _widgets;
+    DashboardWidgets _handlers;
+    
+    // Follow the id in a command POST's response; without a response (the
+    // POST failed) the callback gets COMMAND_FAILED right away
+    void _track_command(CommandKind kind, bool value, JsonDocument* response,
+                        uint32_t requested_ms, CommandCallback callback, void* context);
+    
+    // A dashboard reported `on` for `kind`
+    void _report_control(CommandKind kind, bool on);
+    
+    // Roll back pending requests nothing has confirmed in time
+    void _expire_controls();
     
     // WebSocket message handler
-    static void _websocket_message_handler(const String& message);
+    static void _websocket_message_handler(const char* message, size_t length);
     static LaMarzoccoMachine* _instance;
 };
 
@@ -3,39 +3,157 @@
 #include <Arduino.h>
 #include <WebSocketsClient.h>
 #include "lamarzocco_client.h"
+#include "stomp_frame.h"
+#include "stomp_assembler.h"
+#include "stomp_capture.h"
+
+// Connection state machine: one attempt in flight at most, driven by loop()
+enum WebSocketState {
+    WS_STATE_IDLE = 0,           // Not started, or stopped by disconnect()
+    WS_STATE_TLS = 1,            // Token, signing, TLS handshake and HTTP upgrade
+    WS_STATE_STOMP_CONNECT = 2,  // CONNECT sent, waiting for CONNECTED
+    WS_STATE_SUBSCRIBED = 3,     // Dashboard subscription active
+    WS_STATE_BACKOFF = 4         // Waiting for the next attempt
+};
+
+// Steps of one connection attempt while in WS_STATE_TLS; loop() runs one
+// step per call so the heavy work is spread over several iterations
+enum WebSocketConnectStep {
+    WS_STEP_TOKEN = 0,      // Refresh the access token (HTTPS only when it is about to expire)
+    WS_STEP_SIGN = 1,       // Take signed installation key headers (pre-signed pool)
+    WS_STEP_BEGIN = 2,      // Heap check and beginSSL
+    WS_STEP_HANDSHAKE = 3   // Library drives TLS + HTTP upgrade
+};
+
+// loop() duration histogram: bucket i counts calls shorter than
+// WS_LOOP_HIST_BOUNDS_US[i], the last bucket counts everything slower
+#define WS_LOOP_HIST_BUCKETS 7
+static const uint32_t WS_LOOP_HIST_BOUNDS_US[WS_LOOP_HIST_BUCKETS - 1] = {
+    1000, 2000, 5000, 10000, 50000, 200000
+};
+
+// Why the link went down (last value is kept in the metrics)
+enum WebSocketReason {
+    WS_REASON_NONE = 0,
+    WS_REASON_AUTH_FAILED = 1,       // No access token / signature
+    WS_REASON_LOW_MEMORY = 2,        // Not enough heap for TLS
+    WS_REASON_TLS_TIMEOUT = 3,       // Handshake did not complete in time
+    WS_REASON_STOMP_TIMEOUT = 4,     // No CONNECTED frame in time
+    WS_REASON_DISCONNECTED = 5,      // Server or network closed the socket
+    WS_REASON_TRANSPORT_ERROR = 6,   // WebSocket error / send failure
+    WS_REASON_STOMP_ERROR = 7,       // Server sent a STOMP ERROR frame
+    WS_REASON_STALE_LINK = 8         // Nothing received within the stale timeout
+};
+
+// Decoder and connection counters (read from the main loop for status output)
+struct WebSocketMetrics {
+    uint32_t frames_decoded;
+    uint32_t decode_failures;
+    uint32_t decode_us_last;
+    uint32_t decode_us_max;
+    uint32_t heartbeats_sent;
+    uint32_t heartbeats_received;
+    uint32_t stale_link_reconnects;
+    uint32_t frames_reassembled;
+    uint32_t assembler_overflows;
+    uint32_t length_mismatches;
+    uint32_t connect_attempts;
+    uint32_t connect_successes;
+    uint32_t reconnect_ms_last;   // Link lost (or start) -> subscribed
+    uint32_t reconnect_ms_max;
+    WebSocketReason last_reason;
+    uint32_t loop_hist[WS_LOOP_HIST_BUCKETS];
+    uint32_t loop_us_max;
+    WebSocketState loop_max_state;  // State the slowest loop() ran in
+};
 
 class LaMarzoccoWebSocket {
 public:
     LaMarzoccoWebSocket(LaMarzoccoClient& client);
     ~LaMarzoccoWebSocket();
     
-    // Connect to websocket
+    // Start the connection controller; the first attempt runs from loop()
+    // Calling it again while the controller is running is a no-op
     bool connect(const String& serial_number);
     
-    // Disconnect
+    // Stop the controller and disconnect (no automatic reconnect afterwards)
     void disconnect();
     
-    // Check if connected
-    bool is_connected() const { return _connected; }
+    // Check if connected and subscribed
+    bool is_connected() const { return _state == WS_STATE_SUBSCRIBED; }
+    
+    // Feed a capture file (see stomp_capture.h) through the event handler,
+    // with pauses scaled by 1/speedup (0 = no pauses). Outbound frames are
+    // suppressed and the socket is left alone; the controller state and the
+    // connection metrics are restored afterwards, only the decoder counters
+    // include the replay. Call from the network task before the first loop().
+    bool replay(const char* path, uint32_t speedup);
+    
+    // Controller state
+    WebSocketState get_state() const { return _state; }
+    static const char* reason_name(WebSocketReason reason);
     
     // Loop (call in main loop or task)
     void loop();
     
     // Set callback for incoming messages
-    void set_message_callback(void (*callback)(const String& message));
+    // The body points into the WebSocket library's payload buffer and is only
+    // valid for the duration of the callback (it is not null-terminated).
+    void set_message_callback(void (*callback)(const char* body, size_t length));
+    
+    // Decoder metrics
+    const WebSocketMetrics& get_metrics() const { return _metrics; }
+    
+    // Milliseconds since the last inbound frame (data, heart-beat or pong)
+    unsigned long ms_since_last_rx() const { return millis() - _last_rx_ms; }
+    
+    // Negotiated heart-beat intervals in ms (0 = disabled)
+    uint32_t heartbeat_send_ms() const { return _hb_send_ms; }
+    uint32_t heartbeat_recv_ms() const { return _hb_recv_ms; }
     
 private:
     LaMarzoccoClient& _client;
     WebSocketsClient _ws;
-    bool _connected;
     String _serial_number;
     String _subscription_id;
     String _cached_token;  // Cache token before connecting to avoid accessing client in callback
-    void (*_message_callback)(const String& message);
+    void (*_message_callback)(const char* body, size_t length);
+    WebSocketMetrics _metrics;
+    
+    // Reconnect controller
+    WebSocketState _state;
+    unsigned long _state_since_ms;
+    unsigned long _next_attempt_ms;
+    unsigned long _outage_start_ms;
+    uint8_t _failures;  // Consecutive failed attempts (backoff exponent)
+    WebSocketConnectStep _step;
+    String _extra_headers;  // Signed upgrade headers, kept between steps
+    bool _replaying;        // Events come from a capture file, not the socket
+    
+    // Heart-beat / dead-link tracking
+    unsigned long _last_rx_ms;
+    unsigned long _last_tx_ms;
+    uint32_t _hb_send_ms;
+    uint32_t _hb_recv_ms;
+    uint32_t _stale_timeout_ms;
+    
+    // Reassembly of fragmented WebSocket messages / split STOMP frames
+    StompAssembler _assembler;
+    bool _fragment_is_text;
     
     // STOMP protocol helpers
     String _encode_stomp_message(const String& command, const String& headers, const String& body = "");
-    bool _decode_stomp_message(const String& message, String& command, String& headers, String& body);
+    void _handle_stomp_frame(const StompFrame& frame);
+    void _set_state(WebSocketState state);
+    void _attempt();
+    void _attempt_step();
+    void _loop_state();
+    void _enter_backoff(WebSocketReason reason);
+    size_t _process_stream(const char* data, size_t length, bool at_message_end);
+    void _append_to_assembler(const uint8_t* data, size_t length, bool at_message_end);
+    void _negotiate_heartbeat(const StompFrame& connected);
+    void _check_heartbeat();
+    bool _send_text(String& message);
     void _handle_websocket_event(WStype_t type, uint8_t* payload, size_t length);
     static void _ws_event_handler(WStype_t type, uint8_t* payload, size_t length);
     static LaMarzoccoWebSocket* _instance;
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "boiler_display.h"
+
+// Typed machine-state events produced by the network task and applied to
+// the display modules by Task_LVGL. Statuses arrive as enums from the
+// MachineState snapshot; target labels are copied into the event so nothing
+// points back into the (short-lived) WebSocket payload.
+
+typedef enum {
+    MACHINE_EVENT_WATER_ALARM = 0,
+    MACHINE_EVENT_BREWING = 1,
+    MACHINE_EVENT_BOILER = 2,
+    MACHINE_EVENT_BOILER_TARGET = 3
+} MachineEventType;
+
+typedef struct {
+    BoilerType boiler;
+    MachineStatus machine_status;
+    BoilerStatus boiler_status;
+    int64_t ready_start_time;
+} BoilerEvent;
+
+typedef struct {
+    BoilerType boiler;
+    char target_value[MACHINE_TARGET_LEN];
+} BoilerTargetEvent;
+
+typedef struct {
+    bool is_brewing;
+    int64_t brewing_start_time;
+} BrewingEvent;
+
+typedef struct {
+    bool active;
+} WaterAlarmEvent;
+
+typedef struct {
+    MachineEventType type;
+    union {
+        BoilerEvent boiler;
+        BoilerTargetEvent boiler_target;
+        BrewingEvent brewing;
+        WaterAlarmEvent water_alarm;
+    };
+} MachineEvent;
+
+typedef struct {
+    uint32_t pushed;
+    uint32_t applied;
+    uint32_t dropped;  // Ring was full (LVGL task not draining)
+} MachineEventStats;
+
+/**
+ * Queue an event for the LVGL task (network task only, never blocks)
+ *
+ * @return false if the queue was full and the event was dropped
+ */
+bool machine_events_push(const MachineEvent& event);
+
+/**
+ * Helpers that build and queue each event type
+ */
+bool machine_events_push_water_alarm(bool active);
+bool machine_events_push_brewing(bool is_brewing, int64_t brewing_start_time);
+bool machine_events_push_boiler(BoilerType boiler, MachineStatus machine_status,
+                                BoilerStatus boiler_status, int64_t ready_start_time);
+bool machine_events_push_boiler_target(BoilerType boiler, const char* target_value);
+
+/**
+ * Apply all queued events to the display modules
+ * Must be called from Task_LVGL with the GUI mutex held
+ */
+void machine_events_drain(void);
+
+/**
+ * Queue counters
+ */
+MachineEventStats machine_events_get_stats(void);
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Typed snapshot of what the display shows. Built once per dashboard message
+// from the widget handlers (see dashboard_widgets.h), which turn the status
+// strings into enums at the parse boundary so they are never compared again
+// downstream. The handler keeps the previous snapshot and only forwards the
+// fields that changed.
+
+typedef enum {
+    MACHINE_STATUS_UNKNOWN = 0,  // Widget or status missing
+    MACHINE_STATUS_OFF,
+    MACHINE_STATUS_STANDBY,
+    MACHINE_STATUS_POWERED_ON,
+    MACHINE_STATUS_BREWING,
+    MACHINE_STATUS_OTHER         // Any other "on" status reported by the cloud
+} MachineStatus;
+
+typedef enum {
+    BOILER_STATUS_UNKNOWN = 0,   // Widget or status missing
+    BOILER_STATUS_OFF,
+    BOILER_STATUS_STANDBY,
+    BOILER_STATUS_HEATING_UP,
+    BOILER_STATUS_READY,
+    BOILER_STATUS_NO_WATER,
+    BOILER_STATUS_OTHER
+} BoilerStatus;
+
+// Status strings sent by the cloud (see dashboard_codes.h for the lookup)
+#define MACHINE_STATUS_CODES(X)                 \
+    X(MACHINE_STATUS_OFF, "Off")                \
+    X(MACHINE_STATUS_STANDBY, "StandBy")        \
+    X(MACHINE_STATUS_POWERED_ON, "PoweredOn")   \
+    X(MACHINE_STATUS_BREWING, "Brewing")
+
+#define BOILER_STATUS_CODES(X)                  \
+    X(BOILER_STATUS_OFF, "Off")                 \
+    X(BOILER_STATUS_STANDBY, "StandBy")         \
+    X(BOILER_STATUS_HEATING_UP, "HeatingUp")    \
+    X(BOILER_STATUS_READY, "Ready")             \
+    X(BOILER_STATUS_NO_WATER, "NoWater")
+
+#define MACHINE_TARGET_LEN 16
+
+typedef struct {
+    BoilerStatus status;
+    int64_t ready_start_time;           // 0 if null / absent
+    char target[MACHINE_TARGET_LEN];    // "94°C" / "L2", empty if absent
+} BoilerSnapshot;
+
+typedef struct {
+    MachineStatus machine;
+    bool brewing;
+    int64_t brewing_start_time;         // 0 unless brewing
+    BoilerSnapshot boilers[2];          // Indexed by BoilerType
+    bool no_water;                      // CMNoWater alarm or a boiler reporting NoWater
+} MachineState;
+
+// Change mask bits returned by machine_state_diff()
+#define MACHINE_CHANGED_STATUS        (1u << 0)
+#define MACHINE_CHANGED_BREWING       (1u << 1)
+#define MACHINE_CHANGED_COFFEE        (1u << 2)  // Coffee boiler status / ready time
+#define MACHINE_CHANGED_STEAM         (1u << 3)  // Steam boiler status / ready time
+#define MACHINE_CHANGED_COFFEE_TARGET (1u << 4)
+#define MACHINE_CHANGED_STEAM_TARGET  (1u << 5)
+#define MACHINE_CHANGED_NO_WATER      (1u << 6)
+#define MACHINE_CHANGED_ALL           0x7Fu
+
+/**
+ * Map cloud status strings to enums (NULL / empty gives UNKNOWN)
+ */
+MachineStatus machine_status_from_string(const char* status);
+BoilerStatus boiler_status_from_string(const char* status);
+
+/**
+ * Names for logging
+ */
+const char* machine_status_name(MachineStatus status);
+const char* boiler_status_name(BoilerStatus status);
+
+/**
+ * True for every known status except Off and StandBy
+ */
+bool machine_status_is_on(MachineStatus status);
+
+/**
+ * Fields that differ between two snapshots
+ *
+ * @return Mask of MACHINE_CHANGED_* bits (0 if identical)
+ */
+uint32_t machine_state_diff(const MachineState& previous, const MachineState& current);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "lamarzocco_auth.h"
+#include "config.h"
+
+// One set of signed request headers (X-App-Installation-Id, X-Timestamp,
+// X-Nonce, X-Request-Signature). Each set carries a unique nonce and must be
+// used for a single request only.
+struct SignedHeaders {
+    String installation_id;
+    String timestamp;
+    String nonce;
+    String signature;
+    unsigned long created_ms;
+};
+
+struct SignedHeaderPoolStats {
+    uint32_t hits;          // Served from the pool
+    uint32_t misses;        // Pool empty, signed on the caller's thread
+    uint32_t expired;       // Dropped unused after SIGNED_HEADER_MAX_AGE_MS
+    uint32_t signed_sets;   // Signatures produced (background + inline)
+    uint32_t sign_us_last;
+    uint32_t sign_us_avg;
+    uint64_t saved_us;      // hits x average signing time
+};
+
+// Small pool of pre-signed header sets refilled by a low-priority background
+// task, so reconnects and REST calls do not pay for the ECDSA signature.
+// Thread-safe: take() may be called from any task.
+class SignedHeaderPool {
+public:
+    SignedHeaderPool();
+    ~SignedHeaderPool();
+
+    // Set the installation key and start the signer task (first call only)
+    void begin(const InstallationKey& key);
+
+    // Pop a fresh set, or sign one inline if the pool is empty.
+    // Returns false only if signing failed.
+    bool take(SignedHeaders& headers);
+
+    SignedHeaderPoolStats get_stats();
+
+private:
+    SemaphoreHandle_t _mutex;
+    TaskHandle_t _task;
+    InstallationKey _key;
+    bool _has_key;
+    SignedHeaders _sets[SIGNED_HEADER_POOL_SIZE];
+    size_t _count;
+    SignedHeaderPoolStats _stats;
+    uint64_t _sign_us_total;
+
+    bool _sign(SignedHeaders& headers);
+    void _drop_expired();
+    void _refill();
+    static void _task_main(void* arg);
+};
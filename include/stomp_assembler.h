@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bounded reassembly buffer for STOMP frames that span several WebSocket
+// messages or fragments. Storage lives in PSRAM when available and is
+// allocated on first use. Bytes are kept contiguous (consumed bytes are
+// compacted away) so decoded frames can still be handed out as spans.
+class StompAssembler {
+public:
+    explicit StompAssembler(size_t capacity);
+    ~StompAssembler();
+    
+    // Append bytes; returns false (and drops everything buffered) if the
+    // pending frame would exceed the capacity
+    bool append(const uint8_t* data, size_t length);
+    
+    // Drop bytes from the front once frames have been handled
+    void consume(size_t length);
+    
+    // Discard all buffered bytes (e.g. on disconnect)
+    void reset() { _size = 0; }
+    
+    const char* data() const { return _buffer; }
+    size_t size() const { return _size; }
+    size_t capacity() const { return _capacity; }
+    
+private:
+    char* _buffer;
+    size_t _capacity;
+    size_t _size;
+};
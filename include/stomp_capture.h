@@ -0,0 +1,77 @@
+#pragma once
+
+#include <Arduino.h>
+#ifdef ARDUINO
+#include <FS.h>
+#else
+#include <stdio.h>
+#endif
+
+// Binary capture of inbound WebSocket events for offline replay.
+//
+// File layout (little endian):
+//   "LMZC" magic, uint8_t version, 3 reserved bytes
+//   records: StompCaptureRecord header followed by `length` payload bytes
+//
+// In serial mode each record (header + payload) is printed base64-encoded on
+// its own "[CAP] " line so it survives being interleaved with the log;
+// tools/capture_from_log.py turns such a log back into a capture file.
+//
+// On the device capture files live on SPIFFS. The host build (bench) uses
+// plain files, so a capture pulled off the device replays there as well.
+
+#define STOMP_CAPTURE_VERSION 1
+
+struct __attribute__((packed)) StompCaptureRecord {
+    uint32_t rx_ms;    // Receive time relative to the start of the capture
+    uint8_t type;      // WStype_t of the event
+    uint32_t length;   // Payload bytes that follow
+};
+
+struct StompCaptureStats {
+    uint32_t records;
+    uint32_t bytes;
+    uint32_t dropped;  // Not written (size limit reached or write error)
+};
+
+/**
+ * Start capturing (STOMP_CAPTURE_MODE 1: truncates STOMP_CAPTURE_PATH)
+ * No-op when STOMP_CAPTURE_MODE is 0
+ */
+void stomp_capture_begin(void);
+
+/**
+ * Append one event (network task only)
+ */
+void stomp_capture_record(uint8_t type, const uint8_t* payload, size_t length);
+
+/**
+ * Flush and close the capture file. Also called once STOMP_CAPTURE_MAX_BYTES
+ * is reached, so the file stays complete.
+ */
+void stomp_capture_end(void);
+
+StompCaptureStats stomp_capture_get_stats(void);
+
+// Sequential reader for a capture file
+class StompCaptureReader {
+public:
+    StompCaptureReader();
+    ~StompCaptureReader();
+
+    bool open(const char* path);
+    void close();
+
+    // Read the next record; payload stays valid until the next call and is
+    // null-terminated (as the WebSocket library does for text messages)
+    bool next(StompCaptureRecord& record, uint8_t*& payload);
+
+private:
+#ifdef ARDUINO
+    File _file;
+#else
+    FILE* _file;
+#endif
+    uint8_t* _buffer;
+    size_t _capacity;
+};
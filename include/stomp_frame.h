@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Maximum number of headers kept per frame (the server sends 5 on MESSAGE)
+#define STOMP_MAX_HEADERS 12
+
+// Non-owning view into a byte buffer (not null-terminated)
+struct StompSpan {
+    const char* data;
+    size_t length;
+
+    // Compare against a null-terminated string
+    bool equals(const char* str) const;
+};
+
+struct StompHeader {
+    StompSpan name;
+    StompSpan value;
+};
+
+// Decoded STOMP frame.
+// All spans point into the buffer passed to stomp_parse() and are only
+// valid for as long as that buffer is (i.e. during the WebSocket event).
+struct StompFrame {
+    StompSpan command;
+    StompHeader headers[STOMP_MAX_HEADERS];
+    size_t header_count;
+    StompSpan body;
+    bool length_mismatch;  // content-length disagreed with the null terminator
+
+    // Look up a header value by name (first occurrence wins, as per STOMP 1.2)
+    bool header(const char* name, StompSpan& value) const;
+};
+
+enum StompParseResult {
+    STOMP_PARSE_FRAME = 0,       // A complete frame was decoded
+    STOMP_PARSE_INCOMPLETE = 1,  // More bytes are needed
+    STOMP_PARSE_HEARTBEAT = 2,   // Only EOLs (heart-beats) were consumed
+    STOMP_PARSE_INVALID = 3      // Unparseable bytes were skipped
+};
+
+// Parse the next STOMP frame from a byte stream: COMMAND\nHEADERS\n\nBODY\x00
+// Does not allocate. The body is content-length bytes when that header is
+// present, otherwise it ends at the next null byte. at_message_end tells the
+// parser that no more bytes follow (end of a WebSocket message), so a frame
+// without a null terminator is still accepted as it used to be.
+// consumed is set to the number of bytes to drop before the next call.
+StompParseResult stomp_parse(const char* data, size_t length, bool at_message_end,
+                             StompFrame& frame, size_t& consumed);
+
+// Parse an unsigned decimal span (e.g. content-length), returns false on garbage
+bool stomp_parse_uint(const StompSpan& span, size_t& value);
+
+// Parse a heart-beat header value "x,y" (milliseconds)
+bool stomp_parse_heartbeat(const StompSpan& span, uint32_t& x, uint32_t& y);
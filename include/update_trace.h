@@ -0,0 +1,120 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// End-to-end latency of dashboard updates, from the WebSocket payload to the
+// last pixel pushed to the panel. The network task stamps the first stages
+// of the message it is handling; when the message queued display events the
+// trace is handed to Task_LVGL with them, which stamps the rest and closes it
+// when disp_flush() pushes the last area of the next refresh.
+//
+// Stage deltas and the total go into histograms (serial status report and
+// GET /latency). Cloud delay compares brewingStartTime / readyStartTime from
+// the payload with the wall-clock time the message arrived.
+
+enum TraceStage {
+    TRACE_WS_RX = 0,          // WebSocket TEXT payload received
+    TRACE_STOMP_DECODED,      // MESSAGE frame decoded, body handed to the handler
+    TRACE_JSON_PARSED,        // Widgets parsed and dispatched
+    TRACE_STATE_QUEUED,       // State diffed, display events queued
+    TRACE_STATE_APPLIED,      // Task_LVGL picked the events up (queue + mutex wait)
+    TRACE_LVGL_INVALIDATED,   // Display modules applied them, areas invalidated
+    TRACE_FLUSHED,            // disp_flush() pushed the last area
+    TRACE_STAGE_COUNT
+};
+
+// Histograms kept: one per stage transition, the total, and cloud delays
+enum TraceSpan {
+    TRACE_SPAN_DECODE = 0,    // WS_RX -> STOMP_DECODED
+    TRACE_SPAN_PARSE,         // STOMP_DECODED -> JSON_PARSED
+    TRACE_SPAN_STATE,         // JSON_PARSED -> STATE_QUEUED
+    TRACE_SPAN_QUEUE,         // STATE_QUEUED -> STATE_APPLIED
+    TRACE_SPAN_APPLY,         // STATE_APPLIED -> LVGL_INVALIDATED
+    TRACE_SPAN_RENDER,        // LVGL_INVALIDATED -> FLUSHED
+    TRACE_SPAN_TOTAL,         // WS_RX -> FLUSHED
+    TRACE_SPAN_CLOUD_BREWING, // brewingStartTime -> message received
+    TRACE_SPAN_CLOUD_READY,   // readyStartTime (boiler turned Ready) -> message received
+    TRACE_SPAN_COUNT
+};
+
+// Bucket i counts samples shorter than TRACE_HIST_BOUNDS_US[i], the last
+// bucket counts everything slower
+#define TRACE_HIST_BUCKETS 13
+static const uint32_t TRACE_HIST_BOUNDS_US[TRACE_HIST_BUCKETS - 1] = {
+    500, 1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000, 500000, 1000000, 5000000
+};
+
+struct TraceHistogram {
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t buckets[TRACE_HIST_BUCKETS];
+};
+
+struct UpdateTraceStats {
+    uint32_t completed;       // Traces that reached disp_flush()
+    uint32_t no_redraw;       // Events applied but nothing was invalidated
+    uint32_t superseded;      // A newer message was handed off before the flush
+    uint32_t handoff_dropped; // Hand-off ring full
+    uint32_t clock_skew;      // Cloud delay came out negative (NTP not in sync)
+};
+
+// --- Network task ---
+
+/**
+ * Start tracing the WebSocket payload being handled (stamps TRACE_WS_RX)
+ */
+void update_trace_begin();
+
+/**
+ * Stamp a network-side stage of the current trace
+ */
+void update_trace_mark(TraceStage stage);
+
+/**
+ * Wall-clock time the current message arrived (Unix ms, 0 if unknown)
+ */
+int64_t update_trace_received_ms();
+
+/**
+ * Record cloud delay: `event_ms` is a cloud timestamp (Unix ms) for something
+ * the current message reports
+ */
+void update_trace_cloud(TraceSpan span, int64_t event_ms);
+
+/**
+ * Close the network side. With `queued` the trace follows the display events
+ * to Task_LVGL; otherwise only the network stages are recorded.
+ */
+void update_trace_end(bool queued);
+
+// --- Task_LVGL ---
+
+/**
+ * Call before machine_events_drain(): picks up traces whose events are queued
+ */
+void update_trace_apply_begin();
+
+/**
+ * Call after machine_events_drain(): stamps TRACE_LVGL_INVALIDATED.
+ * Without `invalidated` (no areas to redraw) the trace ends here.
+ */
+void update_trace_apply_end(bool invalidated);
+
+/**
+ * Called from disp_flush() once the last area of a refresh is pushed
+ */
+void update_trace_flushed();
+
+// --- Readers ---
+
+const TraceHistogram& update_trace_histogram(TraceSpan span);
+const char* update_trace_span_name(TraceSpan span);
+const UpdateTraceStats& update_trace_get_stats();
+
+/**
+ * Log the counters and every non-empty histogram, one info line each, under
+ * `module` (app_log_write: not gated by a module level)
+ */
+void update_trace_print(const char* module);
@@ -1,3 +1,6 @@
 #pragma once
 
-void setupWEB(void);
\ No newline at end of file
+void setupWEB(void);
+
+// Status endpoints (GET /latency) while connected to the machine
+void setupStatusWEB(void);
@@ -12,4 +12,5 @@ void restartHander(void);
 void handleNotFound(void);
 void saveWifiHandler(void);
 void saveCloudHandler(void);
-void saveMachineHandler(void);
\ No newline at end of file
+void saveMachineHandler(void);
+void latencyHandler(void);
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "dashboard_codes.h"
+
+// Per-widget dashboard handlers.
+//
+// The parser walks the "widgets" array once and hands each widget's
+// "output" object to the handler registered for its code; codes without a
+// handler are skipped unread. Every handler keeps its own state, compares it
+// with what the previous frame produced and reports whether it changed.
+// Widgets missing from a frame are cleared in end_frame().
+
+static_assert(WIDGET_CODE_COUNT <= 32, "widget code masks are 32 bits");
+
+// Read-only view of one widget's "output" object, independent of the JSON
+// engine. Paths are dot-separated keys; array elements are numeric segments,
+// e.g. "times.PreBrewing.0.seconds.In". Getters return false if the value is
+// missing, null or of another type, and leave `out` untouched.
+class WidgetOutput {
+public:
+    virtual ~WidgetOutput() {}
+    virtual bool get_string(const char* path, char* out, size_t size) const = 0;
+    virtual bool get_int(const char* path, int64_t& out) const = 0;
+    virtual bool get_float(const char* path, float& out) const = 0;
+    virtual bool get_bool(const char* path, bool& out) const = 0;
+};
+
+class WidgetHandler {
+public:
+    virtual ~WidgetHandler() {}
+
+    // Widget `code` is in the frame: read its output. Returns true if the state changed.
+    virtual bool update(DashboardWidgetCode code, const WidgetOutput& output) = 0;
+
+    // Widget `code` is not in the frame. Returns true if the state changed.
+    virtual bool clear(DashboardWidgetCode code) = 0;
+
+    // Output paths read by update(), null-terminated (used to build the JSON filter)
+    virtual const char* const* fields() const = 0;
+
+    // Log the current state of widget `code`
+    virtual void print(DashboardWidgetCode code) const = 0;
+};
+
+// Handler for a single widget whose state is a plain struct. Change
+// detection is a memcmp of the zero-initialised structs, so read() only has
+// to fill in what it finds.
+template <typename State>
+class StatefulWidget : public WidgetHandler {
+public:
+    StatefulWidget() : _present(false) { memset(&_state, 0, sizeof(_state)); }
+
+    const State& state() const { return _state; }
+    bool present() const { return _present; }
+
+    bool update(DashboardWidgetCode, const WidgetOutput& output) override {
+        State next;
+        memset(&next, 0, sizeof(next));
+        read(output, next);
+        return _commit(next, true);
+    }
+
+    bool clear(DashboardWidgetCode) override {
+        State next;
+        memset(&next, 0, sizeof(next));
+        return _commit(next, false);
+    }
+
+protected:
+    virtual void read(const WidgetOutput& output, State& state) = 0;
+
+private:
+    State _state;
+    bool _present;
+
+    bool _commit(const State& next, bool present) {
+        bool changed = present != _present || memcmp(&next, &_state, sizeof(State)) != 0;
+        memcpy(&_state, &next, sizeof(State));  // Copies padding too, for the next memcmp
+        _present = present;
+        return changed;
+    }
+};
+
+struct WidgetRegistryStats {
+    uint32_t dispatched;   // Widgets handed to a handler
+    uint32_t changed;      // ... whose state changed (including removals)
+    uint32_t unhandled;    // Widgets with an unknown / unregistered code
+};
+
+class WidgetRegistry {
+public:
+    WidgetRegistry();
+
+    // One handler per code; a handler may serve several codes
+    bool add(DashboardWidgetCode code, WidgetHandler& handler);
+
+    WidgetHandler* find(DashboardWidgetCode code) const {
+        return code < WIDGET_CODE_COUNT ? _handlers[code] : nullptr;
+    }
+
+    // Frame protocol: begin_frame(), dispatch() per widget, end_frame()
+    void begin_frame();
+    void dispatch(DashboardWidgetCode code, const WidgetOutput& output);
+    void end_frame();
+
+    // Did widget `code` change in the last frame?
+    bool changed(DashboardWidgetCode code) const { return (_changed >> code) & 1u; }
+
+    // Print every registered widget that changed in the last frame
+    void print_changed() const;
+
+    const WidgetRegistryStats& get_stats() const { return _stats; }
+
+private:
+    WidgetHandler* _handlers[WIDGET_CODE_COUNT];
+    uint32_t _seen;
+    uint32_t _changed;
+    WidgetRegistryStats _stats;
+};
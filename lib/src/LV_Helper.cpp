@@ -20,6 +20,7 @@ static lv_indev_t  *kb_indev = NULL;
 static lv_indev_drv_t indev_mouse;
 static lv_indev_drv_t indev_keypad;
 static struct InputParams params_copy;
+static void (*flush_done_cb)(void) = NULL;
 
 /* Display flushing */
 static void disp_flush( lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p )
@@ -27,7 +28,11 @@ static void disp_flush( lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color
     uint32_t w = ( area->x2 - area->x1 + 1 );
     uint32_t h = ( area->y2 - area->y1 + 1 );
     static_cast<LilyGo_Display *>(disp_drv->user_data)->pushColors(area->x1, area->y1, w, h, (uint16_t *)color_p);
+    bool last = lv_disp_flush_is_last( disp_drv );
     lv_disp_flush_ready( disp_drv );
+    if (last && flush_done_cb) {
+        flush_done_cb();
+    }
 }
 
 /*Read the touchpad*/
@@ -152,6 +157,11 @@ void beginLvglHelper(LilyGo_Display &board, bool debug)
     lv_group_set_default(lv_group_create());
 }
 
+void setLvglFlushDoneCallback(void (*cb)(void))
+{
+    flush_done_cb = cb;
+}
+
 void beginLvglInputDevice(struct InputParams prams)
 {
     memcpy(&params_copy, &prams, sizeof(struct InputParams));
@@ -17,4 +17,7 @@ void beginLvglHelper(LilyGo_Display &board, bool debug = false);
 
 void beginLvglInputDevice(struct InputParams prams);
 
+/* Called from the flush callback once the last area of a refresh is on the panel */
+void setLvglFlushDoneCallback(void (*cb)(void));
+
 
@@ -23,6 +23,7 @@ static lv_color16_t *buf1  = NULL;
 static lv_indev_t  *mouse_indev = NULL;
 static lv_indev_t  *kb_indev = NULL;
 static struct InputParams params_copy;
+static void (*flush_done_cb)(void) = NULL;
 
 static void disp_flush( lv_display_t *disp_drv, const lv_area_t *area, uint8_t *color_p)
 {
@@ -31,7 +32,11 @@ static void disp_flush( lv_display_t *disp_drv, const lv_area_t *area, uint8_t *
     auto *plane = (LilyGo_Display *)lv_display_get_user_data(disp_drv);
     lv_draw_sw_rgb565_swap(color_p, w * h * 2);
     plane->pushColors(area->x1, area->y1, w, h, (uint16_t *)color_p);
+    bool last = lv_display_flush_is_last( disp_drv );
     lv_display_flush_ready( disp_drv );
+    if (last && flush_done_cb) {
+        flush_done_cb();
+    }
 }
 
 /*Read the touchpad*/
@@ -150,6 +155,11 @@ void beginLvglHelper(LilyGo_Display &board, bool debug)
     lv_group_set_default(lv_group_create());
 }
 
+void setLvglFlushDoneCallback(void (*cb)(void))
+{
+    flush_done_cb = cb;
+}
+
 void beginLvglInputDevice(struct InputParams prams)
 {
     memcpy(&params_copy, &prams, sizeof(struct InputParams));
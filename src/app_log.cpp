@@ -0,0 +1,164 @@
+#include "app_log.h"
+#include <Arduino.h>
+#include <atomic>
+#include <stdio.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static_assert(APP_LOG_RING_SLOTS >= 2 && (APP_LOG_RING_SLOTS & (APP_LOG_RING_SLOTS - 1)) == 0,
+              "APP_LOG_RING_SLOTS must be a power of two");
+
+#if APP_LOG_ASYNC
+// Bounded multi-producer ring (Vyukov): a slot's sequence says whose turn it
+// is. sequence == pos: free for the producer that claims pos.
+// sequence == pos + 1: line ready for the drain task.
+struct LogSlot {
+    std::atomic<uint32_t> sequence;
+    uint32_t time_ms;
+    uint8_t level;
+    const char* module;
+    char text[APP_LOG_LINE_LEN];
+};
+
+class LogRing {
+public:
+    LogRing() : enqueue_pos(0), dequeue_pos(0) {
+        for (uint32_t i = 0; i < APP_LOG_RING_SLOTS; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    LogSlot slots[APP_LOG_RING_SLOTS];
+    std::atomic<uint32_t> enqueue_pos;
+    std::atomic<uint32_t> dequeue_pos;   // Written by the drain task only
+};
+
+static LogRing g_ring;
+static TaskHandle_t g_task = NULL;
+#endif
+
+static std::atomic<uint32_t> g_written(0);
+static std::atomic<uint32_t> g_dropped(0);
+static std::atomic<uint32_t> g_truncated(0);
+static std::atomic<uint32_t> g_high_water(0);  // Approximate: load and store, no CAS
+
+static char level_letter(uint8_t level) {
+    static const char LETTERS[] = "-EWIDV";
+    return level <= APP_LOG_VERBOSE ? LETTERS[level] : '?';
+}
+
+static void print_line(uint8_t level, uint32_t time_ms, const char* module, const char* text) {
+    Serial.printf("%c (%lu) %s: %s\n", level_letter(level), (unsigned long)time_ms, module, text);
+}
+
+#if APP_LOG_ASYNC
+static void Task_Log(void* pvParameters) {
+    uint32_t pos = 0;
+    uint32_t dropped_reported = 0;
+    while (1) {
+        LogSlot& slot = g_ring.slots[pos & (APP_LOG_RING_SLOTS - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+            uint32_t dropped = g_dropped.load(std::memory_order_relaxed);
+            if (dropped != dropped_reported) {
+                Serial.printf("W (%lu) LOG: %u lines dropped\n", millis(), dropped - dropped_reported);
+                dropped_reported = dropped;
+            }
+            vTaskDelay(pdMS_TO_TICKS(APP_LOG_DRAIN_MS));
+            continue;
+        }
+        print_line(slot.level, slot.time_ms, slot.module, slot.text);
+        slot.sequence.store(pos + APP_LOG_RING_SLOTS, std::memory_order_release);
+        pos++;
+        g_ring.dequeue_pos.store(pos, std::memory_order_release);
+    }
+}
+
+#endif
+
+void app_log_begin() {
+#if APP_LOG_ASYNC
+    if (g_task) {
+        return;
+    }
+    // Below the network (2) and LVGL (3) tasks: lines go out when nothing else runs
+    xTaskCreatePinnedToCore(Task_Log,
+                            "Task_Log",
+                            1024 * 4,
+                            NULL,
+                            1,
+                            &g_task,
+                            1);
+#endif
+}
+
+void app_log_vwrite(uint8_t level, const char* module, const char* fmt, va_list args) {
+#if APP_LOG_ASYNC
+    uint32_t pos = g_ring.enqueue_pos.load(std::memory_order_relaxed);
+    LogSlot* slot;
+    while (1) {
+        slot = &g_ring.slots[pos & (APP_LOG_RING_SLOTS - 1)];
+        int32_t turn = (int32_t)(slot->sequence.load(std::memory_order_acquire) - pos);
+        if (turn == 0) {
+            if (g_ring.enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (turn < 0) {
+            // Drain task is a full ring behind
+            g_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = g_ring.enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->time_ms = millis();
+    slot->level = level;
+    slot->module = module;
+    int written = vsnprintf(slot->text, sizeof(slot->text), fmt, args);
+    if (written >= (int)sizeof(slot->text)) {
+        g_truncated.fetch_add(1, std::memory_order_relaxed);
+    }
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    g_written.fetch_add(1, std::memory_order_relaxed);
+    uint32_t waiting = pos + 1 - g_ring.dequeue_pos.load(std::memory_order_acquire);
+    if (waiting > g_high_water.load(std::memory_order_relaxed)) {
+        g_high_water.store(waiting, std::memory_order_relaxed);
+    }
+#else
+    // Synchronous: the line is out before the call returns (crash debugging)
+    char text[APP_LOG_LINE_LEN];
+    int written = vsnprintf(text, sizeof(text), fmt, args);
+    if (written >= (int)sizeof(text)) {
+        g_truncated.fetch_add(1, std::memory_order_relaxed);
+    }
+    g_written.fetch_add(1, std::memory_order_relaxed);
+    print_line(level, millis(), module, text);
+#endif
+}
+
+void app_log_write(uint8_t level, const char* module, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    app_log_vwrite(level, module, fmt, args);
+    va_end(args);
+}
+
+AppLogStats app_log_get_stats() {
+    AppLogStats stats;
+    stats.written = g_written.load(std::memory_order_relaxed);
+    stats.dropped = g_dropped.load(std::memory_order_relaxed);
+    stats.truncated = g_truncated.load(std::memory_order_relaxed);
+    stats.high_water = g_high_water.load(std::memory_order_relaxed);
+    return stats;
+}
+
+uint32_t app_log_pending() {
+#if APP_LOG_ASYNC
+    // dequeue_pos first: it never passes an enqueue_pos read after it
+    uint32_t dequeued = g_ring.dequeue_pos.load(std::memory_order_acquire);
+    return g_ring.enqueue_pos.load(std::memory_order_relaxed) - dequeued;
+#else
+    return 0;
+#endif
+}
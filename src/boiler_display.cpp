@@ -1,6 +1,7 @@
 #include "boiler_display.h"
 #include "brewing_display.h"
 #include "water_alarm.h"  // Need to check water alarm state
+#include "app_log.h"
 #include "ui/ui.h"
 #include <Arduino.h>
 #include <string.h>
@@ -9,15 +10,6 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 
-// Debug output
-#define DEBUG_BOILER 1
-#if DEBUG_BOILER
-#define boiler_debug(x) Serial.print(x)
-#define boiler_debugln(x) Serial.println(x)
-#else
-#define boiler_debug(x)
-#define boiler_debugln(x)
-#endif
 
 // Global boiler information
 static BoilerInfo g_boilers[2];
@@ -37,15 +29,16 @@ static void restart_update_timer(void);
 static const char* boiler_type_name(BoilerType type);
 
 // Helper macro for mutex protection
-#define TAKE_MUTEX() if (g_gui_mutex && xSemaphoreTake(g_gui_mutex, pdMS_TO_TICKS(100)) == pdTRUE)
-#define GIVE_MUTEX() if (g_gui_mutex) xSemaphoreGive(g_gui_mutex)
+// The GUI mutex is recursive: events are applied from Task_LVGL while it already holds it
+#define TAKE_MUTEX() if (g_gui_mutex && xSemaphoreTakeRecursive(g_gui_mutex, pdMS_TO_TICKS(100)) == pdTRUE)
+#define GIVE_MUTEX() if (g_gui_mutex) xSemaphoreGiveRecursive(g_gui_mutex)
 
 /**
  * Set the GUI mutex for thread-safe LVGL access
  */
 void boiler_display_set_mutex(void* mutex) {
     g_gui_mutex = (SemaphoreHandle_t)mutex;
-    boiler_debugln("[Boiler] Mutex set for thread-safe operation");
+    APP_LOGD(BOILER, "Mutex set for thread-safe operation");
 }
 
 /**
@@ -53,11 +46,11 @@ void boiler_display_set_mutex(void* mutex) {
  */
 void boiler_display_init(void) {
     if (g_initialized) {
-        boiler_debugln("[Boiler] Already initialized");
+        APP_LOGD(BOILER, "Already initialized");
         return;
     }
     
-    boiler_debugln("[Boiler] Initializing boiler display system...");
+    APP_LOGD(BOILER, "Initializing boiler display system...");
     
     // Initialize Coffee Boiler (left arc)
     g_boilers[BOILER_COFFEE].type = BOILER_COFFEE;
@@ -85,7 +78,29 @@ void boiler_display_init(void) {
     g_timer_paused = true;
     
     g_initialized = true;
-    boiler_debugln("[Boiler] Initialization complete");
+    APP_LOGD(BOILER, "Initialization complete");
+}
+
+/**
+ * Update a boiler's target temperature/level label
+ */
+void boiler_display_set_target(BoilerType type, const char* target_value) {
+    if (!g_initialized || target_value == NULL || target_value[0] == '\0') {
+        return;
+    }
+    
+    TAKE_MUTEX() {
+        if (type == BOILER_COFFEE) {
+            // Coffee boiler: display temperature (e.g., "94°C")
+            lv_label_set_text(ui_CoffeeTempLabel, target_value);
+            APP_LOGD(BOILER, "Coffee target temp: %s", target_value);
+        } else if (type == BOILER_STEAM) {
+            // Steam boiler: display level (e.g., "L2" for Level2)
+            lv_label_set_text(ui_BoilerTempLabel, target_value);
+            APP_LOGD(BOILER, "Steam target level: %s", target_value);
+        }
+        GIVE_MUTEX();
+    }
 }
 
 /**
@@ -96,70 +111,41 @@ void boiler_display_init(void) {
  * - Machine ON + readyStartTime is null/0 → Display "READY", arc at 100% (already ready)
  * - Machine ON + readyStartTime is valid → Display countdown, arc shows progress
  */
-void boiler_display_update(BoilerType type, const char* machine_status, 
-                           const char* boiler_status, int64_t ready_start_time,
-                           const char* target_value) {
+void boiler_display_update(BoilerType type, MachineStatus machine_status, 
+                           BoilerStatus boiler_status, int64_t ready_start_time) {
     if (!g_initialized) {
-        boiler_debugln("[Boiler] ERROR: Not initialized!");
+        APP_LOGE(BOILER, "Not initialized!");
         return;
     }
     
-    // Update temperature/level label (with mutex protection)
-    if (target_value != NULL && strlen(target_value) > 0) {
-        TAKE_MUTEX() {
-            if (type == BOILER_COFFEE) {
-                // Coffee boiler: display temperature (e.g., "94°C")
-                lv_label_set_text(ui_CoffeeTempLabel, target_value);
-                boiler_debug("[Coffee] Target temp: ");
-                boiler_debugln(target_value);
-            } else if (type == BOILER_STEAM) {
-                // Steam boiler: display level (e.g., "L2" for Level2)
-                lv_label_set_text(ui_BoilerTempLabel, target_value);
-                boiler_debug("[Steam] Target level: ");
-                boiler_debugln(target_value);
-            }
-            GIVE_MUTEX();
-        }
-    }
-    
     if (type >= 2) {
-        boiler_debugln("[Boiler] ERROR: Invalid boiler type!");
+        APP_LOGE(BOILER, "Invalid boiler type!");
         return;
     }
     
     BoilerInfo* boiler = &g_boilers[type];
     
-    boiler_debug("[");
-    boiler_debug(boiler_type_name(type));
-    boiler_debug("] Update - Machine: ");
-    boiler_debug(machine_status);
-    boiler_debug(", Boiler: ");
-    boiler_debug(boiler_status);
-    boiler_debug(", TargetReadyTime: ");
-    boiler_debugln((long long)ready_start_time);
+    APP_LOGD(BOILER, "%s update - Machine: %s, Boiler: %s, TargetReadyTime: %lld",
+             boiler_type_name(type), machine_status_name(machine_status),
+             boiler_status_name(boiler_status), (long long)ready_start_time);
     
     // If we have a valid ready time, show when it will be ready in local timezone
     // Note: ready_start_time is the timestamp when boiler WILL BE ready (target time)
-    if (ready_start_time > 0) {
+    if (APP_LOG_ENABLED(BOILER, APP_LOG_DEBUG) && ready_start_time > 0) {
         time_t ready_time_sec = (time_t)(ready_start_time / 1000);  // Convert ms to seconds
         struct tm timeinfo;
         localtime_r(&ready_time_sec, &timeinfo);  // Convert to local timezone
         
         char time_str[32];
         strftime(time_str, sizeof(time_str), "%H:%M:%S", &timeinfo);
-        boiler_debug("  ✓ Ready at: ");
-        boiler_debug(time_str);
-        boiler_debug(" local time");
-        boiler_debugln();
+        APP_LOGD(BOILER, "  ✓ Ready at: %s local time", time_str);
     }
     
     // Check machine status first
-    if (strcmp(machine_status, "Off") == 0 || strcmp(machine_status, "StandBy") == 0) {
+    if (!machine_status_is_on(machine_status)) {
         // Machine is OFF or in StandBy - set boiler to OFF
         if (boiler->state != BOILER_STATE_OFF) {
-            boiler_debug("[");
-            boiler_debug(boiler_type_name(type));
-            boiler_debugln("] -> OFF (machine off/standby)");
+            APP_LOGD(BOILER, "%s -> OFF (machine off/standby)", boiler_type_name(type));
             set_boiler_off(boiler);
             restart_update_timer();  // Recalculate timer period
         }
@@ -167,12 +153,10 @@ void boiler_display_update(BoilerType type, const char* machine_status,
     }
     
     // Check if boiler itself is OFF or StandBy (e.g., steam boiler disabled while machine is on)
-    if (strcmp(boiler_status, "Off") == 0 || strcmp(boiler_status, "StandBy") == 0) {
+    if (boiler_status == BOILER_STATUS_OFF || boiler_status == BOILER_STATUS_STANDBY) {
         // Boiler is disabled - set to OFF
         if (boiler->state != BOILER_STATE_OFF) {
-            boiler_debug("[");
-            boiler_debug(boiler_type_name(type));
-            boiler_debugln("] -> OFF (boiler disabled)");
+            APP_LOGD(BOILER, "%s -> OFF (boiler disabled)", boiler_type_name(type));
             set_boiler_off(boiler);
             restart_update_timer();  // Recalculate timer period
         }
@@ -180,19 +164,15 @@ void boiler_display_update(BoilerType type, const char* machine_status,
     }
     
     // Check if boiler status is explicitly "Ready"
-    if (strcmp(boiler_status, "Ready") == 0) {
+    if (boiler_status == BOILER_STATUS_READY) {
         // Boiler is READY - set to READY state immediately
         if (boiler->state != BOILER_STATE_READY) {
-            boiler_debug("[");
-            boiler_debug(boiler_type_name(type));
-            boiler_debugln("] -> READY (status is Ready)");
+            APP_LOGD(BOILER, "%s -> READY (status is Ready)", boiler_type_name(type));
             set_boiler_ready(boiler);
             restart_update_timer();
         } else {
             // Already in READY state, but force update display to ensure it's current
-            boiler_debug("[");
-            boiler_debug(boiler_type_name(type));
-            boiler_debugln("] Already READY - forcing display update (status is Ready)");
+            APP_LOGD(BOILER, "%s already READY - forcing display update (status is Ready)", boiler_type_name(type));
             set_boiler_ready(boiler);  // Force update display
         }
         return;
@@ -202,17 +182,13 @@ void boiler_display_update(BoilerType type, const char* machine_status,
     if (ready_start_time <= 0) {
         // No valid ready start time - machine is ON but boiler is already READY (not heating)
         if (boiler->state != BOILER_STATE_READY) {
-            boiler_debug("[");
-            boiler_debug(boiler_type_name(type));
-            boiler_debugln("] -> READY (no heating needed)");
+            APP_LOGD(BOILER, "%s -> READY (no heating needed)", boiler_type_name(type));
             set_boiler_ready(boiler);
             restart_update_timer();
         } else {
             // Already in READY state, but force update display to ensure it's current
             // This ensures the display updates even if it was showing old countdown values
-            boiler_debug("[");
-            boiler_debug(boiler_type_name(type));
-            boiler_debugln("] Already READY - forcing display update (callback received)");
+            APP_LOGD(BOILER, "%s already READY - forcing display update (callback received)", boiler_type_name(type));
             set_boiler_ready(boiler);  // Force update display
         }
         return;
@@ -222,34 +198,24 @@ void boiler_display_update(BoilerType type, const char* machine_status,
     int64_t now_ms = boiler_display_get_current_time_ms();
     int remaining_sec = calculate_remaining_seconds(ready_start_time, now_ms);
     
-    boiler_debug("[");
-    boiler_debug(boiler_type_name(type));
-    boiler_debug("] Remaining: ");
-    boiler_debug(remaining_sec);
-    boiler_debugln(" sec");
+    APP_LOGD(BOILER, "%s remaining: %d sec", boiler_type_name(type), remaining_sec);
     
     if (remaining_sec <= 0) {
         // Boiler is READY
         if (boiler->state != BOILER_STATE_READY) {
-            boiler_debug("[");
-            boiler_debug(boiler_type_name(type));
-            boiler_debugln("] -> READY");
+            APP_LOGD(BOILER, "%s -> READY", boiler_type_name(type));
             set_boiler_ready(boiler);
             restart_update_timer();
         } else {
             // Already in READY state, but force update display to ensure it's current
             // Always update even if already READY to catch any stale display values
-            boiler_debug("[");
-            boiler_debug(boiler_type_name(type));
-            boiler_debugln("] Already READY - forcing display update (callback received)");
+            APP_LOGD(BOILER, "%s already READY - forcing display update (callback received)", boiler_type_name(type));
             set_boiler_ready(boiler);  // Force update display
         }
     } else {
         // Boiler is HEATING
         if (boiler->state != BOILER_STATE_HEATING || boiler->ready_start_time != ready_start_time) {
-            boiler_debug("[");
-            boiler_debug(boiler_type_name(type));
-            boiler_debugln("] -> HEATING");
+            APP_LOGD(BOILER, "%s -> HEATING", boiler_type_name(type));
             set_boiler_heating(boiler, ready_start_time);
             restart_update_timer();
         } else {
@@ -266,7 +232,7 @@ void boiler_display_update(BoilerType type, const char* machine_status,
 void boiler_display_set_all_off(void) {
     if (!g_initialized) return;
     
-    boiler_debugln("[Boiler] Setting all boilers to OFF");
+    APP_LOGD(BOILER, "Setting all boilers to OFF");
     set_boiler_off(&g_boilers[BOILER_COFFEE]);
     set_boiler_off(&g_boilers[BOILER_STEAM]);
     
@@ -296,7 +262,7 @@ int64_t boiler_display_get_current_time_ms(void) {
 void boiler_display_timer_callback(lv_timer_t* timer) {
     if (!g_initialized) return;
     
-    boiler_debugln("[Boiler] Timer callback - updating all boilers");
+    APP_LOGD(BOILER, "Timer callback - updating all boilers");
     
     int64_t now_ms = boiler_display_get_current_time_ms();
     bool any_heating = false;
@@ -310,9 +276,7 @@ void boiler_display_timer_callback(lv_timer_t* timer) {
             
             if (remaining_sec <= 0) {
                 // Transition to READY
-                boiler_debug("[");
-                boiler_debug(boiler_type_name(boiler->type));
-                boiler_debugln("] Timer: -> READY");
+                APP_LOGD(BOILER, "%s timer: -> READY", boiler_type_name(boiler->type));
                 // Use no_mutex version since we're in timer callback (LVGL task context)
                 set_boiler_ready_no_mutex(boiler);
             } else {
@@ -347,11 +311,11 @@ void boiler_display_timer_callback(lv_timer_t* timer) {
         if (g_timer_paused) {
             lv_timer_resume(g_update_timer);
             g_timer_paused = false;
-            boiler_debugln("[Boiler] Timer resumed for READY state refresh (5s)");
+            APP_LOGD(BOILER, "Timer resumed for READY state refresh (5s)");
         }
     } else {
         // No boilers active, pause timer
-        boiler_debugln("[Boiler] No boilers active, pausing timer");
+        APP_LOGD(BOILER, "No boilers active, pausing timer");
         if (!g_timer_paused) {
             lv_timer_pause(g_update_timer);
             g_timer_paused = true;
@@ -379,19 +343,13 @@ static int calculate_remaining_seconds(int64_t ready_start_time, int64_t now_ms)
     int64_t remaining_ms = ready_start_time - now_ms;
     int remaining_sec = (int)(remaining_ms / 1000);
     
-    // Calculate for display
+    // Minutes and seconds for the log line
     int remaining_min = remaining_sec / 60;
     int remaining_sec_part = remaining_sec % 60;
     
-    #if DEBUG_BOILER
     if (remaining_sec > 0) {
-        boiler_debug("  [Time calc: Remaining ");
-        boiler_debug(remaining_min);
-        boiler_debug(" min ");
-        boiler_debug(remaining_sec_part);
-        boiler_debugln(" sec]");
+        APP_LOGV(BOILER, "  [Time calc: Remaining %d min %d sec]", remaining_min, remaining_sec_part);
     }
-    #endif
     
     return remaining_sec;
 }
@@ -472,13 +430,7 @@ static void update_arc_and_label(BoilerInfo* boiler, int remaining_seconds) {
         GIVE_MUTEX();
     }
     
-    boiler_debug("[");
-    boiler_debug(boiler_type_name(boiler->type));
-    boiler_debug("] Display: ");
-    boiler_debug(label_text);
-    boiler_debug(" (arc: ");
-    boiler_debug(arc_value);
-    boiler_debugln("%)");
+    APP_LOGD(BOILER, "%s display: %s (arc: %d%%)", boiler_type_name(boiler->type), label_text, arc_value);
 }
 
 /**
@@ -537,7 +489,7 @@ static void set_boiler_heating(BoilerInfo* boiler, int64_t ready_start_time) {
     if (g_update_timer && g_timer_paused) {
         lv_timer_resume(g_update_timer);
         g_timer_paused = false;
-        boiler_debugln("[Boiler] Timer resumed");
+        APP_LOGD(BOILER, "Timer resumed");
     }
 }
 
@@ -547,9 +499,7 @@ static void set_boiler_heating(BoilerInfo* boiler, int64_t ready_start_time) {
  */
 static void set_boiler_ready_no_mutex(BoilerInfo* boiler) {
     if (!boiler || !boiler->arc || !boiler->label) {
-        boiler_debug("[");
-        boiler_debug(boiler_type_name(boiler->type));
-        boiler_debugln("] ERROR: NULL objects in set_boiler_ready!");
+        APP_LOGE(BOILER, "%s NULL objects in set_boiler_ready!", boiler_type_name(boiler->type));
         return;
     }
     
@@ -581,9 +531,7 @@ static void set_boiler_ready_no_mutex(BoilerInfo* boiler) {
     // Update last_remaining_sec to 0 to track READY state (0 seconds remaining)
     boiler->last_remaining_sec = 0;
     
-    boiler_debug("[");
-    boiler_debug(boiler_type_name(boiler->type));
-    boiler_debugln("] Display updated to READY");
+    APP_LOGD(BOILER, "%s display updated to READY", boiler_type_name(boiler->type));
 }
 
 /**
@@ -591,9 +539,7 @@ static void set_boiler_ready_no_mutex(BoilerInfo* boiler) {
  */
 static void set_boiler_ready(BoilerInfo* boiler) {
     if (!boiler || !boiler->arc || !boiler->label) {
-        boiler_debug("[");
-        boiler_debug(boiler_type_name(boiler->type));
-        boiler_debugln("] ERROR: NULL objects in set_boiler_ready!");
+        APP_LOGE(BOILER, "%s NULL objects in set_boiler_ready!", boiler_type_name(boiler->type));
         return;
     }
     
@@ -628,10 +574,10 @@ static void restart_update_timer(void) {
     uint32_t period_ms;
     if (needs_fast_update) {
         period_ms = 1000;  // 1 second when < 60 seconds remaining
-        boiler_debugln("[Boiler] Timer set to 1 second (fast updates)");
+        APP_LOGD(BOILER, "Timer set to 1 second (fast updates)");
     } else {
         period_ms = 30000;  // 30 seconds otherwise
-        boiler_debugln("[Boiler] Timer set to 30 seconds (slow updates)");
+        APP_LOGD(BOILER, "Timer set to 30 seconds (slow updates)");
     }
     
     lv_timer_set_period(g_update_timer, period_ms);
@@ -648,11 +594,11 @@ static void restart_update_timer(void) {
     if (any_active && g_timer_paused) {
         lv_timer_resume(g_update_timer);
         g_timer_paused = false;
-        boiler_debugln("[Boiler] Timer resumed");
+        APP_LOGD(BOILER, "Timer resumed");
     } else if (!any_active && !g_timer_paused) {
         lv_timer_pause(g_update_timer);
         g_timer_paused = true;
-        boiler_debugln("[Boiler] Timer paused (no active boilers)");
+        APP_LOGD(BOILER, "Timer paused (no active boilers)");
     }
 }
 
@@ -1,6 +1,7 @@
 #include "brewing_display.h"
 #include "water_alarm.h"
 #include "config.h"
+#include "app_log.h"
 #include "ui/ui.h"
 #include <Arduino.h>
 #include <string.h>
@@ -9,16 +10,6 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 
-// Debug output
-#define DEBUG_BREWING 1
-#if DEBUG_BREWING
-#define brewing_debug(x) Serial.print(x)
-#define brewing_debugln(x) Serial.println(x)
-#else
-#define brewing_debug(x)
-#define brewing_debugln(x)
-#endif
-
 // Brewing states
 typedef enum {
     BREWING_STATE_IDLE = 0,      // Not brewing
@@ -51,15 +42,16 @@ static void start_brewing(int64_t start_time);
 static void stop_brewing(void);
 
 // Helper macro for mutex protection
-#define TAKE_MUTEX() if (g_gui_mutex && xSemaphoreTake(g_gui_mutex, pdMS_TO_TICKS(100)) == pdTRUE)
-#define GIVE_MUTEX() if (g_gui_mutex) xSemaphoreGive(g_gui_mutex)
+// The GUI mutex is recursive: events are applied from Task_LVGL while it already holds it
+#define TAKE_MUTEX() if (g_gui_mutex && xSemaphoreTakeRecursive(g_gui_mutex, pdMS_TO_TICKS(100)) == pdTRUE)
+#define GIVE_MUTEX() if (g_gui_mutex) xSemaphoreGiveRecursive(g_gui_mutex)
 
 /**
  * Set the GUI mutex for thread-safe LVGL access
  */
 void brewing_display_set_mutex(void* mutex) {
     g_gui_mutex = (SemaphoreHandle_t)mutex;
-    brewing_debugln("[Brewing] Mutex set for thread-safe operation");
+    APP_LOGD(BREWING, "Mutex set for thread-safe operation");
 }
 
 /**
@@ -67,18 +59,16 @@ void brewing_display_set_mutex(void* mutex) {
  */
 void brewing_display_init(void) {
     if (g_initialized) {
-        brewing_debugln("[Brewing] Already initialized");
+        APP_LOGD(BREWING, "Already initialized");
         return;
     }
     
-    brewing_debugln("[Brewing] Initializing brewing display system...");
+    APP_LOGD(BREWING, "Initializing brewing display system...");
     
     // Initialize GPIO 15 for brewing simulation mode
     pinMode(BREWING_SIM_PIN, INPUT_PULLUP);
     g_last_gpio_state = digitalRead(BREWING_SIM_PIN) == HIGH;
-    brewing_debug("[Brewing] GPIO 15 initialized (current state: ");
-    brewing_debug(g_last_gpio_state ? "HIGH" : "LOW");
-    brewing_debugln(")");
+    APP_LOGD(BREWING, "GPIO 15 initialized (current state: %s)", g_last_gpio_state ? "HIGH" : "LOW");
     
     TAKE_MUTEX() {
         // Hide brewing elements by default
@@ -107,7 +97,7 @@ void brewing_display_init(void) {
     g_state = BREWING_STATE_IDLE;
     g_brewing_start_time = 0;
     g_final_seconds = 0;
-    brewing_debugln("[Brewing] Initialization complete");
+    APP_LOGD(BREWING, "Initialization complete");
 }
 
 /**
@@ -122,7 +112,7 @@ static void start_brewing(int64_t start_time) {
         return;
     }
     
-    brewing_debugln("[Brewing] ===== STARTING BREWING MODE =====");
+    APP_LOGI(BREWING, "Starting brewing mode");
     g_state = BREWING_STATE_ACTIVE;
     g_brewing_start_time = start_time;
     g_final_seconds = 0;
@@ -136,7 +126,7 @@ static void start_brewing(int64_t start_time) {
         if (g_timer_paused) {
             lv_timer_resume(g_update_timer);
             g_timer_paused = false;
-            brewing_debugln("[Brewing] Timer started (50ms period)");
+            APP_LOGD(BREWING, "Timer started (50ms period)");
         }
     }
 }
@@ -149,7 +139,7 @@ static void stop_brewing(void) {
         return;  // Already stopped
     }
     
-    brewing_debugln("[Brewing] ===== STOPPING BREWING MODE =====");
+    APP_LOGI(BREWING, "Stopping brewing mode");
     
     // Capture final seconds value for flashing
     if (g_brewing_start_time > 0) {
@@ -164,8 +154,7 @@ static void stop_brewing(void) {
         g_final_seconds = 0;
     }
     
-    brewing_debug("[Brewing] Final seconds to flash: ");
-    brewing_debugln(g_final_seconds);
+    APP_LOGD(BREWING, "Final seconds to flash: %d", g_final_seconds);
     
     // Transition to flashing state
     g_state = BREWING_STATE_FLASHING;
@@ -201,7 +190,7 @@ static void stop_brewing(void) {
         lv_timer_set_period(g_update_timer, 50);
     }
     
-    brewing_debugln("[Brewing] Entered flashing state - will restore UI after 3 seconds");
+    APP_LOGD(BREWING, "Entered flashing state - will restore UI after 3 seconds");
 }
 
 /**
@@ -216,14 +205,14 @@ static void stop_brewing(void) {
  */
 void brewing_display_update(bool is_brewing, int64_t brewing_start_time) {
     if (!g_initialized) {
-        brewing_debugln("[Brewing] ERROR: Not initialized!");
+        APP_LOGE(BREWING, "Not initialized!");
         return;
     }
     
     // If GPIO simulation is active, ignore websocket updates
     // Exception: allow updates if they're coming from GPIO simulation itself
     if (g_gpio_simulation_active && !g_allow_update_from_gpio) {
-        brewing_debugln("[Brewing] Ignoring websocket update - GPIO simulation is active");
+        APP_LOGD(BREWING, "Ignoring websocket update - GPIO simulation is active");
         return;
     }
     
@@ -263,7 +252,7 @@ void brewing_display_timer_callback(lv_timer_t* timer) {
                 
                 if (elapsed >= FLASH_DURATION_MS) {
                     // Flash duration complete - return to idle and restore normal UI
-                    brewing_debugln("[Brewing] Flash complete (3 seconds) - returning to normal UI");
+                    APP_LOGD(BREWING, "Flash complete (3 seconds) - returning to normal UI");
                     g_state = BREWING_STATE_IDLE;
                     g_final_seconds = 0;
                     
@@ -274,7 +263,7 @@ void brewing_display_timer_callback(lv_timer_t* timer) {
                     if (g_update_timer && !g_timer_paused) {
                         lv_timer_pause(g_update_timer);
                         g_timer_paused = true;
-                        brewing_debugln("[Brewing] Timer paused");
+                        APP_LOGD(BREWING, "Timer paused");
                     }
                 } else {
                     // Flash effect: toggle visibility every FLASH_TOGGLE_MS
@@ -361,7 +350,7 @@ static void update_elapsed_time_display(void) {
  */
 static void show_brewing_ui(void) {
     TAKE_MUTEX() {
-        brewing_debugln("[Brewing] Showing brewing UI, hiding ALL normal UI elements");
+        APP_LOGD(BREWING, "Showing brewing UI, hiding ALL normal UI elements");
         
         // FIRST: Hide ALL normal UI elements to prevent overlap
         // Hide buttons
@@ -435,7 +424,7 @@ static void show_brewing_ui(void) {
             lv_obj_invalidate(ui_mainScreen);
         }
         
-        brewing_debugln("[Brewing] All normal UI elements hidden, brewing UI shown");
+        APP_LOGD(BREWING, "All normal UI elements hidden, brewing UI shown");
         GIVE_MUTEX();
     }
 }
@@ -463,7 +452,7 @@ static void hide_brewing_ui(void) {
  * This version is for use in timer callback where mutex is already held
  */
 static void restore_normal_ui_no_mutex(void) {
-    brewing_debugln("[Brewing] Restoring normal UI (no mutex) - hiding brewing elements, showing all normal elements");
+    APP_LOGD(BREWING, "Restoring normal UI (no mutex) - hiding brewing elements, showing all normal elements");
     
     // Hide all brewing elements first
     if (ui_SecPanel) {
@@ -528,7 +517,7 @@ static void restore_normal_ui_no_mutex(void) {
         lv_obj_invalidate(ui_mainScreen);
     }
     
-    brewing_debugln("[Brewing] Normal UI restored - all brewing elements hidden, all normal elements shown");
+    APP_LOGD(BREWING, "Normal UI restored - all brewing elements hidden, all normal elements shown");
 }
 
 /**
@@ -585,9 +574,7 @@ void brewing_display_check_gpio_simulation(void) {
             // GPIO is LOW (GND) - enter brewing mode
             if (!g_gpio_simulation_active) {
                 g_gpio_simulation_active = true;
-                brewing_debugln("[Brewing] ========================================");
-                brewing_debugln("[Brewing] GPIO 15 LOW - Entering BREWING SIMULATION mode");
-                brewing_debugln("[Brewing] ========================================");
+                APP_LOGI(BREWING, "GPIO 15 LOW - Entering BREWING SIMULATION mode");
                 
                 // Start brewing with current time as start time
                 g_allow_update_from_gpio = true;
@@ -598,13 +585,11 @@ void brewing_display_check_gpio_simulation(void) {
             // GPIO is HIGH - exit brewing mode
             if (g_gpio_simulation_active) {
                 g_gpio_simulation_active = false;
-                brewing_debugln("[Brewing] ========================================");
-                brewing_debugln("[Brewing] GPIO 15 HIGH - Exiting BREWING SIMULATION mode");
-                brewing_debugln("[Brewing] ========================================");
+                APP_LOGI(BREWING, "GPIO 15 HIGH - Exiting BREWING SIMULATION mode");
                 
                 // If we're in flashing state, skip it and go directly to idle
                 if (g_state == BREWING_STATE_FLASHING) {
-                    brewing_debugln("[Brewing] Skipping flash - GPIO released during flash");
+                    APP_LOGD(BREWING, "Skipping flash - GPIO released during flash");
                     g_state = BREWING_STATE_IDLE;
                     g_final_seconds = 0;
                     
@@ -0,0 +1,213 @@
+#include "command_queue.h"
+#include "lamarzocco_machine.h"
+#include "app_log.h"
+#include "config.h"
+#include "ui/ui.h"
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+struct CommandRequest {
+    CommandKind kind;
+    bool value;
+    uint32_t requested_ms;
+};
+
+// The caller of the command of each kind in flight
+struct InFlight {
+    bool busy;
+    CommandCallback callback;
+    void* context;
+};
+
+static LaMarzoccoMachine* g_machine_ref = nullptr;
+static QueueHandle_t g_requests = NULL;   // Task_LVGL -> worker
+static QueueHandle_t g_results = NULL;    // Worker / network task -> Task_LVGL
+static InFlight g_in_flight[COMMAND_KIND_COUNT] = {};
+static CommandQueueStats g_stats = {};
+static portMUX_TYPE g_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static lv_obj_t* button_for(CommandKind kind) {
+    return kind == COMMAND_POWER ? ui_powerButton : ui_steamButton;
+}
+
+// Disabled while busy, so further taps are not delivered (the pending look
+// is control_display's)
+static void set_button_busy(CommandKind kind, bool busy) {
+    lv_obj_t* button = button_for(kind);
+    if (!button) {
+        return;
+    }
+    if (busy) {
+        lv_obj_add_state(button, LV_STATE_DISABLED);
+    } else {
+        lv_obj_clear_state(button, LV_STATE_DISABLED);
+    }
+}
+
+// Outcome of a command (worker or network task, see command_tracker.h)
+static void on_result(const CommandResult& result, void* context) {
+    portENTER_CRITICAL(&g_lock);
+    InFlight caller = g_in_flight[result.kind];
+    g_in_flight[result.kind].busy = false;
+    portEXIT_CRITICAL(&g_lock);
+
+    g_machine_ref->control_result(result);
+    // Room for one result per kind, as only one command per kind is in flight
+    xQueueSend(g_results, &result, 0);
+    if (caller.callback) {
+        caller.callback(result, caller.context);
+    }
+}
+
+// Sends queued commands one at a time; the POST (TLS, signing) blocks here
+// instead of in the LVGL event callback
+static void Task_Commands(void* pvParameters) {
+    CommandRequest request;
+    while (1) {
+        if (xQueueReceive(g_requests, &request, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        uint32_t start_ms = millis();
+        uint32_t waited_ms = start_ms - request.requested_ms;
+
+        portENTER_CRITICAL(&g_lock);
+        if (waited_ms > g_stats.wait_ms_max) {
+            g_stats.wait_ms_max = waited_ms;
+        }
+        portEXIT_CRITICAL(&g_lock);
+
+        // A tap that sat behind a slow POST is stale by now
+        if (waited_ms > COMMAND_QUEUE_TIMEOUT_MS) {
+            APP_LOGW(MACHINE, "%s command waited %u ms, not sent",
+                     command_kind_name(request.kind), waited_ms);
+            portENTER_CRITICAL(&g_lock);
+            g_stats.expired++;
+            portEXIT_CRITICAL(&g_lock);
+            CommandResult result;
+            result.kind = request.kind;
+            result.value = request.value;
+            result.outcome = COMMAND_TIMED_OUT;
+            result.latency_ms = waited_ms;
+            on_result(result, nullptr);
+            continue;
+        }
+
+        if (request.kind == COMMAND_POWER) {
+            g_machine_ref->set_power(request.value, on_result, nullptr);
+        } else {
+            g_machine_ref->set_steam(request.value, on_result, nullptr);
+        }
+
+        uint32_t send_ms = millis() - start_ms;
+        portENTER_CRITICAL(&g_lock);
+        g_stats.send_ms_last = send_ms;
+        if (send_ms > g_stats.send_ms_max) {
+            g_stats.send_ms_max = send_ms;
+        }
+        portEXIT_CRITICAL(&g_lock);
+    }
+}
+
+bool command_queue_begin(LaMarzoccoMachine* machine) {
+    if (g_requests) {
+        return true;
+    }
+    g_requests = xQueueCreate(COMMAND_KIND_COUNT, sizeof(CommandRequest));
+    g_results = xQueueCreate(COMMAND_KIND_COUNT, sizeof(CommandResult));
+    if (!g_requests || !g_results) {
+        APP_LOGE(MACHINE, "Command queue creation failed");
+        return false;
+    }
+    g_machine_ref = machine;
+    if (xTaskCreatePinnedToCore(Task_Commands,
+                                "Task_Commands",
+                                1024 * 16,  // TLS + ECDSA signing, as Task_Network
+                                NULL,
+                                2,
+                                NULL,
+                                1) != pdPASS) {
+        APP_LOGE(MACHINE, "Command worker task creation failed");
+        vQueueDelete(g_requests);
+        vQueueDelete(g_results);
+        g_requests = NULL;
+        g_results = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool command_queue_toggle(CommandKind kind, CommandCallback callback, void* context) {
+    if (!g_requests || kind >= COMMAND_KIND_COUNT) {
+        portENTER_CRITICAL(&g_lock);
+        g_stats.rejected++;
+        portEXIT_CRITICAL(&g_lock);
+        return false;
+    }
+
+    portENTER_CRITICAL(&g_lock);
+    bool busy = g_in_flight[kind].busy;
+    if (busy) {
+        g_stats.rejected++;
+    } else {
+        g_in_flight[kind].busy = true;
+        g_in_flight[kind].callback = callback;
+        g_in_flight[kind].context = context;
+    }
+    portEXIT_CRITICAL(&g_lock);
+    if (busy) {
+        APP_LOGD(MACHINE, "%s command already in flight", command_kind_name(kind));
+        return false;
+    }
+
+    // The opposite of what the button shows, which is shown from now on
+    CommandRequest request;
+    request.kind = kind;
+    request.value = !g_machine_ref->get_control(kind).on;
+    request.requested_ms = millis();
+    g_machine_ref->request_control(kind, request.value);
+    if (xQueueSend(g_requests, &request, 0) != pdTRUE) {
+        portENTER_CRITICAL(&g_lock);
+        g_in_flight[kind].busy = false;
+        g_stats.rejected++;
+        portEXIT_CRITICAL(&g_lock);
+        CommandResult result;
+        result.kind = kind;
+        result.value = request.value;
+        result.outcome = COMMAND_FAILED;
+        result.latency_ms = 0;
+        g_machine_ref->control_result(result);
+        return false;
+    }
+
+    portENTER_CRITICAL(&g_lock);
+    g_stats.submitted++;
+    portEXIT_CRITICAL(&g_lock);
+    set_button_busy(kind, true);
+    return true;
+}
+
+bool command_queue_busy(CommandKind kind) {
+    portENTER_CRITICAL(&g_lock);
+    bool busy = kind < COMMAND_KIND_COUNT && g_in_flight[kind].busy;
+    portEXIT_CRITICAL(&g_lock);
+    return busy;
+}
+
+void command_queue_drain(void) {
+    if (!g_results) {
+        return;
+    }
+    CommandResult result;
+    while (xQueueReceive(g_results, &result, 0) == pdTRUE) {
+        set_button_busy(result.kind, false);
+    }
+}
+
+CommandQueueStats command_queue_get_stats(void) {
+    portENTER_CRITICAL(&g_lock);
+    CommandQueueStats stats = g_stats;
+    portEXIT_CRITICAL(&g_lock);
+    return stats;
+}
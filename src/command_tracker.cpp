@@ -0,0 +1,242 @@
+#include "command_tracker.h"
+#include "app_log.h"
+#include "dashboard_codes.h"
+#include "dashboard_diff.h"
+#include <Arduino.h>
+#include <string.h>
+
+// An entry taken out of the table, completed once the lock is released
+struct Completion {
+    CommandResult result;
+    CommandCallback callback;
+    void* context;
+    char id[DASHBOARD_ID_LEN];
+};
+
+static void complete(const Completion& done) {
+    APP_LOGI(MACHINE, "📋 Command %s (%s %s): %s after %u ms", done.id,
+             command_kind_name(done.result.kind), done.result.value ? "ON" : "OFF",
+             command_outcome_name(done.result.outcome), done.result.latency_ms);
+    if (done.callback) {
+        done.callback(done.result, done.context);
+    }
+}
+
+CommandTracker::CommandTracker()
+    : _count(0), _recent_next(0), _stats(), _confirm_ms_total(0) {
+    portMUX_INITIALIZE(&_lock);
+    memset(_recent, 0, sizeof(_recent));
+}
+
+bool CommandTracker::add(const char* id, CommandKind kind, bool value, uint32_t requested_ms,
+                         CommandCallback callback, void* context) {
+    uint32_t now = millis();
+    Completion done;
+    done.result.kind = kind;
+    done.result.value = value;
+    done.result.latency_ms = now - requested_ms;
+    done.callback = callback;
+    done.context = context;
+    dashboard_copy_str(done.id, sizeof(done.id), id);
+
+    bool added = false;
+    bool finished = false;
+    portENTER_CRITICAL(&_lock);
+    _stats.post_ms_last = now - requested_ms;
+    for (size_t i = 0; i < COMMAND_TRACKER_SLOTS; i++) {
+        RecentResult& recent = _recent[i];
+        if (!recent.claimed && recent.id[0] && strcmp(recent.id, done.id) == 0) {
+            // The machine answered before the POST did
+            done.result.outcome = recent.outcome;
+            recent.claimed = true;
+            _stats.unknown--;
+            _stats.issued++;
+            _record(done.result.outcome, done.result.latency_ms);
+            finished = true;
+            break;
+        }
+    }
+    if (!finished && _count < COMMAND_TRACKER_SLOTS) {
+        Entry& entry = _entries[_count++];
+        memcpy(entry.id, done.id, sizeof(entry.id));
+        entry.kind = kind;
+        entry.value = value;
+        entry.requested_ms = requested_ms;
+        entry.callback = callback;
+        entry.context = context;
+        _stats.issued++;
+        added = true;
+    }
+    portEXIT_CRITICAL(&_lock);
+
+    if (finished) {
+        complete(done);
+        return true;
+    }
+    if (!added) {
+        APP_LOGW(MACHINE, "Command table full, not following %s", done.id);
+        done.result.outcome = COMMAND_UNTRACKED;
+        complete(done);
+        return false;
+    }
+    APP_LOGD(MACHINE, "📋 Command %s (%s) pending, POST took %u ms", done.id,
+             command_kind_name(kind), done.result.latency_ms);
+    return true;
+}
+
+void CommandTracker::update(const DashboardCommands& commands) {
+    Completion done[DASHBOARD_MAX_COMMANDS];
+    size_t done_count = 0;
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&_lock);
+    for (size_t c = 0; c < commands.count; c++) {
+        const DashboardCommand& cmd = commands.items[c];
+        CommandOutcome outcome;
+        if (!cmd.id[0] || !command_status_outcome(cmd.status, outcome)) {
+            continue;
+        }
+        size_t i = 0;
+        while (i < _count && strcmp(_entries[i].id, cmd.id) != 0) {
+            i++;
+        }
+        if (i == _count) {
+            // Already completed and repeated by this snapshot, ours with the
+            // POST still in flight, or another client's
+            bool seen = false;
+            for (size_t r = 0; r < COMMAND_TRACKER_SLOTS; r++) {
+                seen |= strcmp(_recent[r].id, cmd.id) == 0;
+            }
+            if (!seen) {
+                _remember(cmd.id, outcome, false);
+                _stats.unknown++;
+            }
+            continue;
+        }
+        Entry& entry = _entries[i];
+        Completion& d = done[done_count++];
+        d.result.kind = entry.kind;
+        d.result.value = entry.value;
+        d.result.outcome = outcome;
+        d.result.latency_ms = now - entry.requested_ms;
+        d.callback = entry.callback;
+        d.context = entry.context;
+        memcpy(d.id, entry.id, sizeof(d.id));
+        _record(outcome, d.result.latency_ms);
+        _remember(entry.id, outcome, true);
+        _entries[i] = _entries[--_count];
+    }
+    portEXIT_CRITICAL(&_lock);
+
+    for (size_t i = 0; i < done_count; i++) {
+        complete(done[i]);
+    }
+}
+
+void CommandTracker::expire() {
+    if (_count == 0) {
+        return;
+    }
+    Completion done[COMMAND_TRACKER_SLOTS];
+    size_t done_count = 0;
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&_lock);
+    size_t i = 0;
+    while (i < _count) {
+        Entry& entry = _entries[i];
+        uint32_t age = now - entry.requested_ms;
+        if (age < COMMAND_CONFIRM_TIMEOUT_MS) {
+            i++;
+            continue;
+        }
+        Completion& d = done[done_count++];
+        d.result.kind = entry.kind;
+        d.result.value = entry.value;
+        d.result.outcome = COMMAND_TIMED_OUT;
+        d.result.latency_ms = age;
+        d.callback = entry.callback;
+        d.context = entry.context;
+        memcpy(d.id, entry.id, sizeof(d.id));
+        _record(COMMAND_TIMED_OUT, age);
+        _entries[i] = _entries[--_count];
+    }
+    portEXIT_CRITICAL(&_lock);
+
+    for (size_t d = 0; d < done_count; d++) {
+        complete(done[d]);
+    }
+}
+
+CommandTrackerStats CommandTracker::get_stats() {
+    portENTER_CRITICAL(&_lock);
+    CommandTrackerStats stats = _stats;
+    portEXIT_CRITICAL(&_lock);
+    return stats;
+}
+
+// Called with _lock held
+void CommandTracker::_record(CommandOutcome outcome, uint32_t latency_ms) {
+    switch (outcome) {
+        case COMMAND_CONFIRMED:
+            _stats.confirmed++;
+            _stats.confirm_ms_last = latency_ms;
+            if (latency_ms > _stats.confirm_ms_max) {
+                _stats.confirm_ms_max = latency_ms;
+            }
+            _confirm_ms_total += latency_ms;
+            _stats.confirm_ms_avg = (uint32_t)(_confirm_ms_total / _stats.confirmed);
+            break;
+        case COMMAND_TIMED_OUT:
+            _stats.timed_out++;
+            break;
+        default:
+            _stats.failed++;
+            break;
+    }
+}
+
+// Called with _lock held
+void CommandTracker::_remember(const char* id, CommandOutcome outcome, bool claimed) {
+    RecentResult& recent = _recent[_recent_next];
+    _recent_next = (_recent_next + 1) % COMMAND_TRACKER_SLOTS;
+    memcpy(recent.id, id, sizeof(recent.id));
+    recent.outcome = outcome;
+    recent.claimed = claimed;
+}
+
+// -1 for statuses that are not final
+static int command_status_lookup(const char* str, size_t length) {
+    switch (dashboard_hash(str, length)) {
+        COMMAND_STATUS_CODES(DASHBOARD_LOOKUP_CASE)
+        default:
+            break;
+    }
+    return -1;
+}
+
+bool command_status_outcome(const char* status, CommandOutcome& outcome) {
+    if (!status || !status[0]) return false;
+    int found = command_status_lookup(status, strlen(status));
+    if (found < 0) return false;
+    outcome = (CommandOutcome)found;
+    return true;
+}
+
+const char* command_kind_name(CommandKind kind) {
+    switch (kind) {
+        case COMMAND_POWER: return "power";
+        case COMMAND_STEAM: return "steam";
+        default: return "?";
+    }
+}
+
+const char* command_outcome_name(CommandOutcome outcome) {
+    switch (outcome) {
+        case COMMAND_CONFIRMED: return "confirmed";
+        case COMMAND_FAILED: return "failed";
+        case COMMAND_TIMED_OUT: return "timed out";
+        case COMMAND_UNTRACKED: return "untracked";
+        default: return "?";
+    }
+}
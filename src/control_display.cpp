@@ -0,0 +1,66 @@
+#include "control_display.h"
+#include "lamarzocco_machine.h"
+#include "app_log.h"
+#include "ui/ui.h"
+
+static bool g_initialized = false;
+static bool g_drawn = false;
+static uint32_t g_drawn_version = 0;
+
+static lv_obj_t* button_for(CommandKind kind) {
+    return kind == COMMAND_POWER ? ui_powerButton : ui_steamButton;
+}
+
+static void draw_button(CommandKind kind, const ControlView& view) {
+    lv_obj_t* button = button_for(kind);
+    if (!button) {
+        return;
+    }
+    if (view.on) {
+        lv_obj_add_state(button, LV_STATE_CHECKED);
+    } else {
+        lv_obj_clear_state(button, LV_STATE_CHECKED);
+    }
+    lv_obj_set_style_opa(button, view.pending ? LV_OPA_50 : LV_OPA_COVER, LV_PART_MAIN);
+}
+
+/**
+ * Set up the on / off look of the buttons
+ */
+void control_display_init(void) {
+    if (g_initialized) {
+        return;
+    }
+    for (int k = 0; k < COMMAND_KIND_COUNT; k++) {
+        lv_obj_t* button = button_for((CommandKind)k);
+        if (!button) {
+            continue;
+        }
+        // Taps toggle through the command queue, not LVGL's checkable flag
+        lv_obj_set_style_outline_color(button, lv_color_hex(0x4CAF50), LV_PART_MAIN | LV_STATE_CHECKED);
+        lv_obj_set_style_outline_width(button, 4, LV_PART_MAIN | LV_STATE_CHECKED);
+        lv_obj_set_style_outline_pad(button, 2, LV_PART_MAIN | LV_STATE_CHECKED);
+    }
+    g_initialized = true;
+}
+
+/**
+ * Redraw the buttons if the control state changed
+ */
+void control_display_refresh(LaMarzoccoMachine* machine) {
+    if (!g_initialized || !machine) {
+        return;
+    }
+    uint32_t version = machine->get_control_version();
+    if (g_drawn && version == g_drawn_version) {
+        return;
+    }
+    for (int k = 0; k < COMMAND_KIND_COUNT; k++) {
+        ControlView view = machine->get_control((CommandKind)k);
+        draw_button((CommandKind)k, view);
+        APP_LOGD(MACHINE, "%s button: %s%s", command_kind_name((CommandKind)k),
+                 view.on ? "ON" : "OFF", view.pending ? " (pending)" : "");
+    }
+    g_drawn = true;
+    g_drawn_version = version;
+}
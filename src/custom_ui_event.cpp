@@ -1,5 +1,7 @@
 #include "ui/ui.h"
 #include "lamarzocco_machine.h"
+#include "command_queue.h"
+#include "app_log.h"
 
 extern LaMarzoccoMachine* g_machine;
 
@@ -10,82 +12,42 @@ void wifiSetup(lv_event_t *e)
     lv_scr_load(ui_setupWifiScreen);
 }
 
+// The buttons only queue their command (see command_queue.h): the POST runs
+// on the command worker, so the LVGL task is never held up by the network.
+// Each button stays disabled until the machine has answered.
+
 void turnOnMachine(lv_event_t * e)
 {
-  // Get the machine control instance
-  if (g_machine) {
-    Serial.println("===========================================");
-    Serial.println("BUTTON PRESSED - Processing...");
-    Serial.println("===========================================");
-    
-    // Check current websocket status
-    if (g_machine->is_websocket_connected()) {
-      Serial.println("✓ WebSocket is already connected");
-    } else {
-      Serial.println("⚠ WebSocket not connected, attempting to connect...");
-      bool connected = g_machine->connect_websocket();
-      if (connected) {
-        Serial.println("✓ WebSocket connection initiated");
-        // Give it a moment to establish
-        delay(1000);
-      } else {
-        Serial.println("✗ Failed to initiate WebSocket connection");
-      }
-    }
-    
-    // Toggle the power
-    Serial.println("\nToggling machine power...");
-    bool success = g_machine->toggle_power();
-    if (success) {
-      Serial.println("✓ Power toggle command sent successfully");
-      Serial.println("Check WebSocket messages below for confirmation...");
-    } else {
-      Serial.println("✗ Failed to send power toggle command");
-    }
-    
-    Serial.println("===========================================\n");
+  if (!g_machine) {
+    APP_LOGE(MACHINE, "Power button: machine not initialized");
+    return;
+  }
+  if (!g_machine->is_websocket_connected()) {
+    // The network task owns the WebSocket and reconnects it on its own
+    APP_LOGW(MACHINE, "Power button: WebSocket not connected, result will arrive late");
+  }
+  if (command_queue_toggle(COMMAND_POWER)) {
+    APP_LOGI(MACHINE, "Power button: toggle queued (currently %s)",
+             g_machine->get_power_state() ? "ON" : "OFF");
   } else {
-    Serial.println("ERROR: g_machine is null!");
+    APP_LOGW(MACHINE, "Power button: command not queued");
   }
 }
 
 void toggleSteamBoiler(lv_event_t * e)
 {
-  // Get the machine control instance
-  if (g_machine) {
-    Serial.println("===========================================");
-    Serial.println("STEAM BUTTON PRESSED - Processing...");
-    Serial.println("===========================================");
-    
-    // Check current websocket status
-    if (g_machine->is_websocket_connected()) {
-      Serial.println("✓ WebSocket is already connected");
-    } else {
-      Serial.println("⚠ WebSocket not connected, attempting to connect...");
-      bool connected = g_machine->connect_websocket();
-      if (connected) {
-        Serial.println("✓ WebSocket connection initiated");
-        // Give it a moment to establish
-        delay(1000);
-      } else {
-        Serial.println("✗ Failed to initiate WebSocket connection");
-      }
-    }
-    
-    // Toggle the steam boiler
-    Serial.println("\nToggling steam boiler...");
-    bool success = g_machine->toggle_steam();
-    if (success) {
-      Serial.println("✓ Steam boiler toggle command sent successfully");
-      Serial.println("WebSocket will confirm state change...");
-      // Note: No UI update here - button state will update when WebSocket
-      // confirms the change. This avoids mutex deadlock.
-    } else {
-      Serial.println("✗ Failed to send steam boiler toggle command");
-    }
-    
-    Serial.println("===========================================\n");
+  if (!g_machine) {
+    APP_LOGE(MACHINE, "Steam button: machine not initialized");
+    return;
+  }
+  if (!g_machine->is_websocket_connected()) {
+    // The network task owns the WebSocket and reconnects it on its own
+    APP_LOGW(MACHINE, "Steam button: WebSocket not connected, result will arrive late");
+  }
+  if (command_queue_toggle(COMMAND_STEAM)) {
+    APP_LOGI(MACHINE, "Steam button: toggle queued (currently %s)",
+             g_machine->get_steam_state() ? "ON" : "OFF");
   } else {
-    Serial.println("ERROR: g_machine is null!");
+    APP_LOGW(MACHINE, "Steam button: command not queued");
   }
-}
\ No newline at end of file
+}
@@ -0,0 +1,19 @@
+#include "dashboard_codes.h"
+#include "dashboard_diff.h"
+
+DashboardWidgetCode dashboard_widget_code(const char* str, size_t length) {
+    switch (dashboard_hash(str, length)) {
+        DASHBOARD_WIDGET_CODES(DASHBOARD_LOOKUP_CASE)
+        default:
+            break;
+    }
+    return WIDGET_UNKNOWN;
+}
+
+const char* dashboard_widget_name(DashboardWidgetCode code) {
+    switch (code) {
+        DASHBOARD_WIDGET_CODES(DASHBOARD_NAME_CASE)
+        default:
+            return "Unknown";
+    }
+}
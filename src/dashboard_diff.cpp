@@ -0,0 +1,117 @@
+#include "dashboard_diff.h"
+#include <string.h>
+
+uint32_t dashboard_hash(const char* data, size_t length, uint32_t seed) {
+    uint32_t hash = seed;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Skip one JSON value starting at p (object, array, string or scalar).
+// Returns the position just past it, or end if it is truncated.
+static const char* skip_value(const char* p, const char* end) {
+    if (p >= end) {
+        return end;
+    }
+    if (*p == '"') {
+        for (p++; p < end; p++) {
+            if (*p == '\\') {
+                p++;
+            } else if (*p == '"') {
+                return p + 1;
+            }
+        }
+        return end;
+    }
+    if (*p == '{' || *p == '[') {
+        int depth = 0;
+        for (; p < end; p++) {
+            if (*p == '"') {
+                p = skip_value(p, end) - 1;
+            } else if (*p == '{' || *p == '[') {
+                depth++;
+            } else if (*p == '}' || *p == ']') {
+                if (--depth == 0) {
+                    return p + 1;
+                }
+            }
+        }
+        return end;
+    }
+    while (p < end && *p != ',' && *p != '}' && *p != ']') {
+        p++;
+    }
+    return p;
+}
+
+static const char* skip_space(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+        p++;
+    }
+    return p;
+}
+
+// Find the value of the first "key": in the range; false if absent
+static bool find_value(const char* data, size_t length, const char* key,
+                       const char*& value, size_t& value_length) {
+    size_t key_len = strlen(key);
+    const char* end = data + length;
+    const char* p = data;
+    while (p + key_len + 2 <= end) {
+        const char* quote = (const char*)memchr(p, '"', end - p);
+        if (!quote || quote + key_len + 2 > end) {
+            return false;
+        }
+        if (memcmp(quote + 1, key, key_len) == 0 && quote[key_len + 1] == '"') {
+            const char* colon = skip_space(quote + key_len + 2, end);
+            if (colon < end && *colon == ':') {
+                value = skip_space(colon + 1, end);
+                value_length = skip_value(value, end) - value;
+                return true;
+            }
+        }
+        p = quote + 1;
+    }
+    return false;
+}
+
+DashboardDiff::DashboardDiff() : _snapshot_hash(0), _valid(false), _stats() {
+}
+
+bool DashboardDiff::update(const char* json, size_t length) {
+    const char* widgets = nullptr;
+    size_t widgets_len = 0;
+    bool has_widgets = find_value(json, length, "widgets", widgets, widgets_len);
+
+    uint32_t hash = 2166136261u;
+    const char* value = nullptr;
+    size_t value_len = 0;
+    bool is_dashboard = has_widgets;
+    if (has_widgets) {
+        hash = dashboard_hash(widgets, widgets_len, hash);
+    }
+    if (find_value(json, length, "removedWidgets", value, value_len)) {
+        hash = dashboard_hash(value, value_len, hash);
+        is_dashboard = true;
+    }
+    if (find_value(json, length, "commands", value, value_len)) {
+        hash = dashboard_hash(value, value_len, hash);
+        is_dashboard = true;
+    }
+    if (!is_dashboard) {
+        // Not a dashboard snapshot - never skip it
+        hash = dashboard_hash(json, length, hash);
+    }
+
+    if (_valid && hash == _snapshot_hash) {
+        _stats.skipped++;
+        return false;
+    }
+    _snapshot_hash = hash;
+    _valid = true;
+    _stats.processed++;
+    return true;
+}
@@ -0,0 +1,613 @@
+#include "dashboard_extract.h"
+#include "dashboard_codes.h"
+#include <string.h>
+
+// Nesting limit for skipped values (the dashboard nests 6 levels deep)
+static const int MAX_DEPTH = 32;
+
+struct Cursor {
+    const char* p;
+    const char* end;
+};
+
+void dashboard_commands_clear(DashboardCommands& commands) {
+    memset(&commands, 0, sizeof(commands));
+}
+
+void dashboard_copy_str(char* dest, size_t size, const char* src) {
+    if (!src) {
+        dest[0] = '\0';
+        return;
+    }
+    strncpy(dest, src, size - 1);
+    dest[size - 1] = '\0';
+}
+
+static void skip_space(Cursor& c) {
+    while (c.p < c.end && (*c.p == ' ' || *c.p == '\t' || *c.p == '\r' || *c.p == '\n')) {
+        c.p++;
+    }
+}
+
+static bool expect(Cursor& c, char ch) {
+    skip_space(c);
+    if (c.p < c.end && *c.p == ch) {
+        c.p++;
+        return true;
+    }
+    return false;
+}
+
+// Parse a string; copies (truncated) into out if given. Escapes are decoded
+// for the simple forms, \uXXXX becomes '?' (never present in values we use).
+static bool parse_string(Cursor& c, char* out, size_t size) {
+    skip_space(c);
+    if (c.p >= c.end || *c.p != '"') {
+        return false;
+    }
+    c.p++;
+    size_t n = 0;
+    while (c.p < c.end) {
+        char ch = *c.p++;
+        if (ch == '"') {
+            if (out) {
+                out[n] = '\0';
+            }
+            return true;
+        }
+        if (ch == '\\') {
+            if (c.p >= c.end) {
+                return false;
+            }
+            char esc = *c.p++;
+            switch (esc) {
+                case 'n': ch = '\n'; break;
+                case 't': ch = '\t'; break;
+                case 'r': ch = '\r'; break;
+                case 'b': ch = '\b'; break;
+                case 'f': ch = '\f'; break;
+                case 'u':
+                    if (c.end - c.p < 4) {
+                        return false;
+                    }
+                    c.p += 4;
+                    ch = '?';
+                    break;
+                default: ch = esc; break;  // \" \\ \/
+            }
+        }
+        if (out && n + 1 < size) {
+            out[n++] = ch;
+        }
+    }
+    return false;
+}
+
+// Span of a string without copying it (escapes are left as they are)
+static bool parse_string_span(Cursor& c, const char*& str, size_t& length) {
+    skip_space(c);
+    if (c.p >= c.end || *c.p != '"') {
+        return false;
+    }
+    const char* start = ++c.p;
+    while (c.p < c.end && *c.p != '"') {
+        if (*c.p == '\\') {
+            c.p++;
+        }
+        c.p++;
+    }
+    if (c.p >= c.end) {
+        return false;
+    }
+    str = start;
+    length = c.p - start;
+    c.p++;
+    return true;
+}
+
+// Compare the key at the cursor without copying it
+static bool parse_key(Cursor& c, const char*& key, size_t& key_len) {
+    return parse_string_span(c, key, key_len) && expect(c, ':');
+}
+
+static bool key_is(const char* key, size_t key_len, const char* name) {
+    return strlen(name) == key_len && memcmp(key, name, key_len) == 0;
+}
+
+static bool parse_literal(Cursor& c, const char* word) {
+    size_t len = strlen(word);
+    if ((size_t)(c.end - c.p) < len || memcmp(c.p, word, len) != 0) {
+        return false;
+    }
+    c.p += len;
+    return true;
+}
+
+// Parse a number; integer part is kept exactly for timestamps
+static bool parse_number(Cursor& c, int64_t& integer, double& real) {
+    skip_space(c);
+    bool negative = false;
+    if (c.p < c.end && *c.p == '-') {
+        negative = true;
+        c.p++;
+    }
+    if (c.p >= c.end || *c.p < '0' || *c.p > '9') {
+        return false;
+    }
+    uint64_t whole = 0;
+    while (c.p < c.end && *c.p >= '0' && *c.p <= '9') {
+        whole = whole * 10 + (*c.p - '0');
+        c.p++;
+    }
+    double value = (double)whole;
+    bool integral = true;  // As ArduinoJson: "-0" is the integer 0, not -0.0
+    if (c.p < c.end && *c.p == '.') {
+        integral = false;
+        c.p++;
+        double scale = 0.1;
+        while (c.p < c.end && *c.p >= '0' && *c.p <= '9') {
+            value += (*c.p - '0') * scale;
+            scale *= 0.1;
+            c.p++;
+        }
+    }
+    if (c.p < c.end && (*c.p == 'e' || *c.p == 'E')) {
+        integral = false;
+        c.p++;
+        bool exp_negative = false;
+        if (c.p < c.end && (*c.p == '+' || *c.p == '-')) {
+            exp_negative = (*c.p == '-');
+            c.p++;
+        }
+        int exponent = 0;
+        while (c.p < c.end && *c.p >= '0' && *c.p <= '9') {
+            if (exponent < 400) {
+                exponent = exponent * 10 + (*c.p - '0');
+            }
+            c.p++;
+        }
+        for (int i = 0; i < exponent && value != 0; i++) {
+            value = exp_negative ? value / 10 : value * 10;
+        }
+    }
+    integer = negative ? -(int64_t)whole : (int64_t)whole;
+    real = integral ? (double)integer : (negative ? -value : value);
+    return true;
+}
+
+static bool skip_value(Cursor& c, int depth);
+
+static bool skip_container(Cursor& c, int depth, char close, bool is_object) {
+    if (depth > MAX_DEPTH) {
+        return false;
+    }
+    if (expect(c, close)) {
+        return true;
+    }
+    while (true) {
+        if (is_object) {
+            const char* key;
+            size_t key_len;
+            if (!parse_key(c, key, key_len)) {
+                return false;
+            }
+        }
+        if (!skip_value(c, depth + 1)) {
+            return false;
+        }
+        if (expect(c, ',')) {
+            continue;
+        }
+        return expect(c, close);
+    }
+}
+
+static bool skip_value(Cursor& c, int depth) {
+    skip_space(c);
+    if (c.p >= c.end) {
+        return false;
+    }
+    switch (*c.p) {
+        case '"': return parse_string(c, nullptr, 0);
+        case '{': c.p++; return skip_container(c, depth, '}', true);
+        case '[': c.p++; return skip_container(c, depth, ']', false);
+        case 't': return parse_literal(c, "true");
+        case 'f': return parse_literal(c, "false");
+        case 'n': return parse_literal(c, "null");
+        default: {
+            int64_t integer;
+            double real;
+            return parse_number(c, integer, real);
+        }
+    }
+}
+
+// Position the cursor on the value at `path` inside the JSON value [json, json + length)
+static bool find_path(const char* json, size_t length, const char* path, Cursor& c) {
+    c.p = json;
+    c.end = json + length;
+    if (!json) {
+        return false;
+    }
+    int depth = 1;
+    while (true) {
+        size_t segment_len = strcspn(path, ".");
+        bool is_index = segment_len > 0;
+        size_t index = 0;
+        for (size_t i = 0; i < segment_len && is_index; i++) {
+            is_index = path[i] >= '0' && path[i] <= '9';
+            index = index * 10 + (path[i] - '0');
+        }
+        if (is_index) {
+            if (!expect(c, '[') || expect(c, ']')) {
+                return false;
+            }
+            for (size_t i = 0; i < index; i++) {
+                if (!skip_value(c, depth) || !expect(c, ',')) {
+                    return false;
+                }
+            }
+        } else {
+            if (!expect(c, '{') || expect(c, '}')) {
+                return false;
+            }
+            while (true) {
+                const char* key;
+                size_t key_len;
+                if (!parse_key(c, key, key_len)) {
+                    return false;
+                }
+                if (key_len == segment_len && memcmp(key, path, segment_len) == 0) {
+                    break;
+                }
+                if (!skip_value(c, depth) || !expect(c, ',')) {
+                    return false;
+                }
+            }
+        }
+        path += segment_len;
+        if (*path == '\0') {
+            skip_space(c);
+            return c.p < c.end;
+        }
+        path++;
+        if (++depth > MAX_DEPTH) {
+            return false;
+        }
+    }
+}
+
+// Walk one value and note the span of each field whose path ends at it.
+// rest[i] is what is left of field ids[i]'s path below this value; values
+// no field goes into are skipped as a whole. The first of duplicate keys wins.
+static bool collect_fields(Cursor& c, int depth, const char* const* rest, const uint8_t* ids,
+                           size_t count, const char** starts, const char** ends) {
+    skip_space(c);
+    const char* start = c.p;
+    const char* deeper[WIDGET_MAX_FIELDS];
+    uint8_t deeper_ids[WIDGET_MAX_FIELDS];
+    size_t deeper_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (*rest[i]) {
+            deeper[deeper_count] = rest[i];
+            deeper_ids[deeper_count++] = ids[i];
+        }
+    }
+
+    bool ok;
+    bool is_object = c.p < c.end && *c.p == '{';
+    if (deeper_count == 0 || c.p >= c.end || (*c.p != '{' && *c.p != '[')) {
+        ok = skip_value(c, depth);
+    } else if (depth > MAX_DEPTH) {
+        ok = false;
+    } else {
+        c.p++;
+        ok = true;
+        if (!expect(c, is_object ? '}' : ']')) {
+            for (size_t index = 0; ok; index++) {
+                const char* key = nullptr;
+                size_t key_len = 0;
+                if (is_object && !parse_key(c, key, key_len)) {
+                    ok = false;
+                    break;
+                }
+                // Fields whose next segment names this member / element
+                const char* next[WIDGET_MAX_FIELDS];
+                uint8_t next_ids[WIDGET_MAX_FIELDS];
+                size_t next_count = 0;
+                for (size_t i = 0; i < deeper_count; i++) {
+                    const char* path = deeper[i];
+                    size_t segment_len = strcspn(path, ".");
+                    bool match;
+                    if (is_object) {
+                        match = segment_len == key_len && memcmp(path, key, key_len) == 0;
+                    } else {
+                        size_t n = 0;
+                        match = segment_len > 0;
+                        for (size_t k = 0; k < segment_len && match; k++) {
+                            match = path[k] >= '0' && path[k] <= '9';
+                            n = n * 10 + (path[k] - '0');
+                        }
+                        match = match && n == index;
+                    }
+                    if (match) {
+                        next[next_count] = path[segment_len] ? path + segment_len + 1 : path + segment_len;
+                        next_ids[next_count++] = deeper_ids[i];
+                    }
+                }
+                ok = collect_fields(c, depth + 1, next, next_ids, next_count, starts, ends);
+                if (ok && !expect(c, ',')) {
+                    ok = expect(c, is_object ? '}' : ']');
+                    break;
+                }
+            }
+        }
+    }
+    if (!ok) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!*rest[i] && !starts[ids[i]]) {
+            starts[ids[i]] = start;
+            ends[ids[i]] = c.p;
+        }
+    }
+    return true;
+}
+
+JsonSpanOutput::JsonSpanOutput(const char* json, size_t length, const char* const* fields)
+    : _json(json), _length(length), _fields(fields), _field_count(0) {
+    const char* rest[WIDGET_MAX_FIELDS];
+    uint8_t ids[WIDGET_MAX_FIELDS];
+    const char* starts[WIDGET_MAX_FIELDS];
+    const char* ends[WIDGET_MAX_FIELDS];
+    while (fields && _field_count < WIDGET_MAX_FIELDS && fields[_field_count]) {
+        rest[_field_count] = fields[_field_count];
+        ids[_field_count] = (uint8_t)_field_count;
+        starts[_field_count] = nullptr;
+        ends[_field_count] = nullptr;
+        _field_count++;
+    }
+    Cursor c = { json, json + length };
+    if (!json || !collect_fields(c, 2, rest, ids, _field_count, starts, ends)) {
+        _field_count = 0;  // Not expected: the span was checked. Scan per getter instead.
+    }
+    for (size_t i = 0; i < _field_count; i++) {
+        _spans[i].json = starts[i];
+        _spans[i].length = starts[i] ? ends[i] - starts[i] : 0;
+    }
+}
+
+bool JsonSpanOutput::_find(const char* path, const char*& value, const char*& end) const {
+    // The longest field that is `path` or one of its parents
+    size_t best = WIDGET_MAX_FIELDS;
+    size_t best_len = 0;
+    for (size_t i = 0; i < _field_count; i++) {
+        size_t len = strlen(_fields[i]);
+        if (len > best_len && strncmp(path, _fields[i], len) == 0 &&
+            (path[len] == '\0' || path[len] == '.')) {
+            best = i;
+            best_len = len;
+        }
+    }
+    Cursor c;
+    if (best == WIDGET_MAX_FIELDS) {
+        if (!find_path(_json, _length, path, c)) {
+            return false;
+        }
+    } else if (!_spans[best].json) {
+        return false;
+    } else if (path[best_len] == '\0') {
+        c.p = _spans[best].json;
+        c.end = c.p + _spans[best].length;
+    } else if (!find_path(_spans[best].json, _spans[best].length, path + best_len + 1, c)) {
+        return false;
+    }
+    value = c.p;
+    end = c.end;
+    return true;
+}
+
+static bool is_number_start(const Cursor& c) {
+    return c.p < c.end && (*c.p == '-' || (*c.p >= '0' && *c.p <= '9'));
+}
+
+bool JsonSpanOutput::get_string(const char* path, char* out, size_t size) const {
+    Cursor c;
+    if (!_find(path, c.p, c.end) || *c.p != '"') {
+        return false;
+    }
+    return parse_string(c, out, size);
+}
+
+bool JsonSpanOutput::get_int(const char* path, int64_t& out) const {
+    Cursor c;
+    int64_t integer;
+    double real;
+    if (!_find(path, c.p, c.end) || !is_number_start(c) ||
+        !parse_number(c, integer, real)) {
+        return false;
+    }
+    out = integer;
+    return true;
+}
+
+bool JsonSpanOutput::get_float(const char* path, float& out) const {
+    Cursor c;
+    int64_t integer;
+    double real;
+    if (!_find(path, c.p, c.end) || !is_number_start(c) ||
+        !parse_number(c, integer, real)) {
+        return false;
+    }
+    out = (float)real;
+    return true;
+}
+
+bool JsonSpanOutput::get_bool(const char* path, bool& out) const {
+    Cursor c;
+    if (!_find(path, c.p, c.end)) {
+        return false;
+    }
+    if (parse_literal(c, "true")) {
+        out = true;
+        return true;
+    }
+    if (parse_literal(c, "false")) {
+        out = false;
+        return true;
+    }
+    return false;
+}
+
+struct ExtractTarget {
+    WidgetRegistry& registry;
+    DashboardCommands& commands;
+};
+
+static bool parse_widget(Cursor& c, ExtractTarget& target) {
+    if (!expect(c, '{')) {
+        return skip_value(c, 1);
+    }
+    const char* code = nullptr;
+    size_t code_len = 0;
+    const char* output = nullptr;
+    size_t output_len = 0;
+    if (!expect(c, '}')) {
+        while (true) {
+            const char* key;
+            size_t key_len;
+            if (!parse_key(c, key, key_len)) {
+                return false;
+            }
+            bool ok;
+            skip_space(c);
+            if (key_is(key, key_len, "code") && c.p < c.end && *c.p == '"') {
+                ok = parse_string_span(c, code, code_len);
+            } else if (key_is(key, key_len, "output")) {
+                // Only located here; the handler reads the fields it needs
+                output = c.p;
+                ok = skip_value(c, 2);
+                output_len = c.p - output;
+            } else {
+                ok = skip_value(c, 2);
+            }
+            if (!ok) {
+                return false;
+            }
+            if (expect(c, ',')) {
+                continue;
+            }
+            if (!expect(c, '}')) {
+                return false;
+            }
+            break;
+        }
+    }
+    // The code may come after the output - dispatch only now
+    if (code) {
+        DashboardWidgetCode widget = dashboard_widget_code(code, code_len);
+        WidgetHandler* handler = target.registry.find(widget);
+        target.registry.dispatch(widget, JsonSpanOutput(handler ? output : nullptr, output_len,
+                                                        handler ? handler->fields() : nullptr));
+    }
+    return true;
+}
+
+static bool parse_command(Cursor& c, ExtractTarget& target) {
+    if (!expect(c, '{')) {
+        return skip_value(c, 1);
+    }
+    DashboardCommand command;
+    command.id[0] = '\0';
+    command.status[0] = '\0';
+    if (!expect(c, '}')) {
+        while (true) {
+            const char* key;
+            size_t key_len;
+            if (!parse_key(c, key, key_len)) {
+                return false;
+            }
+            bool ok;
+            skip_space(c);
+            bool is_string = (c.p < c.end && *c.p == '"');
+            if (is_string && key_is(key, key_len, "id")) {
+                ok = parse_string(c, command.id, sizeof(command.id));
+            } else if (is_string && key_is(key, key_len, "status")) {
+                ok = parse_string(c, command.status, sizeof(command.status));
+            } else {
+                ok = skip_value(c, 2);
+            }
+            if (!ok) {
+                return false;
+            }
+            if (expect(c, ',')) {
+                continue;
+            }
+            if (!expect(c, '}')) {
+                return false;
+            }
+            break;
+        }
+    }
+    DashboardCommands& commands = target.commands;
+    if (commands.count < DASHBOARD_MAX_COMMANDS) {
+        commands.items[commands.count++] = command;
+    }
+    return true;
+}
+
+// Parse an array, calling element() for each entry
+static bool parse_array(Cursor& c, ExtractTarget& target,
+                        bool (*element)(Cursor&, ExtractTarget&)) {
+    if (!expect(c, '[')) {
+        return skip_value(c, 1);
+    }
+    if (expect(c, ']')) {
+        return true;
+    }
+    while (true) {
+        if (!element(c, target)) {
+            return false;
+        }
+        if (expect(c, ',')) {
+            continue;
+        }
+        return expect(c, ']');
+    }
+}
+
+bool dashboard_extract(const char* json, size_t length,
+                       WidgetRegistry& registry, DashboardCommands& commands) {
+    dashboard_commands_clear(commands);
+    ExtractTarget target = { registry, commands };
+    Cursor c = { json, json + length };
+    if (!expect(c, '{')) {
+        return false;
+    }
+    if (expect(c, '}')) {
+        return true;
+    }
+    while (true) {
+        const char* key;
+        size_t key_len;
+        if (!parse_key(c, key, key_len)) {
+            return false;
+        }
+        bool ok;
+        if (key_is(key, key_len, "widgets")) {
+            ok = parse_array(c, target, parse_widget);
+        } else if (key_is(key, key_len, "commands")) {
+            ok = parse_array(c, target, parse_command);
+        } else {
+            ok = skip_value(c, 1);
+        }
+        if (!ok) {
+            return false;
+        }
+        if (expect(c, ',')) {
+            continue;
+        }
+        return expect(c, '}');
+    }
+}
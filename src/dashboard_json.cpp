@@ -0,0 +1,170 @@
+#include "dashboard_json.h"
+#include "config.h"
+#include "json_allocator.h"
+#include "app_log.h"
+#include "dashboard_codes.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Keep one output path in the filter. A numeric segment keeps every element:
+// ArduinoJson filters an array by its first entry. A `true` keeps the whole
+// value, so it wins over deeper paths, whichever handler listed which first.
+static void filter_add_path(JsonObject node, const char* path) {
+    char key[32];
+    while (true) {
+        size_t len = strcspn(path, ".");
+        if (len >= sizeof(key)) {
+            return;
+        }
+        memcpy(key, path, len);
+        key[len] = '\0';
+        path += len;
+        if (node[key].is<bool>()) {
+            return;  // Kept whole already
+        }
+        if (*path == '\0') {
+            node[key] = true;  // Replaces any deeper paths under the key
+            return;
+        }
+        path++;
+        if (*path >= '0' && *path <= '9') {
+            path += strcspn(path, ".");
+            JsonArray array = node[key].is<JsonArray>() ? node[key].as<JsonArray>()
+                                                        : node[key].to<JsonArray>();
+            if (array.size() && array[0].is<bool>()) {
+                return;
+            }
+            if (*path == '\0') {
+                if (array.size() == 0) {
+                    array.add(true);
+                } else {
+                    array[0] = true;
+                }
+                return;
+            }
+            path++;
+            node = array.size() ? array[0].as<JsonObject>() : array.add<JsonObject>();
+        } else {
+            node = node[key].is<JsonObject>() ? node[key].as<JsonObject>()
+                                              : node[key].to<JsonObject>();
+        }
+    }
+}
+
+// Keep only what the handlers read: widget codes, the output fields each
+// registered handler lists and command results. removedWidgets, min/max/step
+// tables etc. are skipped by the parser instead of being copied into the document.
+const JsonDocument& dashboard_json_filter(const WidgetRegistry& registry) {
+    static JsonDocument filter;
+    if (filter.isNull()) {
+        JsonObject widget = filter["widgets"].add<JsonObject>();
+        widget["code"] = true;
+        JsonObject output = widget["output"].to<JsonObject>();
+        for (size_t code = 1; code < WIDGET_CODE_COUNT; code++) {
+            WidgetHandler* handler = registry.find((DashboardWidgetCode)code);
+            if (!handler) continue;
+            for (const char* const* field = handler->fields(); *field; field++) {
+                filter_add_path(output, *field);
+            }
+        }
+        JsonObject command = filter["commands"].add<JsonObject>();
+        command["id"] = true;
+        command["status"] = true;
+    }
+    return filter;
+}
+
+// WidgetOutput over a widget's "output" object in the JsonDocument
+class JsonDocumentOutput : public WidgetOutput {
+public:
+    explicit JsonDocumentOutput(JsonVariantConst output) : _output(output) {}
+    
+    bool get_string(const char* path, char* out, size_t size) const override {
+        JsonVariantConst value = _find(path);
+        if (!value.is<const char*>()) return false;
+        dashboard_copy_str(out, size, value.as<const char*>());
+        return true;
+    }
+    
+    bool get_int(const char* path, int64_t& out) const override {
+        JsonVariantConst value = _find(path);
+        if (!value.is<long long>() && !value.is<double>()) return false;
+        out = value.as<long long>();
+        return true;
+    }
+    
+    bool get_float(const char* path, float& out) const override {
+        JsonVariantConst value = _find(path);
+        if (!value.is<long long>() && !value.is<double>()) return false;
+        out = value.as<float>();
+        return true;
+    }
+    
+    bool get_bool(const char* path, bool& out) const override {
+        JsonVariantConst value = _find(path);
+        if (!value.is<bool>()) return false;
+        out = value.as<bool>();
+        return true;
+    }
+    
+private:
+    JsonVariantConst _output;
+    
+    JsonVariantConst _find(const char* path) const {
+        JsonVariantConst node = _output;
+        char key[32];
+        while (*path) {
+            size_t len = strcspn(path, ".");
+            if (len == 0 || len >= sizeof(key)) return JsonVariantConst();
+            memcpy(key, path, len);
+            key[len] = '\0';
+            if (key[0] >= '0' && key[0] <= '9') {
+                node = node[(size_t)atoi(key)];
+            } else {
+                node = node[key];
+            }
+            path += len;
+            if (*path == '.') path++;
+        }
+        return node;
+    }
+};
+
+bool dashboard_parse_json(const char* message, size_t length,
+                          WidgetRegistry& registry, DashboardCommands& commands) {
+    // Parse JSON message with large buffer for La Marzocco messages (can be 2-3KB)
+    JsonDocument doc(&json_dashboard_arena);
+    
+    // Parse straight from the STOMP body span (no intermediate String copy)
+#if DASHBOARD_JSON_FILTER
+    DeserializationError error = deserializeJson(doc, message, length,
+                                                 DeserializationOption::Filter(dashboard_json_filter(registry)));
+#else
+    DeserializationError error = deserializeJson(doc, message, length);
+#endif
+    
+    if (error) {
+        APP_LOGE(MACHINE, "❌ JSON parse error: %s (code %d)", error.c_str(), (int)error.code());
+        
+        if (error == DeserializationError::NoMemory) {
+            APP_LOGW(MACHINE, "💡 JSON document is too large - increase buffer size");
+        }
+        return false;
+    }
+    
+    for (JsonVariantConst widget : doc["widgets"].as<JsonArrayConst>()) {
+        const char* code = widget["code"].as<const char*>();
+        if (!code) continue;
+        registry.dispatch(dashboard_widget_code(code, strlen(code)),
+                          JsonDocumentOutput(widget["output"]));
+    }
+    
+    dashboard_commands_clear(commands);
+    for (JsonVariantConst cmd : doc["commands"].as<JsonArrayConst>()) {
+        if (commands.count >= DASHBOARD_MAX_COMMANDS) break;
+        DashboardCommand& command = commands.items[commands.count++];
+        dashboard_copy_str(command.id, DASHBOARD_ID_LEN, cmd["id"].as<const char*>());
+        dashboard_copy_str(command.status, DASHBOARD_STR_LEN, cmd["status"].as<const char*>());
+    }
+    return true;
+}
@@ -0,0 +1,371 @@
+#include "dashboard_widgets.h"
+#include "boiler_display.h"
+#include "app_log.h"
+#include <Arduino.h>
+#include <stdio.h>
+
+// Read a status string and map it to its enum (UNKNOWN if missing)
+static MachineStatus read_machine_status(const WidgetOutput& output) {
+    char status[DASHBOARD_STR_LEN] = "";
+    output.get_string("status", status, sizeof(status));
+    return machine_status_from_string(status);
+}
+
+static BoilerStatus read_boiler_status(const WidgetOutput& output) {
+    char status[DASHBOARD_STR_LEN] = "";
+    output.get_string("status", status, sizeof(status));
+    return boiler_status_from_string(status);
+}
+
+// Log a widget that left the dashboard; true if there is nothing else to print
+static bool print_removed(DashboardWidgetCode code, bool present) {
+    if (!present) {
+        APP_LOGD(WIDGETS, "%s: removed", dashboard_widget_name(code));
+    }
+    return !present;
+}
+
+// ---------------------------------------------------------------------------
+// CMMachineStatus
+
+static const char* const MACHINE_STATUS_FIELDS[] = {
+    "status", "mode", "brewingStartTime", nullptr
+};
+
+const char* const* MachineStatusWidget::fields() const {
+    return MACHINE_STATUS_FIELDS;
+}
+
+void MachineStatusWidget::read(const WidgetOutput& output, MachineStatusWidgetState& state) {
+    state.status = read_machine_status(output);
+    output.get_string("mode", state.mode, sizeof(state.mode));
+    output.get_int("brewingStartTime", state.brewing_start_time);
+}
+
+void MachineStatusWidget::print(DashboardWidgetCode code) const {
+    if (print_removed(code, present())) return;
+    APP_LOGD(WIDGETS, "%s: %s (mode: %s), BrewingStartTime: %lld", dashboard_widget_name(code),
+             machine_status_name(state().status), state().mode[0] ? state().mode : "null",
+             (long long)state().brewing_start_time);
+}
+
+// ---------------------------------------------------------------------------
+// CMCoffeeBoiler
+
+static const char* const COFFEE_BOILER_FIELDS[] = {
+    "status", "readyStartTime", "targetTemperature", nullptr
+};
+
+const char* const* CoffeeBoilerWidget::fields() const {
+    return COFFEE_BOILER_FIELDS;
+}
+
+void CoffeeBoilerWidget::read(const WidgetOutput& output, CoffeeBoilerWidgetState& state) {
+    state.status = read_boiler_status(output);
+    output.get_int("readyStartTime", state.ready_start_time);
+    output.get_float("targetTemperature", state.target_temperature);
+}
+
+void CoffeeBoilerWidget::print(DashboardWidgetCode code) const {
+    if (print_removed(code, present())) return;
+    APP_LOGD(WIDGETS, "%s: %s, TargetTemp: %.1f°C, ReadyStartTime: %lld", dashboard_widget_name(code),
+             boiler_status_name(state().status), state().target_temperature,
+             (long long)state().ready_start_time);
+}
+
+// ---------------------------------------------------------------------------
+// CMSteamBoilerLevel
+
+static const char* const STEAM_BOILER_LEVEL_FIELDS[] = {
+    "status", "readyStartTime", "targetLevel", nullptr
+};
+
+const char* const* SteamBoilerLevelWidget::fields() const {
+    return STEAM_BOILER_LEVEL_FIELDS;
+}
+
+void SteamBoilerLevelWidget::read(const WidgetOutput& output, SteamBoilerLevelWidgetState& state) {
+    state.status = read_boiler_status(output);
+    output.get_int("readyStartTime", state.ready_start_time);
+    output.get_string("targetLevel", state.target_level, sizeof(state.target_level));
+}
+
+void SteamBoilerLevelWidget::print(DashboardWidgetCode code) const {
+    if (print_removed(code, present())) return;
+    APP_LOGD(WIDGETS, "%s: %s, TargetLevel: %s, ReadyStartTime: %lld", dashboard_widget_name(code),
+             boiler_status_name(state().status),
+             state().target_level[0] ? state().target_level : "null",
+             (long long)state().ready_start_time);
+}
+
+// ---------------------------------------------------------------------------
+// CMNoWater
+
+static const char* const NO_WATER_FIELDS[] = {
+    "allarm", nullptr
+};
+
+const char* const* NoWaterWidget::fields() const {
+    return NO_WATER_FIELDS;
+}
+
+void NoWaterWidget::read(const WidgetOutput& output, NoWaterWidgetState& state) {
+    output.get_bool("allarm", state.alarm);
+}
+
+void NoWaterWidget::print(DashboardWidgetCode code) const {
+    if (print_removed(code, present())) return;
+    APP_LOGD(WIDGETS, "%s: %s", dashboard_widget_name(code), state().alarm ? "alarm ⚠️" : "ok");
+}
+
+// ---------------------------------------------------------------------------
+// CMSteamBoilerTemperature
+
+static const char* const STEAM_BOILER_TEMPERATURE_FIELDS[] = {
+    "status", "enabled", "readyStartTime", "targetTemperature", nullptr
+};
+
+const char* const* SteamBoilerTemperatureWidget::fields() const {
+    return STEAM_BOILER_TEMPERATURE_FIELDS;
+}
+
+void SteamBoilerTemperatureWidget::read(const WidgetOutput& output,
+                                        SteamBoilerTemperatureWidgetState& state) {
+    state.status = read_boiler_status(output);
+    output.get_bool("enabled", state.enabled);
+    output.get_int("readyStartTime", state.ready_start_time);
+    output.get_float("targetTemperature", state.target_temperature);
+}
+
+void SteamBoilerTemperatureWidget::print(DashboardWidgetCode code) const {
+    if (print_removed(code, present())) return;
+    APP_LOGD(WIDGETS, "%s: %s (%s), TargetTemp: %.1f°C, ReadyStartTime: %lld",
+             dashboard_widget_name(code), boiler_status_name(state().status),
+             state().enabled ? "enabled" : "disabled", state().target_temperature,
+             (long long)state().ready_start_time);
+}
+
+// ---------------------------------------------------------------------------
+// CMPreBrewing
+
+static const char* const PRE_BREWING_FIELDS[] = {
+    "mode", "times.PreBrewing.0.seconds", "times.PreInfusion.0.seconds", nullptr
+};
+
+const char* const* PreBrewingWidget::fields() const {
+    return PRE_BREWING_FIELDS;
+}
+
+void PreBrewingWidget::read(const WidgetOutput& output, PreBrewingWidgetState& state) {
+    output.get_string("mode", state.mode, sizeof(state.mode));
+    if (state.mode[0]) {
+        // Times are listed per mode: times.<mode>[group].seconds.In / Out
+        char path[64];
+        snprintf(path, sizeof(path), "times.%s.0.seconds.In", state.mode);
+        output.get_float(path, state.seconds_in);
+        snprintf(path, sizeof(path), "times.%s.0.seconds.Out", state.mode);
+        output.get_float(path, state.seconds_out);
+    }
+}
+
+void PreBrewingWidget::print(DashboardWidgetCode code) const {
+    if (print_removed(code, present())) return;
+    APP_LOGD(WIDGETS, "%s: %s, In: %.1fs, Out: %.1fs", dashboard_widget_name(code),
+             state().mode[0] ? state().mode : "null", state().seconds_in, state().seconds_out);
+}
+
+// ---------------------------------------------------------------------------
+// CMBackFlush
+
+static const char* const BACK_FLUSH_FIELDS[] = {
+    "status", "lastCleaningStartTime", nullptr
+};
+
+const char* const* BackFlushWidget::fields() const {
+    return BACK_FLUSH_FIELDS;
+}
+
+void BackFlushWidget::read(const WidgetOutput& output, BackFlushWidgetState& state) {
+    output.get_string("status", state.status, sizeof(state.status));
+    output.get_int("lastCleaningStartTime", state.last_cleaning_start_time);
+}
+
+void BackFlushWidget::print(DashboardWidgetCode code) const {
+    if (print_removed(code, present())) return;
+    APP_LOGD(WIDGETS, "%s: %s, last cleaning: %lld", dashboard_widget_name(code),
+             state().status[0] ? state().status : "null",
+             (long long)state().last_cleaning_start_time);
+}
+
+// ---------------------------------------------------------------------------
+// CMGroupDoses
+
+static const char* const GROUP_DOSES_FIELDS[] = {
+    "mode", "doses", nullptr
+};
+
+const char* const* GroupDosesWidget::fields() const {
+    return GROUP_DOSES_FIELDS;
+}
+
+void GroupDosesWidget::read(const WidgetOutput& output, GroupDosesWidgetState& state) {
+    output.get_string("mode", state.mode, sizeof(state.mode));
+    if (state.mode[0]) {
+        // Doses are listed per mode: doses.<mode>[index].dose
+        char path[64];
+        snprintf(path, sizeof(path), "doses.%s.0.dose", state.mode);
+        output.get_float(path, state.dose);
+    }
+}
+
+void GroupDosesWidget::print(DashboardWidgetCode code) const {
+    if (print_removed(code, present())) return;
+    APP_LOGD(WIDGETS, "%s: %s, first dose: %.1f", dashboard_widget_name(code),
+             state().mode[0] ? state().mode : "null", state().dose);
+}
+
+// ---------------------------------------------------------------------------
+// CMBrewByWeightDoses
+
+static const char* const BREW_BY_WEIGHT_FIELDS[] = {
+    "mode", "doses.Dose1.dose", "doses.Dose2.dose", "scaleConnected", nullptr
+};
+
+const char* const* BrewByWeightWidget::fields() const {
+    return BREW_BY_WEIGHT_FIELDS;
+}
+
+void BrewByWeightWidget::read(const WidgetOutput& output, BrewByWeightWidgetState& state) {
+    output.get_string("mode", state.mode, sizeof(state.mode));
+    output.get_float("doses.Dose1.dose", state.dose1);
+    output.get_float("doses.Dose2.dose", state.dose2);
+    output.get_bool("scaleConnected", state.scale_connected);
+}
+
+void BrewByWeightWidget::print(DashboardWidgetCode code) const {
+    if (print_removed(code, present())) return;
+    APP_LOGD(WIDGETS, "%s: %s, Dose1: %.1fg, Dose2: %.1fg, %s", dashboard_widget_name(code),
+             state().mode[0] ? state().mode : "null", state().dose1, state().dose2,
+             state().scale_connected ? "scale connected" : "no scale");
+}
+
+// ---------------------------------------------------------------------------
+// Grinder G* widgets
+
+static const char* const GRINDER_FIELDS[] = {
+    "status", "mode", "enabled", nullptr
+};
+
+GrinderWidgets::GrinderWidgets() {
+    memset(_states, 0, sizeof(_states));
+}
+
+void GrinderWidgets::register_all(WidgetRegistry& registry) {
+    for (int code = WIDGET_GRINDER_FIRST; code <= WIDGET_GRINDER_LAST; code++) {
+        registry.add((DashboardWidgetCode)code, *this);
+    }
+}
+
+const char* const* GrinderWidgets::fields() const {
+    return GRINDER_FIELDS;
+}
+
+bool GrinderWidgets::_commit(DashboardWidgetCode code, const GrinderWidgetState& next) {
+    GrinderWidgetState& current = _states[code - WIDGET_GRINDER_FIRST];
+    bool changed = memcmp(&current, &next, sizeof(next)) != 0;
+    memcpy(&current, &next, sizeof(next));
+    return changed;
+}
+
+bool GrinderWidgets::update(DashboardWidgetCode code, const WidgetOutput& output) {
+    GrinderWidgetState next;
+    memset(&next, 0, sizeof(next));
+    next.present = true;
+    output.get_string("status", next.status, sizeof(next.status));
+    output.get_string("mode", next.mode, sizeof(next.mode));
+    output.get_bool("enabled", next.enabled);
+    return _commit(code, next);
+}
+
+bool GrinderWidgets::clear(DashboardWidgetCode code) {
+    GrinderWidgetState next;
+    memset(&next, 0, sizeof(next));
+    return _commit(code, next);
+}
+
+void GrinderWidgets::print(DashboardWidgetCode code) const {
+    const GrinderWidgetState& grinder = state(code);
+    if (print_removed(code, grinder.present)) return;
+    APP_LOGD(WIDGETS, "%s: %s, mode: %s%s", dashboard_widget_name(code),
+             grinder.status[0] ? grinder.status : "-", grinder.mode[0] ? grinder.mode : "-",
+             grinder.enabled ? ", enabled" : "");
+}
+
+// ---------------------------------------------------------------------------
+
+void DashboardWidgets::register_displayed(WidgetRegistry& registry) {
+    registry.add(WIDGET_MACHINE_STATUS, machine);
+    registry.add(WIDGET_COFFEE_BOILER, coffee);
+    registry.add(WIDGET_STEAM_BOILER_LEVEL, steam);
+    registry.add(WIDGET_NO_WATER, no_water);
+    registry.add(WIDGET_STEAM_BOILER_TEMPERATURE, steam_temperature);
+}
+
+void DashboardWidgets::register_all(WidgetRegistry& registry) {
+    register_displayed(registry);
+    registry.add(WIDGET_PRE_BREWING, pre_brewing);
+    registry.add(WIDGET_BACK_FLUSH, back_flush);
+    registry.add(WIDGET_GROUP_DOSES, group_doses);
+    registry.add(WIDGET_BREW_BY_WEIGHT_DOSES, brew_by_weight);
+    grinders.register_all(registry);
+}
+
+void machine_state_from_widgets(const MachineStatusWidget& machine,
+                                const CoffeeBoilerWidget& coffee,
+                                const SteamBoilerLevelWidget& steam,
+                                const SteamBoilerTemperatureWidget& steam_temperature,
+                                const NoWaterWidget& no_water,
+                                MachineState& state) {
+    memset(&state, 0, sizeof(state));
+
+    state.machine = machine.state().status;
+    state.brewing = state.machine == MACHINE_STATUS_BREWING;
+    if (state.brewing) {
+        state.brewing_start_time = machine.state().brewing_start_time;
+    }
+
+    BoilerSnapshot& coffee_boiler = state.boilers[BOILER_COFFEE];
+    coffee_boiler.status = coffee.state().status;
+    coffee_boiler.ready_start_time = coffee.state().ready_start_time;
+    if (coffee.state().target_temperature > 0) {
+        snprintf(coffee_boiler.target, sizeof(coffee_boiler.target), "%.0f°C",
+                 coffee.state().target_temperature);
+    }
+
+    BoilerSnapshot& steam_boiler = state.boilers[BOILER_STEAM];
+    const char* level = steam.state().target_level;
+    if (!steam.present() && steam_temperature.present()) {
+        // Temperature-controlled steam boiler: same arc, target in °C
+        steam_boiler.status = steam_temperature.state().status;
+        steam_boiler.ready_start_time = steam_temperature.state().ready_start_time;
+        if (steam_temperature.state().target_temperature > 0) {
+            snprintf(steam_boiler.target, sizeof(steam_boiler.target), "%.0f°C",
+                     steam_temperature.state().target_temperature);
+        }
+    } else {
+        steam_boiler.status = steam.state().status;
+        steam_boiler.ready_start_time = steam.state().ready_start_time;
+    }
+    if (steam.present() && level[0]) {
+        // Convert "Level2" to "L2", "Level1" to "L1", etc.
+        if (strncmp(level, "Level", 5) == 0) {
+            snprintf(steam_boiler.target, sizeof(steam_boiler.target), "L%s", level + 5);
+        } else {
+            dashboard_copy_str(steam_boiler.target, sizeof(steam_boiler.target), level);
+        }
+    }
+
+    state.no_water = no_water.state().alarm ||
+                     coffee_boiler.status == BOILER_STATUS_NO_WATER ||
+                     steam_boiler.status == BOILER_STATUS_NO_WATER;
+}
@@ -0,0 +1,170 @@
+#include "json_allocator.h"
+#include "config.h"
+#include <esp_heap_caps.h>
+#include <stdlib.h>
+#include <string.h>
+
+JsonArena json_dashboard_arena(JSON_ARENA_DASHBOARD_SIZE);
+JsonArena json_api_arena(JSON_ARENA_API_SIZE);
+
+// Size header in front of every block; 8 bytes keeps the payload aligned
+struct BlockHeader {
+    uint32_t size;
+    uint32_t in_arena;
+};
+static_assert(sizeof(BlockHeader) == 8, "block header must keep 8-byte alignment");
+
+static size_t round_up(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+static BlockHeader* header_of(void* ptr) {
+    return (BlockHeader*)((uint8_t*)ptr - sizeof(BlockHeader));
+}
+
+JsonArena::JsonArena(size_t capacity)
+    : _buffer(nullptr), _capacity(capacity), _top(0), _live(0),
+      _current(0), _peak(0), _stats() {
+    portMUX_INITIALIZE(&_lock);
+}
+
+bool JsonArena::begin() {
+    if (_buffer) {
+        return true;
+    }
+    _buffer = (uint8_t*)heap_caps_malloc(_capacity, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return _buffer != nullptr;
+}
+
+bool JsonArena::_owns(const void* ptr) const {
+    return _buffer && (const uint8_t*)ptr >= _buffer && (const uint8_t*)ptr < _buffer + _capacity;
+}
+
+void JsonArena::_add(size_t size) {
+    _current += size;
+    if (_current > _peak) {
+        _peak = _current;
+    }
+}
+
+void* JsonArena::_heap_allocate(size_t size) {
+    // Prefer PSRAM here too - the internal heap is needed for TLS buffers
+    BlockHeader* block = (BlockHeader*)heap_caps_malloc(size + sizeof(BlockHeader),
+                                                        MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!block) {
+        block = (BlockHeader*)malloc(size + sizeof(BlockHeader));
+    }
+    if (!block) {
+        return nullptr;
+    }
+    block->size = size;
+    block->in_arena = 0;
+    portENTER_CRITICAL(&_lock);
+    _stats.fallbacks++;
+    _add(size);
+    portEXIT_CRITICAL(&_lock);
+    return block + 1;
+}
+
+void* JsonArena::allocate(size_t size) {
+    size_t needed = sizeof(BlockHeader) + round_up(size);
+    portENTER_CRITICAL(&_lock);
+    if (_buffer && needed <= _capacity - _top) {
+        BlockHeader* block = (BlockHeader*)(_buffer + _top);
+        block->size = size;
+        block->in_arena = 1;
+        _top += needed;
+        _live++;
+        _add(size);
+        if (_top > _stats.high_water) {
+            _stats.high_water = _top;
+        }
+        portEXIT_CRITICAL(&_lock);
+        return block + 1;
+    }
+    portEXIT_CRITICAL(&_lock);
+    return _heap_allocate(size);
+}
+
+void JsonArena::deallocate(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    BlockHeader* block = header_of(ptr);
+    if (!_owns(block)) {
+        portENTER_CRITICAL(&_lock);
+        _current -= block->size;
+        portEXIT_CRITICAL(&_lock);
+        free(block);
+        return;
+    }
+    portENTER_CRITICAL(&_lock);
+    _current -= block->size;
+    _live--;
+    if (_live == 0) {
+        _top = 0;
+        _stats.resets++;
+    } else if ((uint8_t*)ptr + round_up(block->size) == _buffer + _top) {
+        // Newest block: give its space back straight away
+        _top = (uint8_t*)block - _buffer;
+    }
+    portEXIT_CRITICAL(&_lock);
+}
+
+void* JsonArena::reallocate(void* ptr, size_t new_size) {
+    if (!ptr) {
+        return allocate(new_size);
+    }
+    BlockHeader* block = header_of(ptr);
+    size_t old_size = block->size;
+
+    if (!_owns(block)) {
+        BlockHeader* resized = (BlockHeader*)realloc(block, new_size + sizeof(BlockHeader));
+        if (!resized) {
+            return nullptr;
+        }
+        resized->size = new_size;
+        portENTER_CRITICAL(&_lock);
+        _current -= old_size;
+        _add(new_size);
+        portEXIT_CRITICAL(&_lock);
+        return resized + 1;
+    }
+
+    portENTER_CRITICAL(&_lock);
+    size_t offset = (uint8_t*)ptr - _buffer;
+    bool newest = offset + round_up(old_size) == _top;
+    if (newest && round_up(new_size) <= _capacity - offset) {
+        // Grow or shrink in place (string builders and shrinkToFit hit this)
+        _top = offset + round_up(new_size);
+        if (_top > _stats.high_water) {
+            _stats.high_water = _top;
+        }
+    } else if (new_size > old_size) {
+        portEXIT_CRITICAL(&_lock);
+        void* moved = allocate(new_size);
+        if (!moved) {
+            return nullptr;
+        }
+        memcpy(moved, ptr, old_size);
+        deallocate(ptr);
+        return moved;
+    }
+    // Shrinking an older block keeps its space until the arena rewinds
+    block->size = new_size;
+    _current -= old_size;
+    _add(new_size);
+    portEXIT_CRITICAL(&_lock);
+    return ptr;
+}
+
+bool JsonArena::reset() {
+    portENTER_CRITICAL(&_lock);
+    bool idle = _live == 0;
+    if (idle && _top != 0) {
+        _top = 0;
+        _stats.resets++;
+    }
+    portEXIT_CRITICAL(&_lock);
+    return idle;
+}
@@ -1,9 +1,11 @@
 #include "lamarzocco_auth.h"
 #include <WiFi.h>
 #include <esp_random.h>
+#include <esp_mac.h>
 #include <string.h>
 #include "config.h"
 #include "mbedtls/md.h"
+#include "mbedtls/gcm.h"
 
 // Base64 encoding table
 static const char base64_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
@@ -458,3 +460,86 @@ bool LaMarzoccoAuth::load_installation_key(Preferences& prefs, InstallationKey&
     return true;
 }
 
+// Sealed blob layout: IV | ciphertext | tag
+static const size_t SEAL_IV_LEN = 12;
+static const size_t SEAL_TAG_LEN = 16;
+
+bool LaMarzoccoAuth::derive_storage_key(const InstallationKey& key, uint8_t* key_out) {
+    // HMAC-SHA256(installation secret, label | MAC): a copied NVS partition
+    // does not open on another chip
+    uint8_t message[13 + 6] = {'t', 'o', 'k', 'e', 'n', '-', 's', 't', 'o', 'r', 'a', 'g', 'e'};
+    if (esp_efuse_mac_get_default(message + 13) != ESP_OK) {
+        return false;
+    }
+    const mbedtls_md_info_t* md = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+    return mbedtls_md_hmac(md, key.secret, 32, message, sizeof(message), key_out) == 0;
+}
+
+String LaMarzoccoAuth::seal(const InstallationKey& key, const String& aad, const String& plain) {
+    uint8_t aes_key[32];
+    if (!derive_storage_key(key, aes_key)) {
+        return String();
+    }
+    size_t len = plain.length();
+    uint8_t* blob = (uint8_t*)malloc(SEAL_IV_LEN + len + SEAL_TAG_LEN);
+    if (!blob) {
+        return String();
+    }
+    uint8_t* iv = blob;
+    uint8_t* ciphertext = blob + SEAL_IV_LEN;
+    uint8_t* tag = ciphertext + len;
+    esp_fill_random(iv, SEAL_IV_LEN);
+    
+    mbedtls_gcm_context gcm;
+    mbedtls_gcm_init(&gcm);
+    int ret = mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, aes_key, 256);
+    if (ret == 0) {
+        ret = mbedtls_gcm_crypt_and_tag(&gcm, MBEDTLS_GCM_ENCRYPT, len, iv, SEAL_IV_LEN,
+                                        (const uint8_t*)aad.c_str(), aad.length(),
+                                        (const uint8_t*)plain.c_str(), ciphertext, SEAL_TAG_LEN, tag);
+    }
+    mbedtls_gcm_free(&gcm);
+    memset(aes_key, 0, sizeof(aes_key));
+    
+    String sealed = ret == 0 ? base64_encode(blob, SEAL_IV_LEN + len + SEAL_TAG_LEN) : String();
+    free(blob);
+    return sealed;
+}
+
+bool LaMarzoccoAuth::unseal(const InstallationKey& key, const String& aad, const String& sealed, String& plain) {
+    // base64 decodes to at most 3/4 of its length
+    size_t blob_size = sealed.length() / 4 * 3 + 3;
+    if (blob_size < SEAL_IV_LEN + SEAL_TAG_LEN) {
+        return false;
+    }
+    uint8_t* blob = (uint8_t*)malloc(blob_size + 1);
+    if (!blob) {
+        return false;
+    }
+    size_t blob_len = 0;
+    bool ok = base64_decode(sealed, blob, &blob_len) && blob_len >= SEAL_IV_LEN + SEAL_TAG_LEN;
+    
+    uint8_t aes_key[32];
+    ok = ok && derive_storage_key(key, aes_key);
+    if (ok) {
+        size_t len = blob_len - SEAL_IV_LEN - SEAL_TAG_LEN;
+        uint8_t* ciphertext = blob + SEAL_IV_LEN;
+        // Decrypted in place; the tag is copied out first
+        uint8_t tag[SEAL_TAG_LEN];
+        memcpy(tag, ciphertext + len, SEAL_TAG_LEN);
+        mbedtls_gcm_context gcm;
+        mbedtls_gcm_init(&gcm);
+        ok = mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, aes_key, 256) == 0 &&
+             mbedtls_gcm_auth_decrypt(&gcm, len, blob, SEAL_IV_LEN,
+                                      (const uint8_t*)aad.c_str(), aad.length(),
+                                      tag, SEAL_TAG_LEN, ciphertext, ciphertext) == 0;
+        mbedtls_gcm_free(&gcm);
+        memset(aes_key, 0, sizeof(aes_key));
+        if (ok) {
+            ciphertext[len] = '\0';
+            plain = (const char*)ciphertext;
+        }
+    }
+    free(blob);
+    return ok;
+}
@@ -1,17 +1,93 @@
 #include "lamarzocco_client.h"
 #include "config.h"
+#include "json_allocator.h"
+#include "app_log.h"
 #include <time.h>
 
-static const char* BASE_URL = "lion.lamarzocco.io";
-static const char* CUSTOMER_APP_URL = "https://lion.lamarzocco.io/api/customer-app";
 static const unsigned long TOKEN_TIME_TO_REFRESH = 10 * 60;  // 10 minutes
+// Lifetime assumed when a token response has no expiresIn (s)
+static const unsigned long TOKEN_DEFAULT_LIFETIME = 60 * 60;
+// Below this much validity callers renew the token themselves (s)
+static const long TOKEN_MIN_VALIDITY = 60;
+// The refresh task re-checks the expiry at least this often, which also
+// catches the clock jumping when NTP syncs (ms)
+static const uint32_t TOKEN_REFRESH_POLL_MS = 60000;
+// ... and while a restored token waits for NTP to check its expiry (ms)
+static const uint32_t TOKEN_CLOCK_POLL_MS = 1000;
+// Failed background renewals are retried with doubling delays; a successful
+// one is never followed by another within the first delay either (ms)
+static const uint32_t TOKEN_REFRESH_RETRY_MS = 15000;
+static const uint32_t TOKEN_REFRESH_RETRY_MAX_MS = 5 * 60000;
+
+// NVS keys (Preferences namespace "config")
+static const char* PREF_TOKENS = "TOKENS";        // Sealed "expires_at\naccess\nrefresh"
+static const char* PREF_REGISTERED = "REG_INST";  // Installation id registered with the cloud
+
+static bool token_clock_synced() {
+    return time(nullptr) > 1600000000;
+}
+
+// Clock for token expiry: wall-clock time once NTP has synced, uptime before
+// that (a token stamped before the sync then just looks expired)
+static unsigned long token_clock_s() {
+    return token_clock_synced() ? (unsigned long)time(nullptr) : millis() / 1000;
+}
+
+// The cloud refused the installation key itself (not the credentials, and
+// not an outage or rate limit): only then is a fresh /auth/init worth doing
+static bool installation_rejected(int http_code, const String& response) {
+    if (http_code != 401 && http_code != 403) {
+        return false;
+    }
+    return response.indexOf("nstallation") >= 0;  // "Installation ..." / "installation ..."
+}
+
+// Start renewing TOKEN_TIME_TO_REFRESH before expiry, but not before three
+// quarters of a short-lived token's lifetime have passed
+static unsigned long token_refresh_at(unsigned long expires_at, unsigned long lifetime) {
+    unsigned long lead = lifetime / 4 < TOKEN_TIME_TO_REFRESH ? lifetime / 4 : TOKEN_TIME_TO_REFRESH;
+    return expires_at > lead ? expires_at - lead : 0;
+}
+
+// Holds one of the client's mutexes for the scope. They are taken in the
+// order _http_mutex, _auth_mutex, _token_mutex (any of them may be skipped).
+class HttpLock {
+public:
+    explicit HttpLock(SemaphoreHandle_t mutex) : _mutex(mutex) { xSemaphoreTakeRecursive(_mutex, portMAX_DELAY); }
+    ~HttpLock() { xSemaphoreGiveRecursive(_mutex); }
+private:
+    SemaphoreHandle_t _mutex;
+};
 
 LaMarzoccoClient::LaMarzoccoClient(Preferences& prefs) 
-    : _prefs(prefs), _initialized(false) {
-    _client.setInsecure();  // For now, accept self-signed certs
+    : _prefs(prefs), _initialized(false), _http_stats(), _reused_ms_total(0), _handshake_ms_total(0),
+      _refresh_task(nullptr), _token_stats(), _refresh_ms_total(0),
+      _tokens_restored(false), _expiry_unchecked(false), _registration_skipped(false) {
+    _access_token.expires_at = 0;
+    _access_token.refresh_at = 0;
+    _api.client.setInsecure();  // For now, accept self-signed certs
+    _api.http.setReuse(API_KEEPALIVE);
+    // Renewals are far apart: no second TLS session is held open in between
+    _auth.client.setInsecure();
+    _auth.http.setReuse(false);
+    _http_mutex = xSemaphoreCreateRecursiveMutex();
+    _auth_mutex = xSemaphoreCreateRecursiveMutex();
+    _token_mutex = xSemaphoreCreateRecursiveMutex();
+    portMUX_INITIALIZE(&_stats_lock);
 }
 
 LaMarzoccoClient::~LaMarzoccoClient() {
+    if (_refresh_task) {
+        HttpLock lock(_auth_mutex);  // Not in the middle of a renewal
+        vTaskDelete(_refresh_task);
+    }
+    _api.http.end();
+    _api.client.stop();
+    _auth.http.end();
+    _auth.client.stop();
+    vSemaphoreDelete(_http_mutex);
+    vSemaphoreDelete(_auth_mutex);
+    vSemaphoreDelete(_token_mutex);
 }
 
 bool LaMarzoccoClient::init(const String& username, const String& password, const String& serial_number) {
@@ -25,7 +101,25 @@ bool LaMarzoccoClient::init(const String& username, const String& password, cons
         return false;
     }
     
+    // Start signing request headers in the background
+    _header_pool.begin(_installation_key);
+    
     _initialized = true;
+    
+#if AUTH_PERSIST
+    _load_tokens();
+#endif
+    
+    // Idle until the first token, then renews it ahead of expiry
+    if (!_refresh_task) {
+        xTaskCreatePinnedToCore(_refresh_task_main,
+                                "Task_TokenRefresh",
+                                1024 * 16,  // TLS, as Task_Network
+                                this,
+                                1,          // Below the network and LVGL tasks
+                                &_refresh_task,
+                                1);
+    }
     return true;
 }
 
@@ -43,28 +137,39 @@ bool LaMarzoccoClient::register_client() {
         return false;
     }
     
+#if AUTH_PERSIST
+    // The cloud knows this installation key from an earlier boot
+    if (_prefs.isKey(PREF_REGISTERED) &&
+        _prefs.getString(PREF_REGISTERED, "") == _installation_key.installation_id) {
+        APP_LOGI(HTTP, "Installation already registered, skipping /auth/init");
+        _registration_skipped = true;
+        return true;
+    }
+#endif
+    
     String base_string = LaMarzoccoAuth::generate_base_string(_installation_key);
     String proof = LaMarzoccoAuth::generate_request_proof(base_string, _installation_key.secret);
     String public_key_b64 = LaMarzoccoAuth::base64_encode(_installation_key.public_key_der, _installation_key.public_key_len);
     
-    HTTPClient http;
-    http.begin(_client, String(CUSTOMER_APP_URL) + "/auth/init");
-    http.addHeader("Content-Type", "application/json");
-    http.addHeader("X-App-Installation-Id", _installation_key.installation_id);
-    http.addHeader("X-Request-Proof", proof);
-    
-    JsonDocument request;
+    JsonDocument request(&json_api_arena);
     request["pk"] = public_key_b64;
     
     String request_body;
     serializeJson(request, request_body);
     
-    int http_code = http.POST(request_body);
-    String response = http.getString();
-    http.end();
+    const RequestHeader headers[] = {
+        {"X-App-Installation-Id", _installation_key.installation_id},
+        {"X-Request-Proof", proof},
+    };
+    String response;
+    HttpLock lock(_http_mutex);
+    int http_code = _request(_api, "POST", "/auth/init", request_body, false, headers, 2, response);
     
     if (http_code == 200 || http_code == 201) {
         debugln("Registration successful");
+#if AUTH_PERSIST
+        _prefs.putString(PREF_REGISTERED, _installation_key.installation_id);
+#endif
         return true;
     } else {
         debug("Registration failed: ");
@@ -74,87 +179,58 @@ bool LaMarzoccoClient::register_client() {
     }
 }
 
+// Caller holds _auth_mutex (the renewal runs on the _auth connection)
 bool LaMarzoccoClient::_sign_in() {
-    JsonDocument request;
+    JsonDocument request(&json_api_arena);
     request["username"] = _username;
     request["password"] = _password;
     
     String request_body;
     serializeJson(request, request_body);
     
-    HTTPClient http;
-    http.begin(_client, String(CUSTOMER_APP_URL) + "/auth/signin");
-    http.addHeader("Content-Type", "application/json");
-    _add_auth_headers(http);
-    
-    int http_code = http.POST(request_body);
-    String response = http.getString();
-    http.end();
+    String response;
+    int http_code = _request(_auth, "POST", "/auth/signin", request_body, true, nullptr, 0, response);
     
     if (http_code == 200) {
-        JsonDocument response_doc;
+        JsonDocument response_doc(&json_api_arena);
         deserializeJson(response_doc, response);
-        
-        _access_token.access_token = response_doc["accessToken"].as<String>();
-        _access_token.refresh_token = response_doc["refreshToken"].as<String>();
-        
-        // Parse expires_at (assuming it's in the response, adjust as needed)
-        unsigned long expires_in = response_doc["expiresIn"].as<unsigned long>();
-        struct tm timeinfo;
-        if (getLocalTime(&timeinfo)) {
-            _access_token.expires_at = mktime(&timeinfo) + expires_in;
-        } else {
-            _access_token.expires_at = (millis() / 1000) + expires_in;
-        }
-        
+        _store_token(response_doc, false);
         debugln("Sign in successful");
         return true;
     } else {
         debug("Sign in failed: ");
         debugln(http_code);
         debugln(response);
+#if AUTH_PERSIST
+        // Installation unknown: register again on the next boot
+        if (installation_rejected(http_code, response) && _prefs.isKey(PREF_REGISTERED)) {
+            _prefs.remove(PREF_REGISTERED);
+        }
+#endif
         return false;
     }
 }
 
-bool LaMarzoccoClient::_refresh_token() {
-    if (_access_token.refresh_token.length() == 0) {
+// Caller holds _auth_mutex
+bool LaMarzoccoClient::_refresh_token(const String& refresh_token) {
+    if (refresh_token.length() == 0) {
         return _sign_in();
     }
     
-    JsonDocument request;
+    JsonDocument request(&json_api_arena);
     request["username"] = _username;
-    request["refreshToken"] = _access_token.refresh_token;
+    request["refreshToken"] = refresh_token;
     
     String request_body;
     serializeJson(request, request_body);
     
-    HTTPClient http;
-    http.begin(_client, String(CUSTOMER_APP_URL) + "/auth/refreshtoken");
-    http.addHeader("Content-Type", "application/json");
-    _add_auth_headers(http);
-    
-    int http_code = http.POST(request_body);
-    String response = http.getString();
-    http.end();
+    String response;
+    int http_code = _request(_auth, "POST", "/auth/refreshtoken", request_body, true, nullptr, 0, response);
     
     if (http_code == 200) {
-        JsonDocument response_doc;
+        JsonDocument response_doc(&json_api_arena);
         deserializeJson(response_doc, response);
-        
-        _access_token.access_token = response_doc["accessToken"].as<String>();
-        if (response_doc.containsKey("refreshToken")) {
-            _access_token.refresh_token = response_doc["refreshToken"].as<String>();
-        }
-        
-        unsigned long expires_in = response_doc["expiresIn"].as<unsigned long>();
-        struct tm timeinfo;
-        if (getLocalTime(&timeinfo)) {
-            _access_token.expires_at = mktime(&timeinfo) + expires_in;
-        } else {
-            _access_token.expires_at = (millis() / 1000) + expires_in;
-        }
-        
+        _store_token(response_doc, true);
         debugln("Token refresh successful");
         return true;
     } else {
@@ -164,74 +240,255 @@ bool LaMarzoccoClient::_refresh_token() {
     }
 }
 
+// Swap in the token from a sign-in / refresh response and count it
+void LaMarzoccoClient::_store_token(const JsonDocument& response, bool refreshed) {
+    unsigned long lifetime = response["expiresIn"].as<unsigned long>();
+    if (lifetime == 0) {
+        lifetime = TOKEN_DEFAULT_LIFETIME;  // Missing: don't treat the token as expired at once
+    }
+    
+    HttpLock lock(_token_mutex);
+    _access_token.access_token = response["accessToken"].as<String>();
+    _expiry_unchecked = false;
+    if (!refreshed || response["refreshToken"].is<const char*>()) {
+        _access_token.refresh_token = response["refreshToken"].as<String>();
+    }
+    _access_token.expires_at = token_clock_s() + lifetime;
+    _access_token.refresh_at = token_refresh_at(_access_token.expires_at, lifetime);
+    if (refreshed) {
+        _token_stats.refreshes++;
+    } else {
+        _token_stats.sign_ins++;
+    }
+}
+
 bool LaMarzoccoClient::get_access_token() {
     if (!_initialized) {
         return false;
     }
     
-    struct tm timeinfo;
-    unsigned long now = 0;
-    if (getLocalTime(&timeinfo)) {
-        now = mktime(&timeinfo);
+    bool usable;
+    bool due;
+    {
+        HttpLock lock(_token_mutex);
+        if (!_token_expiry_known()) {
+            return true;  // Restored before NTP: use it, the cloud rejects it if it has expired
+        }
+        usable = _access_token.access_token.length() > 0 && _token_seconds_left() > TOKEN_MIN_VALIDITY;
+        due = token_clock_s() >= _access_token.refresh_at;
+    }
+    // Inside the refresh window the task renews it; without the task, do it here
+    if (usable && (!due || _refresh_task)) {
+        return true;
+    }
+    return _renew_token(false);
+}
+
+String LaMarzoccoClient::get_access_token_string() {
+    HttpLock lock(_token_mutex);  // The refresh task may be replacing it
+    return _access_token.access_token;
+}
+
+TokenRefreshStats LaMarzoccoClient::get_token_stats() {
+    HttpLock lock(_token_mutex);
+    TokenRefreshStats stats = _token_stats;
+    stats.expires_in_s = _access_token.access_token.length() > 0 && _token_expiry_known() ? _token_seconds_left() : 0;
+    return stats;
+}
+
+// Seconds until the access token expires (negative once it has)
+long LaMarzoccoClient::_token_seconds_left() const {
+    return (long)(_access_token.expires_at - token_clock_s());
+}
+
+// A restored token's expiry is wall-clock time, which can only be compared
+// once NTP has synced. Caller holds _token_mutex.
+bool LaMarzoccoClient::_token_expiry_known() {
+    if (!_expiry_unchecked || !token_clock_synced()) {
+        return !_expiry_unchecked;
+    }
+    _expiry_unchecked = false;
+    APP_LOGI(HTTP, "🔑 Clock set, restored token valid for %ld s", _token_seconds_left());
+    return true;
+}
+
+// Refresh the token, or sign in when there is no refresh token or it has
+// expired. Only _auth_mutex is held during the requests: API calls on the
+// other connection and token readers are not held up by a background renewal.
+bool LaMarzoccoClient::_renew_token(bool background) {
+    HttpLock auth_lock(_auth_mutex);
+    String refresh_token;
+    {
+        HttpLock lock(_token_mutex);
+        // A caller that waited for a renewal in progress has its token now
+        if (!background && _access_token.access_token.length() > 0 &&
+            _token_seconds_left() > TOKEN_MIN_VALIDITY &&
+            (_refresh_task || token_clock_s() < _access_token.refresh_at)) {
+            return true;
+        }
+        if (_token_seconds_left() > 0) {
+            refresh_token = _access_token.refresh_token;
+        }
+    }
+    
+    unsigned long start_ms = millis();
+    bool ok = _refresh_token(refresh_token);  // Signs in without a refresh token
+    uint32_t elapsed_ms = millis() - start_ms;
+    
+    HttpLock lock(_token_mutex);
+    if (!ok) {
+        _token_stats.failures++;
+    }
+    // _store_token() counted the successes
+    uint32_t renewals = _token_stats.refreshes + _token_stats.sign_ins + _token_stats.failures;
+    if (!background) {
+        _token_stats.inline_renewals++;
+    }
+    _token_stats.refresh_ms_last = elapsed_ms;
+    if (elapsed_ms > _token_stats.refresh_ms_max) {
+        _token_stats.refresh_ms_max = elapsed_ms;
+    }
+    _refresh_ms_total += elapsed_ms;
+    _token_stats.refresh_ms_avg = renewals ? (uint32_t)(_refresh_ms_total / renewals) : 0;
+    
+#if AUTH_PERSIST
+    if (ok) {
+        _save_tokens();
+    }
+#endif
+    if (ok) {
+        APP_LOGI(HTTP, "🔑 Token renewed %s in %lu ms, valid for %ld s",
+                 background ? "in the background" : "inline", (unsigned long)elapsed_ms,
+                 _token_seconds_left());
     } else {
-        now = millis() / 1000;
+        APP_LOGE(HTTP, "🔑 Token renewal failed %s after %lu ms",
+                 background ? "in the background" : "inline", (unsigned long)elapsed_ms);
+    }
+    if (!background && _refresh_task) {
+        xTaskNotifyGive(_refresh_task);  // Reschedule for the new expiry
+    }
+    return ok;
+}
+
+#if AUTH_PERSIST
+// Tokens are bound to the installation and the account they were issued for
+String LaMarzoccoClient::_token_store_aad() const {
+    return _installation_key.installation_id + "\n" + _username;
+}
+
+// Restore the tokens of the previous boot, so it needs no sign-in
+void LaMarzoccoClient::_load_tokens() {
+    if (!_prefs.isKey(PREF_TOKENS)) {
+        return;
+    }
+    String plain;
+    if (!LaMarzoccoAuth::unseal(_installation_key, _token_store_aad(), _prefs.getString(PREF_TOKENS, ""), plain)) {
+        APP_LOGW(HTTP, "Stored tokens do not open (other installation or account), discarding");
+        _prefs.remove(PREF_TOKENS);
+        return;
+    }
+    int first = plain.indexOf('\n');
+    int second = first < 0 ? -1 : plain.indexOf('\n', first + 1);
+    if (second < 0) {
+        _prefs.remove(PREF_TOKENS);
+        return;
     }
     
-    if (!_access_token.isValid() || _access_token.expires_at < now + TOKEN_TIME_TO_REFRESH) {
-        if (_access_token.refresh_token.length() > 0 && _access_token.expires_at > now) {
-            return _refresh_token();
+    HttpLock lock(_token_mutex);
+    _access_token.expires_at = strtoul(plain.c_str(), nullptr, 10);
+    _access_token.refresh_at = token_refresh_at(_access_token.expires_at, TOKEN_DEFAULT_LIFETIME);
+    _access_token.access_token = plain.substring(first + 1, second);
+    _access_token.refresh_token = plain.substring(second + 1);
+    _tokens_restored = true;
+    // The expiry is wall-clock time: without NTP yet, it is checked on first use after the sync
+    _expiry_unchecked = !token_clock_synced();
+    if (_expiry_unchecked) {
+        APP_LOGI(HTTP, "🔑 Tokens restored, expiry checked once the clock is set");
+    } else {
+        APP_LOGI(HTTP, "🔑 Tokens restored, valid for %ld s", _token_seconds_left());
+    }
+}
+
+// Caller holds _token_mutex
+void LaMarzoccoClient::_save_tokens() {
+    String plain = String(_access_token.expires_at) + "\n" + _access_token.access_token + "\n" +
+                   _access_token.refresh_token;
+    String sealed = LaMarzoccoAuth::seal(_installation_key, _token_store_aad(), plain);
+    if (sealed.length() == 0 || _prefs.putString(PREF_TOKENS, sealed) == 0) {
+        APP_LOGW(HTTP, "Could not store tokens");
+    }
+}
+#endif
+
+// How long the refresh task can sleep before the token enters the refresh
+// window (0 = renew now)
+uint32_t LaMarzoccoClient::_refresh_wait_ms() {
+    HttpLock lock(_token_mutex);
+    if (_access_token.access_token.length() == 0) {
+        return TOKEN_REFRESH_POLL_MS;  // Nobody signed in yet
+    }
+    if (!_token_expiry_known()) {
+        return TOKEN_CLOCK_POLL_MS;
+    }
+    long until_window = (long)(_access_token.refresh_at - token_clock_s());
+    if (until_window <= 0) {
+        return 0;
+    }
+    return until_window * 1000UL < TOKEN_REFRESH_POLL_MS ? (uint32_t)until_window * 1000 : TOKEN_REFRESH_POLL_MS;
+}
+
+void LaMarzoccoClient::_refresh_task_main(void* arg) {
+    LaMarzoccoClient* client = static_cast<LaMarzoccoClient*>(arg);
+    uint32_t retry_ms = TOKEN_REFRESH_RETRY_MS;
+    while (1) {
+        uint32_t wait_ms = client->_refresh_wait_ms();
+        if (wait_ms > 0) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_ms));
+            continue;
+        }
+        if (client->_renew_token(true)) {
+            retry_ms = TOKEN_REFRESH_RETRY_MS;
+            // Whatever lifetime the server hands out, don't renew back to back
+            vTaskDelay(pdMS_TO_TICKS(TOKEN_REFRESH_RETRY_MS));
         } else {
-            return _sign_in();
+            // The token is still usable for a while; callers renew it
+            // themselves once it is about to expire
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(retry_ms));
+            retry_ms = retry_ms * 2 < TOKEN_REFRESH_RETRY_MAX_MS ? retry_ms * 2 : TOKEN_REFRESH_RETRY_MAX_MS;
         }
     }
-    
-    return true;
 }
 
 void LaMarzoccoClient::_add_auth_headers(HTTPClient& http) {
-    String installation_id, timestamp, nonce, signature;
-    LaMarzoccoAuth::generate_extra_request_headers(_installation_key, installation_id, timestamp, nonce, signature);
+    SignedHeaders headers;
+    _header_pool.take(headers);
     
-    http.addHeader("X-App-Installation-Id", installation_id);
-    http.addHeader("X-Timestamp", timestamp);
-    http.addHeader("X-Nonce", nonce);
-    http.addHeader("X-Request-Signature", signature);
+    http.addHeader("X-App-Installation-Id", headers.installation_id);
+    http.addHeader("X-Timestamp", headers.timestamp);
+    http.addHeader("X-Nonce", headers.nonce);
+    http.addHeader("X-Request-Signature", headers.signature);
 }
 
 bool LaMarzoccoClient::api_call(const String& method, const String& endpoint, JsonDocument* request_body, JsonDocument* response_body) {
-    if (!get_access_token()) {
+    if (method != "GET" && method != "POST" && method != "PUT" && method != "DELETE") {
         return false;
     }
     
-    String url = String(CUSTOMER_APP_URL) + endpoint;
-    
-    HTTPClient http;
-    http.begin(_client, url);
-    http.addHeader("Content-Type", "application/json");
-    _add_auth_headers(http);
-    http.addHeader("Authorization", "Bearer " + _access_token.access_token);
+    HttpLock lock(_http_mutex);
+    if (!get_access_token()) {
+        return false;
+    }
     
     String request_str;
     if (request_body) {
         serializeJson(*request_body, request_str);
     }
     
-    int http_code = 0;
-    if (method == "GET") {
-        http_code = http.GET();
-    } else if (method == "POST") {
-        http_code = http.POST(request_str);
-    } else if (method == "PUT") {
-        http_code = http.PUT(request_str);
-    } else if (method == "DELETE") {
-        http_code = http.sendRequest("DELETE", request_str);
-    } else {
-        http.end();
-        return false;
-    }
-    
-    String response_str = http.getString();
-    http.end();
+    const RequestHeader headers[] = {
+        {"Authorization", "Bearer " + get_access_token_string()},
+    };
+    String response_str;
+    int http_code = _request(_api, method.c_str(), endpoint, request_str, true, headers, 1, response_str);
     
     if (http_code >= 200 && http_code < 300) {
         if (response_body && response_str.length() > 0) {
@@ -246,3 +503,69 @@ bool LaMarzoccoClient::api_call(const String& method, const String& endpoint, Js
     }
 }
 
+// Caller holds the mutex of `conn`. The connection stays open after the
+// response if it is set to and the server allows it; a kept-alive connection
+// the server has meanwhile closed fails before any response arrives, and the
+// request is sent once more on a new connection.
+int LaMarzoccoClient::_request(HttpConnection& conn, const char* method, const String& endpoint, const String& body,
+                               bool signed_headers, const RequestHeader* headers, size_t header_count,
+                               String& response) {
+    String url = String(CUSTOMER_APP_URL) + endpoint;
+    int http_code = 0;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        unsigned long start_ms = millis();
+        bool reused = conn.client.connected();
+        
+        conn.http.begin(conn.client, url);
+        conn.http.addHeader("Content-Type", "application/json");
+        if (signed_headers) {
+            _add_auth_headers(conn.http);  // Fresh nonce per attempt
+        }
+        for (size_t i = 0; i < header_count; i++) {
+            conn.http.addHeader(headers[i].name, headers[i].value);
+        }
+        
+        http_code = conn.http.sendRequest(method, body);
+        response = http_code > 0 ? conn.http.getString() : String();
+        conn.http.end();  // Keeps the connection open if reuse is set and the server allows it
+        
+        uint32_t elapsed_ms = millis() - start_ms;
+        portENTER_CRITICAL(&_stats_lock);
+        _http_stats.requests++;
+        _http_stats.request_ms_last = elapsed_ms;
+        if (elapsed_ms > _http_stats.request_ms_max) {
+            _http_stats.request_ms_max = elapsed_ms;
+        }
+        if (reused) {
+            _http_stats.reused++;
+            _reused_ms_total += elapsed_ms;
+            _http_stats.reused_ms_avg = _reused_ms_total / _http_stats.reused;
+        } else if (http_code != HTTPC_ERROR_CONNECTION_REFUSED) {
+            _http_stats.handshakes++;
+            _handshake_ms_total += elapsed_ms;
+            _http_stats.handshake_ms_avg = _handshake_ms_total / _http_stats.handshakes;
+        }
+        portEXIT_CRITICAL(&_stats_lock);
+        APP_LOGD(HTTP, "%s %s: %d in %lu ms (%s)", method, endpoint.c_str(), http_code,
+                 (unsigned long)elapsed_ms, reused ? "kept alive" : "new connection");
+        
+        if (http_code > 0) {
+            break;
+        }
+        conn.client.stop();
+        // A read timeout means the server had the request; sending it again
+        // could repeat a command
+        bool give_up = !reused || http_code == HTTPC_ERROR_READ_TIMEOUT;
+        portENTER_CRITICAL(&_stats_lock);
+        if (give_up) {
+            _http_stats.failures++;
+        } else {
+            _http_stats.retries++;
+        }
+        portEXIT_CRITICAL(&_stats_lock);
+        if (give_up) {
+            break;
+        }
+    }
+    return http_code;
+}
@@ -1,320 +1,310 @@
 #include "lamarzocco_machine.h"
 #include "config.h"
-#include "boiler_display.h"
-#include "water_alarm.h"
-#include "brewing_display.h"
+#include "machine_events.h"
+#include "json_allocator.h"
+#include "app_log.h"
+#include "update_trace.h"
+#include "dashboard_extract.h"
+#include "dashboard_json.h"
+#include "dashboard_codes.h"
 #include <ArduinoJson.h>
 
 LaMarzoccoMachine* LaMarzoccoMachine::_instance = nullptr;
 
+// Parse with the engine config.h selects (the native bench runs both)
+static bool parse_dashboard(const char* message, size_t length,
+                            WidgetRegistry& registry, DashboardCommands& commands) {
+#if DASHBOARD_PARSER == DASHBOARD_PARSER_ARDUINOJSON
+    return dashboard_parse_json(message, length, registry, commands);
+#else
+    // Single pass over the body, no heap
+    if (!dashboard_extract(message, length, registry, commands)) {
+        APP_LOGE(MACHINE, "❌ Dashboard JSON is malformed");
+        return false;
+    }
+    return true;
+#endif
+}
+
 LaMarzoccoMachine::LaMarzoccoMachine(LaMarzoccoClient& client, LaMarzoccoWebSocket& websocket)
-    : _client(client), _websocket(websocket), _power_state(false), _steam_state(false) {
+    : _client(client), _websocket(websocket), _controls(), _control_version(0), _control_stats(),
+      _parse_stats(), _state(), _state_valid(false), _first_dashboard_ms(0) {
     _instance = this;
+    portMUX_INITIALIZE(&_control_lock);
+    
+    // Widget codes without a handler are skipped unread (and, with the
+    // ArduinoJson filter, not even copied into the document)
+#if DASHBOARD_LOG_ALL_WIDGETS
+    _handlers.register_all(_widgets);
+#else
+    _handlers.register_displayed(_widgets);
+#endif
     _websocket.set_message_callback(_websocket_message_handler);
 }
 
-void LaMarzoccoMachine::_websocket_message_handler(const String& message) {
+void LaMarzoccoMachine::_websocket_message_handler(const char* message, size_t length) {
     if (_instance) {
-        // Parse JSON message with large buffer for La Marzocco messages (can be 2-3KB)
-        JsonDocument doc;
+        // Identical snapshots (only uuid / connectionDate differ) are dropped
+        // before parsing
+        DashboardDiff& diff = _instance->_dashboard_diff;
+        if (!diff.update(message, length)) {
+            APP_LOGV(MACHINE, "Dashboard unchanged, skipping");
+            update_trace_end(false);
+            return;
+        }
         
-        Serial.println("\n========== WEBSOCKET MESSAGE RECEIVED ==========");
-        Serial.print("Message length: ");
-        Serial.print(message.length());
-        Serial.println(" bytes");
+        unsigned long handler_start_us = micros();
+        APP_LOGD(MACHINE, "Dashboard message, %u bytes", (unsigned)length);
         
-        DeserializationError error = deserializeJson(doc, message);
+        // Network task only, so one static copy is enough
+        static DashboardCommands commands;
+        WidgetRegistry& widgets = _instance->_widgets;
+        // The previous message's document is gone: start from an empty arena
+        json_dashboard_arena.reset();
+        json_dashboard_arena.reset_peak();
+        unsigned long parse_start_us = micros();
+        widgets.begin_frame();
+        bool parsed = parse_dashboard(message, length, widgets, commands);
+        DashboardParseStats& parse_stats = _instance->_parse_stats;
+        parse_stats.parse_us_last = micros() - parse_start_us;
+        parse_stats.json_peak_last = json_dashboard_arena.peak();
+        if (parse_stats.parse_us_last > parse_stats.parse_us_max) {
+            parse_stats.parse_us_max = parse_stats.parse_us_last;
+        }
+        if (parse_stats.json_peak_last > parse_stats.json_peak_max) {
+            parse_stats.json_peak_max = parse_stats.json_peak_last;
+        }
         
-        if (error) {
-            Serial.print("❌ JSON parse error: ");
-            Serial.println(error.c_str());
-            Serial.print("Error code: ");
-            Serial.println((int)error.code());
-            
-            if (error == DeserializationError::NoMemory) {
-                Serial.println("💡 JSON document is too large - increase buffer size");
-            }
+        if (!parsed) {
+            diff.invalidate();  // Don't skip the retransmission of this snapshot
+            update_trace_end(false);
             return;
         }
+        update_trace_mark(TRACE_JSON_PARSED);
         
-        Serial.println("✓ JSON parsed successfully");
-        
-        // Variables to store extracted data
-        const char* machine_status = nullptr;
-        const char* machine_mode = nullptr;
-        const char* coffee_boiler_status = nullptr;
-        int64_t coffee_ready_time = 0;
-        float coffee_target_temp = 0.0;
-        const char* steam_boiler_status = nullptr;
-        int64_t steam_ready_time = 0;
-        const char* steam_target_level = nullptr;
-        bool no_water_alarm = false;
-        bool is_brewing = false;
-        int64_t brewing_start_time = 0;
+        // Boot cost of auth: compare AUTH_PERSIST=0 / 1 builds
+        if (_instance->_first_dashboard_ms == 0) {
+            _instance->_first_dashboard_ms = millis();
+            APP_LOGI(MACHINE, "⏱ First dashboard %lu ms after boot (tokens %s, registration %s)",
+                     (unsigned long)_instance->_first_dashboard_ms,
+                     _instance->_client.tokens_restored() ? "restored" : "from sign-in",
+                     _instance->_client.registration_skipped() ? "skipped" : "sent");
+        }
         
-        // Parse widgets array to extract boiler and machine status
-        if (doc.containsKey("widgets")) {
-            JsonArray widgets = doc["widgets"].as<JsonArray>();
-            Serial.print("Widgets count: ");
-            Serial.println(widgets.size());
-            
-            for (JsonVariant widget : widgets) {
-                const char* code = widget["code"];
-                if (!code) continue;
-                
-                // Extract machine status
-                if (strcmp(code, "CMMachineStatus") == 0) {
-                    Serial.println("✓ Found CMMachineStatus widget");
-                    JsonObject output = widget["output"].as<JsonObject>();
-                    
-                    machine_status = output["status"];
-                    machine_mode = output["mode"];
-                    
-                    // Check if brewing
-                    if (machine_status && strcmp(machine_status, "Brewing") == 0) {
-                        is_brewing = true;
-                        // Extract brewingStartTime
-                        if (output.containsKey("brewingStartTime") && !output["brewingStartTime"].isNull()) {
-                            brewing_start_time = output["brewingStartTime"].as<long long>();
-                            Serial.print("☕ Brewing started at: ");
-                            Serial.println((long long)brewing_start_time);
-                        }
-                    } else {
-                        is_brewing = false;
-                        brewing_start_time = 0;
-                    }
-                    
-                    if (machine_status) {
-                        _instance->_power_state = (strcmp(machine_status, "PoweredOn") == 0);
-                        Serial.print("📊 Machine status: ");
-                        Serial.print(machine_status);
-                        if (machine_mode) {
-                            Serial.print(" (mode: ");
-                            Serial.print(machine_mode);
-                            Serial.print(")");
-                        }
-                        Serial.println();
-                    }
-                }
-                // Extract coffee boiler status and ready time
-                else if (strcmp(code, "CMCoffeeBoiler") == 0) {
-                    Serial.println("☕ Found CMCoffeeBoiler widget");
-                    JsonObject output = widget["output"].as<JsonObject>();
-                    
-                    coffee_boiler_status = output["status"];
-                    if (output.containsKey("readyStartTime") && !output["readyStartTime"].isNull()) {
-                        coffee_ready_time = output["readyStartTime"].as<long long>();
-                    }
-                    if (output.containsKey("targetTemperature")) {
-                        coffee_target_temp = output["targetTemperature"].as<float>();
-                    }
-                    
-                    Serial.print("  Status: ");
-                    Serial.print(coffee_boiler_status ? coffee_boiler_status : "null");
-                    Serial.print(", TargetTemp: ");
-                    Serial.print(coffee_target_temp);
-                    Serial.print("°C, ReadyStartTime: ");
-                    Serial.println((long long)coffee_ready_time);
-                }
-                // Extract steam boiler status and ready time
-                else if (strcmp(code, "CMSteamBoilerLevel") == 0) {
-                    Serial.println("♨️  Found CMSteamBoilerLevel widget");
-                    JsonObject output = widget["output"].as<JsonObject>();
-                    
-                    steam_boiler_status = output["status"];
-                    if (output.containsKey("readyStartTime") && !output["readyStartTime"].isNull()) {
-                        steam_ready_time = output["readyStartTime"].as<long long>();
-                    }
-                    if (output.containsKey("targetLevel")) {
-                        steam_target_level = output["targetLevel"];
-                    }
-                    
-                    // Update internal steam state based on status
-                    if (steam_boiler_status) {
-                        if (strcmp(steam_boiler_status, "Off") != 0 && strcmp(steam_boiler_status, "StandBy") != 0) {
-                            _instance->_steam_state = true;
-                        } else {
-                            _instance->_steam_state = false;
-                        }
-                    }
-                    
-                    Serial.print("  Status: ");
-                    Serial.print(steam_boiler_status ? steam_boiler_status : "null");
-                    Serial.print(", TargetLevel: ");
-                    Serial.print(steam_target_level ? steam_target_level : "null");
-                    Serial.print(", ReadyStartTime: ");
-                    Serial.println((long long)steam_ready_time);
-                }
-                // Check for NoWater alarm
-                else if (strcmp(code, "CMNoWater") == 0) {
-                    Serial.println("💧 Found CMNoWater widget");
-                    JsonObject output = widget["output"].as<JsonObject>();
-                    
-                    if (output.containsKey("allarm")) {
-                        no_water_alarm = output["allarm"].as<bool>();
-                        Serial.print("  NoWater alarm: ");
-                        Serial.println(no_water_alarm ? "TRUE ⚠️" : "false");
-                    }
-                }
-            }
+        // Widgets missing from this frame are cleared
+        widgets.end_frame();
+        if (APP_LOG_ENABLED(WIDGETS, APP_LOG_DEBUG)) {
+            widgets.print_changed();
         }
         
-        // Check if any boiler reports NoWater status
-        if (coffee_boiler_status && strcmp(coffee_boiler_status, "NoWater") == 0) {
-            Serial.println("⚠️  Coffee boiler reports NoWater!");
-            no_water_alarm = true;
+        // Turn the machine widgets into a typed snapshot; everything below works on enums
+        MachineState state;
+        const DashboardWidgets& handlers = _instance->_handlers;
+        machine_state_from_widgets(handlers.machine, handlers.coffee, handlers.steam,
+                                   handlers.steam_temperature, handlers.no_water, state);
+        const BoilerSnapshot& coffee = state.boilers[BOILER_COFFEE];
+        const BoilerSnapshot& steam = state.boilers[BOILER_STEAM];
+        
+        // Reported power / steam, reconciled with what the buttons show
+        if (state.machine != MACHINE_STATUS_UNKNOWN) {
+            _instance->_report_control(COMMAND_POWER, machine_status_is_on(state.machine));
         }
-        if (steam_boiler_status && strcmp(steam_boiler_status, "NoWater") == 0) {
-            Serial.println("⚠️  Steam boiler reports NoWater!");
-            no_water_alarm = true;
+        if (steam.status != BOILER_STATUS_UNKNOWN) {
+            _instance->_report_control(COMMAND_STEAM, steam.status != BOILER_STATUS_OFF &&
+                                                      steam.status != BOILER_STATUS_STANDBY);
         }
         
-        // Update water alarm state
-        water_alarm_set(no_water_alarm);
+        if (state.no_water) {
+            APP_LOGD(MACHINE, "⚠️  NoWater alarm");
+        }
         
-        // Update brewing display
-        brewing_display_update(is_brewing, brewing_start_time);
+        // Compare with the last snapshot the display was given
+        uint32_t changes = _instance->_state_valid
+                               ? machine_state_diff(_instance->_state, state)
+                               : MACHINE_CHANGED_ALL;
         
-        // Update boiler displays if we have machine status
-        // Boiler displays (labels) continue to update even during water alarm
-        // Only the arcs are hidden by water_alarm system
-        if (machine_status) {
-            Serial.println("\n🔄 Updating boiler displays...");
-            
-            // Format temperature and level strings
-            char coffee_temp_str[16] = "";
-            char steam_level_str[16] = "";
-            
-            if (coffee_target_temp > 0) {
-                snprintf(coffee_temp_str, sizeof(coffee_temp_str), "%.0f°C", coffee_target_temp);
+        // Cloud delay: how long after the machine's own timestamps the push arrived
+        if (_instance->_state_valid) {
+            if ((changes & MACHINE_CHANGED_BREWING) && state.brewing) {
+                update_trace_cloud(TRACE_SPAN_CLOUD_BREWING, state.brewing_start_time);
             }
-            
-            if (steam_target_level) {
-                // Convert "Level2" to "L2", "Level1" to "L1", etc.
-                if (strncmp(steam_target_level, "Level", 5) == 0) {
-                    snprintf(steam_level_str, sizeof(steam_level_str), "L%s", steam_target_level + 5);
-                } else {
-                    strncpy(steam_level_str, steam_target_level, sizeof(steam_level_str) - 1);
+            for (int b = 0; b < 2; b++) {
+                const BoilerSnapshot& before = _instance->_state.boilers[b];
+                if (before.status == BOILER_STATUS_HEATING_UP &&
+                    state.boilers[b].status == BOILER_STATUS_READY) {
+                    update_trace_cloud(TRACE_SPAN_CLOUD_READY, before.ready_start_time);
                 }
             }
+        }
+        
+        // Display updates are queued for Task_LVGL - the network task never touches LVGL.
+        // Only fields that changed are queued.
+        bool queued = true;
+        
+        if (changes & MACHINE_CHANGED_NO_WATER) {
+            queued &= machine_events_push_water_alarm(state.no_water);
+        }
+        
+        if (changes & MACHINE_CHANGED_BREWING) {
+            queued &= machine_events_push_brewing(state.brewing, state.brewing_start_time);
+        }
+        
+        // Boiler labels continue to update even during water alarm
+        // Only the arcs are hidden by water_alarm system
+        if (changes & MACHINE_CHANGED_COFFEE_TARGET) {
+            queued &= machine_events_push_boiler_target(BOILER_COFFEE, coffee.target);
+        }
+        if (changes & MACHINE_CHANGED_STEAM_TARGET) {
+            queued &= machine_events_push_boiler_target(BOILER_STEAM, steam.target);
+        }
+        
+        // Boiler arcs need the machine status: OFF/StandBy turns both off
+        if (state.machine != MACHINE_STATUS_UNKNOWN) {
+            bool machine_on = machine_status_is_on(state.machine);
+            bool machine_changed = (changes & MACHINE_CHANGED_STATUS) != 0;
+            bool coffee_changed = machine_changed || (changes & MACHINE_CHANGED_COFFEE);
+            bool steam_changed = machine_changed || (changes & MACHINE_CHANGED_STEAM);
             
-            // If machine is OFF or StandBy, use that for both boilers
-            if (strcmp(machine_status, "Off") == 0 || strcmp(machine_status, "StandBy") == 0) {
-                boiler_display_update(BOILER_COFFEE, machine_status, 
-                                     coffee_boiler_status ? coffee_boiler_status : "Off", 
-                                     coffee_ready_time,
-                                     coffee_temp_str[0] ? coffee_temp_str : nullptr);
-                boiler_display_update(BOILER_STEAM, machine_status, 
-                                     steam_boiler_status ? steam_boiler_status : "Off", 
-                                     steam_ready_time,
-                                     steam_level_str[0] ? steam_level_str : nullptr);
-            } else {
-                // Machine is ON, update each boiler independently
-                if (coffee_boiler_status) {
-                    boiler_display_update(BOILER_COFFEE, machine_status, 
-                                         coffee_boiler_status, coffee_ready_time,
-                                         coffee_temp_str[0] ? coffee_temp_str : nullptr);
-                }
-                
-                if (steam_boiler_status) {
-                    boiler_display_update(BOILER_STEAM, machine_status, 
-                                         steam_boiler_status, steam_ready_time,
-                                         steam_level_str[0] ? steam_level_str : nullptr);
-                }
+            // While on, a boiler without a status is left as it is
+            if (coffee_changed && (!machine_on || coffee.status != BOILER_STATUS_UNKNOWN)) {
+                queued &= machine_events_push_boiler(BOILER_COFFEE, state.machine,
+                                                     coffee.status, coffee.ready_start_time);
+            }
+            if (steam_changed && (!machine_on || steam.status != BOILER_STATUS_UNKNOWN)) {
+                queued &= machine_events_push_boiler(BOILER_STEAM, state.machine,
+                                                     steam.status, steam.ready_start_time);
             }
         } else {
-            Serial.println("⚠ No machine status found, skipping boiler updates");
+            APP_LOGW(MACHINE, "⚠ No machine status found, skipping boiler updates");
         }
         
-        // Check for command responses
-        if (doc.containsKey("commands")) {
-            JsonArray commands = doc["commands"].as<JsonArray>();
-            if (commands.size() > 0) {
-                Serial.println("\n📋 Command responses:");
-                for (JsonVariant cmd : commands) {
-                    const char* id = cmd["id"];
-                    const char* status = cmd["status"];
-                    if (id && status) {
-                        Serial.print("  ✓ Command ");
-                        Serial.print(id);
-                        Serial.print(": ");
-                        Serial.println(status);
-                    }
-                }
+        if (changes) {
+            APP_LOGI(MACHINE, "🔄 Changed fields: 0x%02x", (unsigned)changes);
+        }
+        
+        // Display events (if any) carry the trace on to Task_LVGL
+        update_trace_end(changes != 0);
+        
+        if (queued) {
+            _instance->_state = state;
+            _instance->_state_valid = true;
+        } else {
+            // Event ring was full: resend everything with the next message
+            _instance->_state_valid = false;
+            diff.invalidate();
+        }
+        
+        // Command results: complete the commands we sent
+        for (size_t i = 0; i < commands.count; i++) {
+            const DashboardCommand& cmd = commands.items[i];
+            if (cmd.id[0] && cmd.status[0]) {
+                APP_LOGD(MACHINE, "📋 Command %s: %s", cmd.id, cmd.status);
             }
         }
+        _instance->_commands.update(commands);
         
-        Serial.println("===============================================\n");
+        parse_stats.handler_us_last = micros() - handler_start_us;
+        if (parse_stats.handler_us_last > parse_stats.handler_us_max) {
+            parse_stats.handler_us_max = parse_stats.handler_us_last;
+        }
     }
 }
 
-bool LaMarzoccoMachine::set_power(bool enabled) {
+bool LaMarzoccoMachine::set_power(bool enabled, CommandCallback callback, void* context) {
+    uint32_t requested_ms = millis();
     String serial = _client.get_serial_number();
     if (serial.length() == 0) {
-        debugln("Serial number not set");
+        APP_LOGE(MACHINE, "Serial number not set");
+        _track_command(COMMAND_POWER, enabled, nullptr, requested_ms, callback, context);
         return false;
     }
     
-    JsonDocument request;
+    JsonDocument request(&json_api_arena);
     request["mode"] = enabled ? "BrewingMode" : "StandBy";
     
-    JsonDocument response;
+    JsonDocument response(&json_api_arena);
     bool success = _client.api_call("POST", 
                                      "/things/" + serial + "/command/CoffeeMachineChangeMode",
                                      &request, &response);
     
     if (success) {
-        _power_state = enabled;
-        debug("Power set to: ");
-        debugln(enabled ? "ON" : "OFF");
+        APP_LOGI(MACHINE, "Power set to: %s", enabled ? "ON" : "OFF");
     } else {
-        debugln("Failed to set power");
+        APP_LOGW(MACHINE, "Failed to set power");
     }
+    _track_command(COMMAND_POWER, enabled, success ? &response : nullptr,
+                   requested_ms, callback, context);
     
     return success;
 }
 
-bool LaMarzoccoMachine::toggle_power() {
-    return set_power(!_power_state);
+bool LaMarzoccoMachine::toggle_power(CommandCallback callback, void* context) {
+    return set_power(!get_power_state(), callback, context);
 }
 
-bool LaMarzoccoMachine::set_steam(bool enabled) {
+bool LaMarzoccoMachine::set_steam(bool enabled, CommandCallback callback, void* context) {
+    uint32_t requested_ms = millis();
     String serial = _client.get_serial_number();
     if (serial.length() == 0) {
-        debugln("Serial number not set");
+        APP_LOGE(MACHINE, "Serial number not set");
+        _track_command(COMMAND_STEAM, enabled, nullptr, requested_ms, callback, context);
         return false;
     }
     
-    JsonDocument request;
+    JsonDocument request(&json_api_arena);
     request["boilerIndex"] = 1;  // Steam boiler index
     request["enabled"] = enabled;
     
-    JsonDocument response;
+    JsonDocument response(&json_api_arena);
     bool success = _client.api_call("POST", 
                                      "/things/" + serial + "/command/CoffeeMachineSettingSteamBoilerEnabled",
                                      &request, &response);
     
     if (success) {
-        _steam_state = enabled;
-        debug("Steam boiler set to: ");
-        debugln(enabled ? "ON" : "OFF");
+        APP_LOGI(MACHINE, "Steam boiler set to: %s", enabled ? "ON" : "OFF");
     } else {
-        debugln("Failed to set steam boiler");
+        APP_LOGW(MACHINE, "Failed to set steam boiler");
     }
+    _track_command(COMMAND_STEAM, enabled, success ? &response : nullptr,
+                   requested_ms, callback, context);
     
     return success;
 }
 
-bool LaMarzoccoMachine::toggle_steam() {
-    Serial.println("===========================================");
-    Serial.println("STEAM BUTTON PRESSED - Toggling Steam Boiler");
-    Serial.print("Current steam state: ");
-    Serial.println(_steam_state ? "ON" : "OFF");
-    Serial.print("Target steam state: ");
-    Serial.println(_steam_state ? "OFF" : "ON");
-    Serial.println("===========================================");
+bool LaMarzoccoMachine::toggle_steam(CommandCallback callback, void* context) {
+    bool steam_on = get_steam_state();
+    APP_LOGI(MACHINE, "Steam button pressed - %s -> %s",
+             steam_on ? "ON" : "OFF", steam_on ? "OFF" : "ON");
     
-    return set_steam(!_steam_state);
+    return set_steam(!steam_on, callback, context);
+}
+
+void LaMarzoccoMachine::_track_command(CommandKind kind, bool value, JsonDocument* response,
+                                       uint32_t requested_ms, CommandCallback callback, void* context) {
+    CommandResult result;
+    result.kind = kind;
+    result.value = value;
+    result.latency_ms = millis() - requested_ms;
+    if (!response) {
+        result.outcome = COMMAND_FAILED;
+        if (callback) {
+            callback(result, context);
+        }
+        return;
+    }
+    
+    // {"id": "...", "status": "Pending", ...}; accept a one-element array too
+    JsonVariantConst command = response->is<JsonArrayConst>() ? (*response)[0] : response->as<JsonVariantConst>();
+    const char* id = command["id"];
+    if (id && id[0]) {
+        _commands.add(id, kind, value, requested_ms, callback, context);
+        return;
+    }
+    APP_LOGW(MACHINE, "Command response has no id, result will not be confirmed");
+    result.outcome = COMMAND_UNTRACKED;
+    if (callback) {
+        callback(result, context);
+    }
 }
 
 bool LaMarzoccoMachine::connect_websocket() {
@@ -324,7 +314,7 @@ bool LaMarzoccoMachine::connect_websocket() {
     
     String serial = _client.get_serial_number();
     if (serial.length() == 0) {
-        debugln("Serial number not set");
+        APP_LOGE(MACHINE, "Serial number not set");
         return false;
     }
     
@@ -340,20 +330,124 @@ void LaMarzoccoMachine::disconnect_websocket() {
 }
 
 void LaMarzoccoMachine::loop() {
-    // Call websocket loop regularly - this is critical for connection
+    // Call websocket loop regularly - this is critical for connection.
+    // Reconnects (with backoff and a fresh token) are handled inside it.
     _websocket.loop();
+    
+    // Commands the dashboard never answered
+    _commands.expire();
+    _expire_controls();
+}
 
-    // Auto-reconnect logic: If disconnected, try to reconnect periodically
-    // This ensures we get a fresh access token instead of reusing an expired one
-    static unsigned long last_reconnect_attempt = 0;
-    const unsigned long RECONNECT_INTERVAL_MS = 30000;  // Try reconnect every 30 seconds
+void LaMarzoccoMachine::request_control(CommandKind kind, bool on) {
+    portENTER_CRITICAL(&_control_lock);
+    ControlState& control = _controls[kind];
+    control.desired = on;
+    control.pending = true;
+    control.requested_ms = millis();
+    _control_stats.requested++;
+    _control_version++;
+    portEXIT_CRITICAL(&_control_lock);
+    APP_LOGD(MACHINE, "%s shown as %s, pending", command_kind_name(kind), on ? "ON" : "OFF");
+}
+
+void LaMarzoccoMachine::control_result(const CommandResult& result) {
+    bool rolled_back = false;
+    portENTER_CRITICAL(&_control_lock);
+    ControlState& control = _controls[result.kind];
+    // Only the request this command was sent for; a newer one has its own
+    if (control.pending && control.desired == result.value &&
+        (result.outcome == COMMAND_FAILED || result.outcome == COMMAND_TIMED_OUT)) {
+        control.pending = false;
+        control.desired = control.reported;
+        _control_stats.rolled_back++;
+        _control_version++;
+        rolled_back = true;
+    }
+    bool reported = control.reported;
+    portEXIT_CRITICAL(&_control_lock);
+    // Confirmed / untracked: the view stays pending until a dashboard reports the state
+    if (rolled_back) {
+        APP_LOGW(MACHINE, "%s command %s, back to %s", command_kind_name(result.kind),
+                 command_outcome_name(result.outcome), reported ? "ON" : "OFF");
+    }
+}
+
+ControlView LaMarzoccoMachine::get_control(CommandKind kind) {
+    portENTER_CRITICAL(&_control_lock);
+    const ControlState& control = _controls[kind];
+    ControlView view;
+    view.on = control.desired;
+    view.pending = control.pending;
+    portEXIT_CRITICAL(&_control_lock);
+    return view;
+}
+
+uint32_t LaMarzoccoMachine::get_control_version() {
+    portENTER_CRITICAL(&_control_lock);
+    uint32_t version = _control_version;
+    portEXIT_CRITICAL(&_control_lock);
+    return version;
+}
 
-    if (!is_websocket_connected()) {
-        unsigned long now = millis();
-        if (now - last_reconnect_attempt >= RECONNECT_INTERVAL_MS) {
-            last_reconnect_attempt = now;
-            Serial.println("[AUTO-RECONNECT] WebSocket disconnected, attempting reconnect with fresh token...");
-            connect_websocket();  // This will refresh the access token and reconnect
+ControlStats LaMarzoccoMachine::get_control_stats() {
+    portENTER_CRITICAL(&_control_lock);
+    ControlStats stats = _control_stats;
+    portEXIT_CRITICAL(&_control_lock);
+    return stats;
+}
+
+void LaMarzoccoMachine::_report_control(CommandKind kind, bool on) {
+    uint32_t reconcile_ms = 0;
+    bool reconciled = false;
+    portENTER_CRITICAL(&_control_lock);
+    ControlState& control = _controls[kind];
+    bool changed = control.reported != on;
+    control.reported = on;
+    if (control.pending) {
+        // Until then an older state may still be reported: the machine has
+        // not acted on the command yet
+        if (control.desired == on) {
+            control.pending = false;
+            reconcile_ms = millis() - control.requested_ms;
+            _control_stats.reconciled++;
+            _control_stats.reconcile_ms_last = reconcile_ms;
+            if (reconcile_ms > _control_stats.reconcile_ms_max) {
+                _control_stats.reconcile_ms_max = reconcile_ms;
+            }
+            _control_version++;
+            reconciled = true;
+        }
+    } else if (changed || control.desired != on) {
+        control.desired = on;
+        _control_version++;
+    }
+    portEXIT_CRITICAL(&_control_lock);
+    if (reconciled) {
+        APP_LOGI(MACHINE, "%s %s reported %u ms after the request", command_kind_name(kind),
+                 on ? "ON" : "OFF", reconcile_ms);
+    }
+}
+
+void LaMarzoccoMachine::_expire_controls() {
+    uint32_t now = millis();
+    for (int k = 0; k < COMMAND_KIND_COUNT; k++) {
+        bool expired = false;
+        bool reported = false;
+        portENTER_CRITICAL(&_control_lock);
+        ControlState& control = _controls[k];
+        if (control.pending && now - control.requested_ms >= CONTROL_RECONCILE_TIMEOUT_MS) {
+            control.pending = false;
+            control.desired = control.reported;
+            _control_stats.rolled_back++;
+            _control_version++;
+            expired = true;
+            reported = control.reported;
+        }
+        portEXIT_CRITICAL(&_control_lock);
+        if (expired) {
+            APP_LOGW(MACHINE, "%s never reported as requested, back to %s",
+                     command_kind_name((CommandKind)k), reported ? "ON" : "OFF");
         }
     }
 }
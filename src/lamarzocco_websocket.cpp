@@ -1,18 +1,25 @@
 #include "lamarzocco_websocket.h"
 #include "config.h"
+#include "app_log.h"
+#include "update_trace.h"
 #include <ArduinoJson.h>
 #include <esp_random.h>
 
-static const char* WS_BASE_URL = "lion.lamarzocco.io";  // Same base URL for both REST API and WebSocket
-
 LaMarzoccoWebSocket* LaMarzoccoWebSocket::_instance = nullptr;
 
 LaMarzoccoWebSocket::LaMarzoccoWebSocket(LaMarzoccoClient& client) 
-    : _client(client), _connected(false), _message_callback(nullptr) {
+    : _client(client), _message_callback(nullptr), _metrics(),
+      _state(WS_STATE_IDLE), _state_since_ms(0), _next_attempt_ms(0), _outage_start_ms(0), _failures(0),
+      _step(WS_STEP_TOKEN), _replaying(false),
+      _last_rx_ms(0), _last_tx_ms(0), _hb_send_ms(0), _hb_recv_ms(0),
+      _stale_timeout_ms(STOMP_STALE_LINK_TIMEOUT_MS),
+      _assembler(STOMP_ASSEMBLER_CAPACITY), _fragment_is_text(false) {
     _instance = this;
     _ws.onEvent(_ws_event_handler);
-    _ws.setReconnectInterval(10000);  // 10 second auto-reconnect interval
-    // Don't call beginSSL here - wait until connect() is called
+    // The library only retries on its own while an attempt is in flight:
+    // loop() does not pump it during backoff, the controller decides when to retry
+    _ws.setReconnectInterval(5000);
+    // Don't call beginSSL here - wait until the first attempt
 }
 
 LaMarzoccoWebSocket::~LaMarzoccoWebSocket() {
@@ -72,76 +79,222 @@ String LaMarzoccoWebSocket::_encode_stomp_message(const String& command, const S
     return message;
 }
 
-bool LaMarzoccoWebSocket::_decode_stomp_message(const String& message, String& command, String& headers, String& body) {
-    // STOMP frame format: COMMAND\nHEADERS\n\nBODY\x00
-    // Example:
-    // MESSAGE\n
-    // destination:/ws/...\n
-    // content-type:application/json\n
-    // \n
-    // {"json":"data"}\x00
+// Copy bytes for a log line with control characters made visible
+static void escape_bytes(const char* data, size_t length, char* out, size_t out_size) {
+    size_t used = 0;
+    for (size_t i = 0; i < length && used + 5 < out_size; i++) {
+        unsigned char c = (unsigned char)data[i];
+        if (c >= 32 && c < 127) {
+            out[used++] = (char)c;
+        } else if (c == '\n') {
+            out[used++] = '\\';
+            out[used++] = 'n';
+        } else if (c == '\r') {
+            out[used++] = '\\';
+            out[used++] = 'r';
+        } else if (c == '\0') {
+            out[used++] = '\\';
+            out[used++] = '0';
+        } else {
+            used += snprintf(out + used, out_size - used, "[%u]", c);
+        }
+    }
+    out[used] = '\0';
+}
+
+bool LaMarzoccoWebSocket::_send_text(String& message) {
+    if (_replaying) {
+        return true;  // Nobody to send to - pretend the server got it
+    }
+    bool sent = _ws.sendTXT(message);
+    if (sent) {
+        _last_tx_ms = millis();
+    }
+    return sent;
+}
+
+void LaMarzoccoWebSocket::_negotiate_heartbeat(const StompFrame& connected) {
+    // We offered cx,cy in CONNECT, the server answers sx,sy in CONNECTED.
+    // We send every max(cx, sy) and expect to hear from the server every
+    // max(sx, cy); a zero on either side disables that direction.
+    uint32_t sx = 0;
+    uint32_t sy = 0;
+    StompSpan value;
+    if (connected.header("heart-beat", value)) {
+        stomp_parse_heartbeat(value, sx, sy);
+    }
     
-    debug("Decoding message, length: ");
-    debugln(message.length());
+    const uint32_t cx = STOMP_HEARTBEAT_SEND_MS;
+    const uint32_t cy = STOMP_HEARTBEAT_RECV_MS;
+    _hb_send_ms = (cx > 0 && sy > 0) ? (cx > sy ? cx : sy) : 0;
+    _hb_recv_ms = (cy > 0 && sx > 0) ? (cy > sx ? cy : sx) : 0;
     
-    // Find the double newline that separates headers from body
-    int header_end = message.indexOf("\n\n");
-    if (header_end < 0) {
-        debugln("❌ No header separator (\\n\\n) found");
-        return false;
+    // Allow one missed server beat before declaring the link dead, but never
+    // wait longer than the configured bound
+    _stale_timeout_ms = STOMP_STALE_LINK_TIMEOUT_MS;
+    if (_hb_recv_ms > 0 && 2 * _hb_recv_ms < _stale_timeout_ms) {
+        _stale_timeout_ms = 2 * _hb_recv_ms;
     }
     
-    debug("Header end position: ");
-    debugln(header_end);
-    
-    // Find the first newline (end of command)
-    int command_end = message.indexOf("\n");
-    if (command_end < 0 || command_end > header_end) {
-        debugln("❌ No command separator found");
-        return false;
+    APP_LOGD(WS, "Heart-beat negotiated - send: %u ms, recv: %u ms, stale after: %u ms",
+             (unsigned)_hb_send_ms, (unsigned)_hb_recv_ms, (unsigned)_stale_timeout_ms);
+}
+
+void LaMarzoccoWebSocket::_check_heartbeat() {
+    if (_state != WS_STATE_SUBSCRIBED) {
+        return;
     }
     
-    // Extract command
-    command = message.substring(0, command_end);
-    command.trim();
-    debug("Command: ");
-    debugln(command);
+    unsigned long now = millis();
     
-    // Extract headers (between first \n and \n\n)
-    if (command_end + 1 < header_end) {
-        headers = message.substring(command_end + 1, header_end);
-    } else {
-        headers = "";
+    // Outgoing heart-beat: a single EOL when nothing else was sent in time
+    if (_hb_send_ms > 0 && now - _last_tx_ms >= _hb_send_ms) {
+        String beat = "\n";
+        if (_send_text(beat)) {
+            _metrics.heartbeats_sent++;
+        }
     }
     
-    // Extract body (after \n\n until \x00 or end of string)
-    int body_start = header_end + 2;  // Skip the \n\n
-    debug("Body starts at position: ");
-    debugln(body_start);
+    // Dead-link detection: a half-open TCP session never delivers a disconnect
+    // event, so drop the link ourselves and let the reconnect logic take over
+    if (now - _last_rx_ms > _stale_timeout_ms) {
+        APP_LOGW(WS, "No inbound frame for %lu ms - link is stale, forcing reconnect",
+                 now - _last_rx_ms);
+        _metrics.stale_link_reconnects++;
+        _enter_backoff(WS_REASON_STALE_LINK);
+    }
+}
+
+size_t LaMarzoccoWebSocket::_process_stream(const char* data, size_t length, bool at_message_end) {
+    // Dispatch every complete frame in the buffer, return the bytes used
+    size_t offset = 0;
+    while (offset < length) {
+        StompFrame frame;
+        size_t consumed = 0;
+        uint32_t start_us = micros();
+        StompParseResult result = stomp_parse(data + offset, length - offset, at_message_end, frame, consumed);
+        uint32_t elapsed_us = micros() - start_us;
+        
+        if (result == STOMP_PARSE_INCOMPLETE) {
+            break;
+        }
+        
+        if (result == STOMP_PARSE_FRAME) {
+            _metrics.frames_decoded++;
+            _metrics.decode_us_last = elapsed_us;
+            if (elapsed_us > _metrics.decode_us_max) {
+                _metrics.decode_us_max = elapsed_us;
+            }
+            if (frame.length_mismatch) {
+                _metrics.length_mismatches++;
+                APP_LOGW(WS, "⚠ content-length does not match frame terminator");
+            }
+            _handle_stomp_frame(frame);
+        } else if (result == STOMP_PARSE_HEARTBEAT) {
+            _metrics.heartbeats_received++;
+        } else {
+            // Not a valid STOMP message
+            _metrics.decode_failures++;
+            APP_LOGW(WS, "✗ Failed to decode as STOMP message");
+            if (APP_LOG_ENABLED(WS, APP_LOG_DEBUG)) {
+                char raw[APP_LOG_LINE_LEN];
+                escape_bytes(data + offset, consumed, raw, sizeof(raw));
+                APP_LOGD(WS, "Raw bytes: %s", raw);
+            }
+        }
+        
+        offset += consumed;
+    }
+    return offset;
+}
+
+void LaMarzoccoWebSocket::_append_to_assembler(const uint8_t* data, size_t length, bool at_message_end) {
+    if (!_assembler.append(data, length)) {
+        _metrics.assembler_overflows++;
+        APP_LOGW(WS, "STOMP frame exceeds reassembly buffer - dropped");
+        return;
+    }
     
-    // Find null terminator
-    int body_end = message.indexOf('\x00', body_start);
-    if (body_end < 0) {
-        // No null terminator found, use end of string
-        body_end = message.length();
-        debug("No null terminator, using message length: ");
-        debugln(body_end);
-    } else {
-        debug("Null terminator at position: ");
-        debugln(body_end);
+    // Spans handed to the message callback point into the assembler buffer
+    uint32_t frames_before = _metrics.frames_decoded;
+    size_t used = _process_stream(_assembler.data(), _assembler.size(), at_message_end);
+    _metrics.frames_reassembled += _metrics.frames_decoded - frames_before;
+    _assembler.consume(used);
+}
+
+void LaMarzoccoWebSocket::_handle_stomp_frame(const StompFrame& frame) {
+    APP_LOGD(WS, "✓ Decoded STOMP - command: %.*s", (int)frame.command.length, frame.command.data);
+    for (size_t i = 0; i < frame.header_count; i++) {
+        APP_LOGV(WS, "  %.*s:%.*s",
+                 (int)frame.headers[i].name.length, frame.headers[i].name.data,
+                 (int)frame.headers[i].value.length, frame.headers[i].value.data);
     }
     
-    // Extract body
-    if (body_end > body_start) {
-        body = message.substring(body_start, body_end);
-        debug("Body extracted, length: ");
-        debugln(body.length());
+    if (frame.command.equals("CONNECTED")) {
+        APP_LOGD(WS, "STOMP CONNECTED - server accepted");
+        _negotiate_heartbeat(frame);
+        
+        // Generate subscription ID (pre-allocate to avoid fragmentation)
+        _subscription_id = LaMarzoccoAuth::generate_uuid();
+        if (_subscription_id.length() == 0) {
+            APP_LOGE(WS, "Failed to generate subscription ID!");
+            _enter_backoff(WS_REASON_TRANSPORT_ERROR);
+            return;
+        }
+        
+        // Subscribe to dashboard immediately - match Python format exactly
+        // Build headers carefully to minimize memory allocations
+        String subscribe_headers;
+        subscribe_headers.reserve(256);  // Pre-allocate
+        subscribe_headers = "destination:/ws/sn/";
+        subscribe_headers += _serial_number;
+        subscribe_headers += "/dashboard\n";
+        subscribe_headers += "ack:auto\n";
+        subscribe_headers += "id:";
+        subscribe_headers += _subscription_id;
+        subscribe_headers += "\n";
+        subscribe_headers += "content-length:0\n";  // No space after colon
+        
+        String subscribe_msg = _encode_stomp_message("SUBSCRIBE", subscribe_headers);
+        
+        if (APP_LOG_ENABLED(WS, APP_LOG_VERBOSE)) {
+            char raw[APP_LOG_LINE_LEN];
+            escape_bytes(subscribe_msg.c_str(), subscribe_msg.length(), raw, sizeof(raw));
+            APP_LOGV(WS, "SUBSCRIBE: %s", raw);
+        }
+        if (!_send_text(subscribe_msg)) {
+            _enter_backoff(WS_REASON_TRANSPORT_ERROR);
+            return;
+        }
+        
+        _set_state(WS_STATE_SUBSCRIBED);
+        _failures = 0;
+        _metrics.connect_successes++;
+        _metrics.reconnect_ms_last = millis() - _outage_start_ms;
+        if (_metrics.reconnect_ms_last > _metrics.reconnect_ms_max) {
+            _metrics.reconnect_ms_max = _metrics.reconnect_ms_last;
+        }
+        APP_LOGI(WS, "Subscribed to /ws/sn/%s/dashboard after %u ms (attempt %u)",
+                 _serial_number.c_str(), (unsigned)_metrics.reconnect_ms_last,
+                 (unsigned)_metrics.connect_attempts);
+        APP_LOGD(WS, "Subscription ID: %s", _subscription_id.c_str());
+    } else if (frame.command.equals("MESSAGE")) {
+        // Received a message from the server - hand the JSON body span to the callback
+        APP_LOGV(WS, "MESSAGE frame, body %u bytes", (unsigned)frame.body.length);
+        update_trace_mark(TRACE_STOMP_DECODED);
+        if (_message_callback) {
+            _message_callback(frame.body.data, frame.body.length);
+        } else {
+            APP_LOGW(WS, "⚠ No message callback registered!");
+        }
+    } else if (frame.command.equals("ERROR")) {
+        APP_LOGE(WS, "✗ STOMP ERROR - server rejected request: %.*s",
+                 (int)frame.body.length, frame.body.data);
+        // The server closes the connection after an ERROR frame - start the backoff now
+        _enter_backoff(WS_REASON_STOMP_ERROR);
     } else {
-        body = "";
-        debugln("⚠ Body is empty (body_end <= body_start)");
+        APP_LOGW(WS, "? Unknown STOMP command: %.*s", (int)frame.command.length, frame.command.data);
     }
-    
-    return true;
 }
 
 void LaMarzoccoWebSocket::_handle_websocket_event(WStype_t type, uint8_t* payload, size_t length) {
@@ -150,19 +303,26 @@ void LaMarzoccoWebSocket::_handle_websocket_event(WStype_t type, uint8_t* payloa
         return;  // This object is no longer the active instance, ignore event
     }
     
+    if (!_replaying) {
+        stomp_capture_record((uint8_t)type, payload, length);
+    }
+    
+    // Any inbound traffic proves the link is alive
+    if (type == WStype_TEXT || type == WStype_BIN || type == WStype_PING ||
+        type == WStype_PONG || type == WStype_CONNECTED ||
+        type == WStype_FRAGMENT_TEXT_START || type == WStype_FRAGMENT_BIN_START ||
+        type == WStype_FRAGMENT || type == WStype_FRAGMENT_FIN) {
+        _last_rx_ms = millis();
+    }
+    
     switch (type) {
         case WStype_DISCONNECTED:
             {
-                // Reduce logging noise - just a simple message
-                debug("⚠️  WebSocket disconnected");
-                if (payload && length > 0) {
-                    debug(" - ");
-                    debugln((char*)payload);
-                } else {
-                    debugln(" (auto-reconnect in 10s)");
-                }
-                _connected = false;
-                _subscription_id = "";  // Clear subscription on disconnect
+                bool has_reason = payload && length > 0;
+                APP_LOGD(WS, "⚠️  WebSocket disconnected%s%s", has_reason ? " - " : "",
+                         has_reason ? (const char*)payload : "");
+                // Also clears the subscription and any partial frames
+                _enter_backoff(WS_REASON_DISCONNECTED);
             }
             break;
             
@@ -170,304 +330,289 @@ void LaMarzoccoWebSocket::_handle_websocket_event(WStype_t type, uint8_t* payloa
             {
                 // Additional safety check: ensure we're still the active instance
                 if (_instance != this) {
-                    debugln("WARNING: WebSocket connected but instance changed, ignoring");
+                    APP_LOGW(WS, "WebSocket connected but instance changed, ignoring");
                     return;
                 }
                 
-                debugln("*** WebSocket TCP connection established ***");
-                debugln("WebSocket handshake complete, sending STOMP CONNECT...");
+                APP_LOGD(WS, "WebSocket handshake complete, sending STOMP CONNECT...");
                 
                 // Use cached token (fetched before connecting)
                 if (_cached_token.length() == 0) {
-                    debugln("ERROR: Cached access token is empty!");
-                    _ws.disconnect();
+                    APP_LOGE(WS, "Cached access token is empty!");
+                    _enter_backoff(WS_REASON_AUTH_FAILED);
                     break;
                 }
                 
-                debug("Using cached token, length: ");
-                debugln(_cached_token.length());
+                APP_LOGV(WS, "Using cached token, length: %u", (unsigned)_cached_token.length());
                 
                 // Build STOMP CONNECT headers exactly as Python diagnostic does
                 // Python format: host:lion.lamarzocco.io, accept-version:1.2,1.1,1.0, heart-beat:0,0, Authorization:Bearer token
                 String connect_headers = "host:" + String(WS_BASE_URL) + "\n";
                 connect_headers += "accept-version:1.2,1.1,1.0\n";
-                connect_headers += "heart-beat:0,0\n";
+                connect_headers += "heart-beat:" + String(STOMP_HEARTBEAT_SEND_MS) + "," +
+                                   String(STOMP_HEARTBEAT_RECV_MS) + "\n";
                 connect_headers += "Authorization:Bearer " + _cached_token + "\n";
                 
                 String connect_msg = _encode_stomp_message("CONNECT", connect_headers);
                 
-                debugln("Sending STOMP CONNECT:");
-                debugln("--- RAW CONNECT MESSAGE ---");
-                // Print with visible control characters for debugging
-                for (size_t i = 0; i < connect_msg.length() && i < 500; i++) {
-                    char c = connect_msg[i];
-                    if (c == '\n') Serial.print("\\n\n");
-                    else if (c == '\x00') Serial.print("\\x00");
-                    else Serial.print(c);
-                }
-                Serial.println();
-                debugln("--- END MESSAGE ---");
+                // Headers only: the frame carries the bearer token
+                APP_LOGV(WS, "CONNECT: host:%s accept-version:1.2,1.1,1.0 heart-beat:%u,%u (%u bytes)",
+                         WS_BASE_URL, (unsigned)STOMP_HEARTBEAT_SEND_MS,
+                         (unsigned)STOMP_HEARTBEAT_RECV_MS, (unsigned)connect_msg.length());
                 
                 // Send the STOMP CONNECT message immediately
-                bool sent = _ws.sendTXT(connect_msg);
+                bool sent = _send_text(connect_msg);
                 if (sent) {
-                    debugln("✓ STOMP CONNECT sent successfully");
-                    debugln("Waiting for server CONNECTED response...");
+                    APP_LOGD(WS, "✓ STOMP CONNECT sent, waiting for CONNECTED");
+                    _set_state(WS_STATE_STOMP_CONNECT);
                 } else {
-                    debugln("✗ ERROR: Failed to send STOMP CONNECT!");
-                    _ws.disconnect();
+                    APP_LOGE(WS, "✗ Failed to send STOMP CONNECT!");
+                    _enter_backoff(WS_REASON_TRANSPORT_ERROR);
                 }
             }
             break;
             
         case WStype_TEXT:
             {
-                String message = String((char*)payload, length);
-                debug("*** WebSocket TEXT message received (");
-                debug(length);
-                debugln(" bytes) ***");
-                debugln("Raw message:");
-                debugln(message);
+                APP_LOGV(WS, "WebSocket TEXT message received (%u bytes)", (unsigned)length);
+                update_trace_begin();
                 
-                // Try to decode as STOMP message
-                String command, headers, body;
-                if (_decode_stomp_message(message, command, headers, body)) {
-                    debug("✓ Decoded STOMP - command: ");
-                    debugln(command);
-                    if (headers.length() > 0) {
-                        debug("Headers: ");
-                        debugln(headers);
-                    }
-                    if (body.length() > 0) {
-                        debug("Body: ");
-                        debugln(body);
-                    }
-                    
-                    if (command == "CONNECTED") {
-                        debugln("*** ✓✓✓ STOMP CONNECTED - Server accepted! ✓✓✓ ***");
-                        
-                        // Generate subscription ID (pre-allocate to avoid fragmentation)
-                        _subscription_id = LaMarzoccoAuth::generate_uuid();
-                        if (_subscription_id.length() == 0) {
-                            debugln("ERROR: Failed to generate subscription ID!");
-                            _ws.disconnect();
-                            break;
-                        }
-                        
-                        // Subscribe to dashboard immediately - match Python format exactly
-                        // Build headers carefully to minimize memory allocations
-                        String subscribe_headers;
-                        subscribe_headers.reserve(256);  // Pre-allocate
-                        subscribe_headers = "destination:/ws/sn/";
-                        subscribe_headers += _serial_number;
-                        subscribe_headers += "/dashboard\n";
-                        subscribe_headers += "ack:auto\n";
-                        subscribe_headers += "id:";
-                        subscribe_headers += _subscription_id;
-                        subscribe_headers += "\n";
-                        subscribe_headers += "content-length:0\n";  // No space after colon
-                        
-                        String subscribe_msg = _encode_stomp_message("SUBSCRIBE", subscribe_headers);
-                        
-                        debugln("Sending SUBSCRIBE to dashboard:");
-                        debugln("--- RAW SUBSCRIBE MESSAGE ---");
-                        // Print with visible control characters
-                        for (size_t i = 0; i < subscribe_msg.length(); i++) {
-                            char c = subscribe_msg[i];
-                            if (c == '\n') Serial.print("\\n\n");
-                            else if (c == '\x00') Serial.print("\\x00");
-                            else Serial.print(c);
-                        }
-                        Serial.println();
-                        debugln("--- END MESSAGE ---");
-                        _ws.sendTXT(subscribe_msg);
-                        _connected = true;
-                        debugln("*** ✓✓✓ WebSocket fully connected and subscribed! ✓✓✓ ***");
-                        debugln("*** Subscription ID: " + _subscription_id + " ***");
-                        debugln("*** Topic: /ws/sn/" + _serial_number + "/dashboard ***");
-                        debugln("*** Ready to receive messages from machine... ***");
-                        debugln("*** Waiting for messages... ***");
-                    } else if (command == "MESSAGE") {
-                        // Received a message from the server - call callback with JSON body
-                        debugln("✓✓✓ Received MESSAGE frame from server ✓✓✓");
-                        debug("Message body length: ");
-                        debugln(body.length());
-                        if (_message_callback) {
-                            debugln("Calling message callback...");
-                            _message_callback(body);  // Body contains the JSON
-                            debugln("Callback completed.");
-                        } else {
-                            debugln("⚠ WARNING: No message callback registered!");
-                        }
-                    } else if (command == "ERROR") {
-                        debug("*** ✗ STOMP ERROR - Server rejected request ✗ ***");
-                        debug("Error headers: ");
-                        debugln(headers);
-                        debug("Error body: ");
-                        debugln(body);
-                        // Don't auto-disconnect - let user see the error
-                    } else {
-                        debug("? Unknown STOMP command: ");
-                        debugln(command);
-                        debug("Full message: ");
-                        debugln(message);
+                if (_assembler.size() == 0) {
+                    // Fast path: decode in place from the library's payload buffer
+                    size_t used = _process_stream((const char*)payload, length, true);
+                    if (used < length) {
+                        // content-length says the frame continues in the next message
+                        _append_to_assembler(payload + used, length - used, false);
                     }
                 } else {
-                    // Not a valid STOMP message
-                    debugln("✗ Failed to decode as STOMP message");
-                    debugln("Raw bytes (first 100):");
-                    for (size_t i = 0; i < length && i < 100; i++) {
-                        char c = payload[i];
-                        if (c >= 32 && c < 127) {
-                            debug(c);
-                        } else if (c == '\n') {
-                            debug("\\n");
-                        } else if (c == '\r') {
-                            debug("\\r");
-                        } else if (c == '\x00') {
-                            debug("\\0");
-                        } else {
-                            debug("[");
-                            debug((int)c);
-                            debug("]");
-                        }
-                    }
-                    debugln("");
+                    _append_to_assembler(payload, length, true);
                 }
             }
             break;
             
-        case WStype_ERROR:
-            debug("WebSocket error: ");
-            if (payload && length > 0) {
-                debugln((char*)payload);
-            } else {
-                debugln("Unknown error");
+        case WStype_FRAGMENT_TEXT_START:
+            update_trace_begin();
+            _fragment_is_text = true;
+            _append_to_assembler(payload, length, false);
+            break;
+            
+        case WStype_FRAGMENT_BIN_START:
+            _fragment_is_text = false;
+            break;
+            
+        case WStype_FRAGMENT:
+        case WStype_FRAGMENT_FIN:
+            if (_fragment_is_text) {
+                _append_to_assembler(payload, length, type == WStype_FRAGMENT_FIN);
             }
-            _connected = false;
+            break;
+            
+        case WStype_ERROR:
+            APP_LOGW(WS, "WebSocket error: %s",
+                     payload && length > 0 ? (const char*)payload : "Unknown error");
+            _enter_backoff(WS_REASON_TRANSPORT_ERROR);
             break;
             
         case WStype_PONG:
-            debugln("WebSocket pong received");
+            APP_LOGV(WS, "WebSocket pong received");
             break;
             
         case WStype_PING:
-            debugln("WebSocket ping received");
+            APP_LOGV(WS, "WebSocket ping received");
             break;
             
         case WStype_BIN:
-            debugln("WebSocket binary message received");
+            APP_LOGD(WS, "WebSocket binary message received");
             break;
             
         default:
             {
-                debug("WebSocket unknown event type: ");
-                debugln((int)type);
+                APP_LOGD(WS, "WebSocket unknown event type: %d", (int)type);
             }
             break;
     }
 }
 
-bool LaMarzoccoWebSocket::connect(const String& serial_number) {
-    _serial_number = serial_number;
+const char* LaMarzoccoWebSocket::reason_name(WebSocketReason reason) {
+    switch (reason) {
+        case WS_REASON_NONE:            return "none";
+        case WS_REASON_AUTH_FAILED:     return "auth failed";
+        case WS_REASON_LOW_MEMORY:      return "low memory";
+        case WS_REASON_TLS_TIMEOUT:     return "TLS timeout";
+        case WS_REASON_STOMP_TIMEOUT:   return "STOMP CONNECT timeout";
+        case WS_REASON_DISCONNECTED:    return "disconnected";
+        case WS_REASON_TRANSPORT_ERROR: return "transport error";
+        case WS_REASON_STOMP_ERROR:     return "STOMP ERROR frame";
+        case WS_REASON_STALE_LINK:      return "stale link";
+    }
+    return "unknown";
+}
+
+void LaMarzoccoWebSocket::_set_state(WebSocketState state) {
+    _state = state;
+    _state_since_ms = millis();
+}
+
+void LaMarzoccoWebSocket::_enter_backoff(WebSocketReason reason) {
+    if (_state == WS_STATE_IDLE || _state == WS_STATE_BACKOFF) {
+        return;  // Stopped, or this failure was already handled
+    }
     
-    debugln("🔌 Connecting WebSocket...");
+    bool was_subscribed = (_state == WS_STATE_SUBSCRIBED);
     
-    // Refresh access token before connecting (in case it expired)
-    // This is critical - we cannot safely call _client methods from the WebSocket callback
-    if (!_client.get_access_token()) {
-        debugln("❌ Failed to get access token");
-        return false;
+    // Change state first: _ws.disconnect() re-enters the event handler
+    _set_state(WS_STATE_BACKOFF);
+    _metrics.last_reason = reason;
+    _subscription_id = "";
+    _assembler.reset();  // Partial frames from the old session are useless
+    if (!_replaying) {
+        _ws.disconnect();  // A replayed DISCONNECTED / ERROR must not drop the live socket
     }
     
-    _cached_token = _client.get_access_token_string();
-    if (_cached_token.length() == 0) {
-        debugln("❌ Access token is empty!");
-        return false;
+    if (was_subscribed) {
+        // A fresh outage: measure time-to-reconnect from here, retry quickly
+        _outage_start_ms = millis();
+        _failures = 0;
     }
     
-    // Disconnect if already connected
-    if (_connected) {
-        disconnect();
-        delay(300);  // Wait for clean disconnect
+    // Exponential backoff with jitter: half of the delay is fixed, half random,
+    // so many displays behind one router don't reconnect in lockstep
+    uint32_t delay_ms = WS_BACKOFF_MAX_MS;
+    if (_failures < 16) {
+        uint32_t exp_delay = (uint32_t)WS_BACKOFF_BASE_MS << _failures;
+        if (exp_delay < delay_ms) {
+            delay_ms = exp_delay;
+        }
     }
-    
-    // Get installation key headers for HTTP upgrade request
-    InstallationKey key;
-    if (!_client.get_installation_key(key)) {
-        debugln("❌ Failed to get installation key!");
-        return false;
+    delay_ms = delay_ms / 2 + esp_random() % (delay_ms / 2 + 1);
+    if (_failures < 255) {
+        _failures++;
     }
+    _next_attempt_ms = millis() + delay_ms;
     
-    String installation_id, timestamp, nonce, signature;
-    LaMarzoccoAuth::generate_extra_request_headers(key, installation_id, timestamp, nonce, signature);
+    APP_LOGW(WS, "Link down (%s), next attempt in %u ms", reason_name(reason), (unsigned)delay_ms);
+}
+
+bool LaMarzoccoWebSocket::connect(const String& serial_number) {
+    _serial_number = serial_number;
     
-    if (signature.length() == 0) {
-        debugln("❌ Failed to generate signature!");
-        return false;
+    if (_state != WS_STATE_IDLE) {
+        return true;  // Controller already running - never start a second attempt
     }
     
-    yield();  // Give system time to recover after heavy crypto
-    
-    // Prepare HTTP upgrade headers
-    
-    // CRITICAL: Installation key headers MUST be sent in HTTP WebSocket upgrade request
-    // WebSocketsClient library adds NEW_LINE after extraHeaders, so don't add trailing \r\n
-    // Format: "Header1: Value1\r\nHeader2: Value2" (no trailing \r\n on last header)
-    // Build headers carefully with reserve to avoid fragmentation
-    String extraHeaders;
-    extraHeaders.reserve(400);  // Pre-allocate to avoid fragmentation
-    extraHeaders = "X-App-Installation-Id: ";
-    extraHeaders += installation_id;
-    extraHeaders += "\r\nX-Timestamp: ";
-    extraHeaders += timestamp;
-    extraHeaders += "\r\nX-Nonce: ";
-    extraHeaders += nonce;
-    extraHeaders += "\r\nX-Request-Signature: ";
-    extraHeaders += signature;  // No \r\n on last header
-    
-    // Set extra headers BEFORE calling beginSSL
-    _ws.setExtraHeaders(extraHeaders.c_str());
-    
-    // Make sure we're not already trying to connect
-    _ws.disconnect();
-    delay(200);
-    yield();
+    APP_LOGD(WS, "🔌 Starting WebSocket connection controller...");
+    _outage_start_ms = millis();
+    _failures = 0;
+    _next_attempt_ms = millis();  // First attempt on the next loop()
+    _set_state(WS_STATE_BACKOFF);
+    return true;
+}
+
+void LaMarzoccoWebSocket::_attempt() {
+    _set_state(WS_STATE_TLS);
+    _step = WS_STEP_TOKEN;
+    _metrics.connect_attempts++;
     
-    // Safety check: verify we have enough free heap before connecting
-    size_t free_heap = ESP.getFreeHeap();
-    if (free_heap < 20000) {
-        debugln("❌ Low memory, skipping connection");
-        return false;
+    APP_LOGD(WS, "🔌 Connecting WebSocket...");
+}
+
+// Run one step of the current attempt. Each step is a separate loop() call so
+// token refresh, signing and the socket setup never add up in one iteration.
+void LaMarzoccoWebSocket::_attempt_step() {
+    switch (_step) {
+        case WS_STEP_TOKEN: {
+            // Refresh access token before connecting (in case it expired)
+            // This is critical - we cannot safely call _client methods from the WebSocket callback
+            if (!_client.get_access_token()) {
+                APP_LOGE(WS, "❌ Failed to get access token");
+                _enter_backoff(WS_REASON_AUTH_FAILED);
+                return;
+            }
+            
+            _cached_token = _client.get_access_token_string();
+            if (_cached_token.length() == 0) {
+                APP_LOGE(WS, "❌ Access token is empty!");
+                _enter_backoff(WS_REASON_AUTH_FAILED);
+                return;
+            }
+            _step = WS_STEP_SIGN;
+            break;
+        }
+        
+        case WS_STEP_SIGN: {
+            // Installation key headers for the HTTP upgrade request, normally
+            // pre-signed by the background pool so this step is cheap
+            SignedHeaders signed_headers;
+            if (!_client.take_signed_headers(signed_headers)) {
+                APP_LOGE(WS, "❌ Failed to generate signature!");
+                _enter_backoff(WS_REASON_AUTH_FAILED);
+                return;
+            }
+            
+            // CRITICAL: Installation key headers MUST be sent in HTTP WebSocket upgrade request
+            // WebSocketsClient library adds NEW_LINE after extraHeaders, so don't add trailing \r\n
+            // Format: "Header1: Value1\r\nHeader2: Value2" (no trailing \r\n on last header)
+            // Build headers carefully with reserve to avoid fragmentation
+            _extra_headers = "";
+            _extra_headers.reserve(400);  // Pre-allocate to avoid fragmentation
+            _extra_headers = "X-App-Installation-Id: ";
+            _extra_headers += signed_headers.installation_id;
+            _extra_headers += "\r\nX-Timestamp: ";
+            _extra_headers += signed_headers.timestamp;
+            _extra_headers += "\r\nX-Nonce: ";
+            _extra_headers += signed_headers.nonce;
+            _extra_headers += "\r\nX-Request-Signature: ";
+            _extra_headers += signed_headers.signature;  // No \r\n on last header
+            _step = WS_STEP_BEGIN;
+            break;
+        }
+        
+        case WS_STEP_BEGIN: {
+            // Safety check: verify we have enough free heap before connecting
+            size_t free_heap = ESP.getFreeHeap();
+            if (free_heap < 20000) {
+                APP_LOGW(WS, "❌ Low memory, skipping connection");
+                _enter_backoff(WS_REASON_LOW_MEMORY);
+                return;
+            }
+            
+            // Set extra headers BEFORE calling beginSSL (the library keeps its own copy)
+            _ws.setExtraHeaders(_extra_headers.c_str());
+            _extra_headers = "";
+            
+            // Connect to websocket (beginSSL handles SSL automatically)
+            _ws.beginSSL(WS_BASE_URL, WS_PORT, "/ws/connect");
+            
+            // WebSocket pings keep inbound traffic flowing (pongs) even when the
+            // server declines STOMP heart-beats, so the stale-link check stays valid
+            _ws.enableHeartbeat(STOMP_STALE_LINK_TIMEOUT_MS / 3, STOMP_STALE_LINK_TIMEOUT_MS / 3, 2);
+            _last_rx_ms = millis();
+            
+            // The handshake timeout starts now, not before the token/signing work
+            _set_state(WS_STATE_TLS);
+            _step = WS_STEP_HANDSHAKE;
+            APP_LOGD(WS, "✓ Connection initiated, waiting for handshake...");
+            break;
+        }
+        
+        case WS_STEP_HANDSHAKE:
+            break;
     }
-    
-    // Connect to websocket (beginSSL handles SSL automatically)
-    _ws.beginSSL(WS_BASE_URL, 443, "/ws/connect");
-    
-    debugln("✓ Connection initiated, waiting for handshake...");
-    
-    return true;
 }
 
 void LaMarzoccoWebSocket::disconnect() {
-    // Save connected state before clearing it
-    bool was_connected = _connected;
+    bool was_subscribed = (_state == WS_STATE_SUBSCRIBED);
     
-    // Set connected to false first to prevent callbacks from trying to use the connection
-    _connected = false;
+    // Stop the controller first so neither callbacks nor loop() reconnect
+    _set_state(WS_STATE_IDLE);
     
-    // Disable auto-reconnect to prevent callbacks after disconnect
-    _ws.setReconnectInterval(0);  // 0 = disable auto-reconnect
-    
-    // Try to unsubscribe if we have a subscription and were connected
-    if (was_connected && _subscription_id.length() > 0) {
-        // Try to send unsubscribe message
-        // The WebSocket library should handle this gracefully
+    // Try to unsubscribe if we have a subscription and were connected.
+    // sendTXT() hands the frame to the TLS socket before returning, so no
+    // settling delay is needed before closing.
+    if (was_subscribed && _subscription_id.length() > 0) {
         String unsubscribe_headers = "id:" + _subscription_id + "\n";
         String unsubscribe_msg = _encode_stomp_message("UNSUBSCRIBE", unsubscribe_headers);
-        _ws.sendTXT(unsubscribe_msg);
-        // Give it a moment to send
-        delay(50);
+        _send_text(unsubscribe_msg);
     }
     
     // Disconnect the WebSocket (this is safe to call even if already disconnected)
@@ -476,9 +621,8 @@ void LaMarzoccoWebSocket::disconnect() {
     // Clear subscription ID and cached token
     _subscription_id = "";
     _cached_token = "";
-    
-    // Re-enable reconnect interval for future connections
-    _ws.setReconnectInterval(10000);
+    _extra_headers = "";
+    _assembler.reset();
 }
 
 void LaMarzoccoWebSocket::loop() {
@@ -487,12 +631,149 @@ void LaMarzoccoWebSocket::loop() {
         return;
     }
     
-    // This must be called regularly for websocket to work
-    // Protect against crashes in WebSocket library
-    _ws.loop();
+    WebSocketState state = _state;
+    unsigned long start_us = micros();
+    _loop_state();
+    uint32_t elapsed_us = micros() - start_us;
+    
+    size_t bucket = 0;
+    while (bucket < WS_LOOP_HIST_BUCKETS - 1 && elapsed_us >= WS_LOOP_HIST_BOUNDS_US[bucket]) {
+        bucket++;
+    }
+    _metrics.loop_hist[bucket]++;
+    if (elapsed_us > _metrics.loop_us_max) {
+        _metrics.loop_us_max = elapsed_us;
+        _metrics.loop_max_state = state;
+    }
+}
+
+void LaMarzoccoWebSocket::_loop_state() {
+    switch (_state) {
+        case WS_STATE_IDLE:
+            break;
+            
+        case WS_STATE_BACKOFF:
+            // The library is not pumped here, so it cannot reconnect behind our back
+            if ((long)(millis() - _next_attempt_ms) >= 0) {
+                _attempt();
+            }
+            break;
+            
+        case WS_STATE_TLS:
+            if (_step != WS_STEP_HANDSHAKE) {
+                _attempt_step();
+                break;
+            }
+            // Fall through - the library drives the handshake
+        case WS_STATE_STOMP_CONNECT:
+            _ws.loop();
+            if ((_state == WS_STATE_TLS || _state == WS_STATE_STOMP_CONNECT) &&
+                millis() - _state_since_ms > WS_CONNECT_TIMEOUT_MS) {
+                _enter_backoff(_state == WS_STATE_TLS ? WS_REASON_TLS_TIMEOUT : WS_REASON_STOMP_TIMEOUT);
+            }
+            break;
+            
+        case WS_STATE_SUBSCRIBED:
+            // This must be called regularly for websocket to work
+            _ws.loop();
+            
+            // Send our heart-beat and detect a dead link
+            _check_heartbeat();
+            break;
+    }
+}
+
+bool LaMarzoccoWebSocket::replay(const char* path, uint32_t speedup) {
+    StompCaptureReader reader;
+    if (!reader.open(path)) {
+        APP_LOGE(CAPTURE, "Replay: cannot open capture %s", path);
+        return false;
+    }
+    
+    // Pretend an attempt is in flight so the recorded events drive the
+    // controller exactly as the live socket would. Everything the controller
+    // keeps about the live link is put back afterwards.
+    WebSocketState saved_state = _state;
+    unsigned long saved_state_since_ms = _state_since_ms;
+    unsigned long saved_next_attempt_ms = _next_attempt_ms;
+    unsigned long saved_outage_start_ms = _outage_start_ms;
+    uint8_t saved_failures = _failures;
+    WebSocketConnectStep saved_step = _step;
+    unsigned long saved_last_rx_ms = _last_rx_ms;
+    unsigned long saved_last_tx_ms = _last_tx_ms;
+    uint32_t saved_hb_send_ms = _hb_send_ms;
+    uint32_t saved_hb_recv_ms = _hb_recv_ms;
+    uint32_t saved_stale_timeout_ms = _stale_timeout_ms;
+    String saved_subscription_id = _subscription_id;
+    String saved_token = _cached_token;
+    if (_cached_token.length() == 0) {
+        _cached_token = "replay";
+    }
+    _replaying = true;
+    _set_state(WS_STATE_TLS);
+    _step = WS_STEP_HANDSHAKE;
+    
+    WebSocketMetrics before = _metrics;
+    uint32_t events = 0;
+    uint32_t bytes = 0;
+    unsigned long start_ms = millis();
+    unsigned long busy_us = 0;
+    
+    StompCaptureRecord record;
+    uint8_t* payload = nullptr;
+    while (reader.next(record, payload)) {
+        if (speedup > 0) {
+            unsigned long due_ms = start_ms + record.rx_ms / speedup;
+            while ((long)(due_ms - millis()) > 0) {
+                vTaskDelay(pdMS_TO_TICKS(1));
+            }
+        }
+        unsigned long event_start_us = micros();
+        _handle_websocket_event((WStype_t)record.type, payload, record.length);
+        busy_us += micros() - event_start_us;
+        events++;
+        bytes += record.length;
+    }
+    
+    _replaying = false;
+    _cached_token = saved_token;
+    _subscription_id = saved_subscription_id;
+    _assembler.reset();
+    _state = saved_state;
+    _state_since_ms = saved_state_since_ms;
+    _next_attempt_ms = saved_next_attempt_ms;
+    _outage_start_ms = saved_outage_start_ms;
+    _failures = saved_failures;
+    _step = saved_step;
+    _last_rx_ms = saved_last_rx_ms;
+    _last_tx_ms = saved_last_tx_ms;
+    _hb_send_ms = saved_hb_send_ms;
+    _hb_recv_ms = saved_hb_recv_ms;
+    _stale_timeout_ms = saved_stale_timeout_ms;
+    
+    // Only the decoder counters keep what the replay did
+    WebSocketMetrics replayed = _metrics;
+    _metrics.stale_link_reconnects = before.stale_link_reconnects;
+    _metrics.connect_attempts = before.connect_attempts;
+    _metrics.connect_successes = before.connect_successes;
+    _metrics.reconnect_ms_last = before.reconnect_ms_last;
+    _metrics.reconnect_ms_max = before.reconnect_ms_max;
+    _metrics.last_reason = before.last_reason;
+    
+    APP_LOGI(CAPTURE, "Replay: %u events, %u bytes in %lu ms (%lu us in handler)",
+             events, bytes, millis() - start_ms, busy_us);
+    APP_LOGI(CAPTURE, "Replay: %u frames decoded, %u failed, decode max %u us, %u reassembled",
+             _metrics.frames_decoded - before.frames_decoded,
+             _metrics.decode_failures - before.decode_failures,
+             _metrics.decode_us_max,
+             _metrics.frames_reassembled - before.frames_reassembled);
+    APP_LOGI(CAPTURE, "Replay: %u subscribes, last link-down reason: %s (not counted as live)",
+             replayed.connect_successes - before.connect_successes,
+             reason_name(replayed.last_reason));
+    return true;
 }
 
-void LaMarzoccoWebSocket::set_message_callback(void (*callback)(const String& message)) {
+void LaMarzoccoWebSocket::set_message_callback(void (*callback)(const char* body, size_t length)) {
     _message_callback = callback;
 }
 
@@ -0,0 +1,90 @@
+#include "machine_events.h"
+#include "spsc_ring.h"
+#include "boiler_display.h"
+#include "brewing_display.h"
+#include "water_alarm.h"
+#include <string.h>
+
+// One dashboard message produces at most six events
+static SpscRing<MachineEvent, 32> g_events;
+static MachineEventStats g_stats = {};
+
+bool machine_events_push(const MachineEvent& event) {
+    if (!g_events.push(event)) {
+        g_stats.dropped++;
+        return false;
+    }
+    g_stats.pushed++;
+    return true;
+}
+
+bool machine_events_push_water_alarm(bool active) {
+    MachineEvent event;
+    event.type = MACHINE_EVENT_WATER_ALARM;
+    event.water_alarm.active = active;
+    return machine_events_push(event);
+}
+
+bool machine_events_push_brewing(bool is_brewing, int64_t brewing_start_time) {
+    MachineEvent event;
+    event.type = MACHINE_EVENT_BREWING;
+    event.brewing.is_brewing = is_brewing;
+    event.brewing.brewing_start_time = brewing_start_time;
+    return machine_events_push(event);
+}
+
+bool machine_events_push_boiler(BoilerType boiler, MachineStatus machine_status,
+                                BoilerStatus boiler_status, int64_t ready_start_time) {
+    MachineEvent event;
+    event.type = MACHINE_EVENT_BOILER;
+    event.boiler.boiler = boiler;
+    event.boiler.machine_status = machine_status;
+    event.boiler.boiler_status = boiler_status;
+    event.boiler.ready_start_time = ready_start_time;
+    return machine_events_push(event);
+}
+
+bool machine_events_push_boiler_target(BoilerType boiler, const char* target_value) {
+    MachineEvent event;
+    event.type = MACHINE_EVENT_BOILER_TARGET;
+    event.boiler_target.boiler = boiler;
+    if (target_value) {
+        strncpy(event.boiler_target.target_value, target_value, MACHINE_TARGET_LEN - 1);
+        event.boiler_target.target_value[MACHINE_TARGET_LEN - 1] = '\0';
+    } else {
+        event.boiler_target.target_value[0] = '\0';
+    }
+    return machine_events_push(event);
+}
+
+void machine_events_drain(void) {
+    MachineEvent event;
+    while (g_events.pop(event)) {
+        switch (event.type) {
+            case MACHINE_EVENT_WATER_ALARM:
+                water_alarm_set(event.water_alarm.active);
+                break;
+                
+            case MACHINE_EVENT_BREWING:
+                brewing_display_update(event.brewing.is_brewing, event.brewing.brewing_start_time);
+                break;
+                
+            case MACHINE_EVENT_BOILER:
+                boiler_display_update(event.boiler.boiler,
+                                      event.boiler.machine_status,
+                                      event.boiler.boiler_status,
+                                      event.boiler.ready_start_time);
+                break;
+                
+            case MACHINE_EVENT_BOILER_TARGET:
+                boiler_display_set_target(event.boiler_target.boiler,
+                                          event.boiler_target.target_value);
+                break;
+        }
+        g_stats.applied++;
+    }
+}
+
+MachineEventStats machine_events_get_stats(void) {
+    return g_stats;
+}
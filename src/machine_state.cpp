@@ -0,0 +1,86 @@
+#include "machine_state.h"
+#include "dashboard_codes.h"
+#include "dashboard_diff.h"
+#include "boiler_display.h"
+#include <string.h>
+
+static MachineStatus machine_status_lookup(const char* str, size_t length) {
+    switch (dashboard_hash(str, length)) {
+        MACHINE_STATUS_CODES(DASHBOARD_LOOKUP_CASE)
+        default:
+            break;
+    }
+    return MACHINE_STATUS_OTHER;
+}
+
+static BoilerStatus boiler_status_lookup(const char* str, size_t length) {
+    switch (dashboard_hash(str, length)) {
+        BOILER_STATUS_CODES(DASHBOARD_LOOKUP_CASE)
+        default:
+            break;
+    }
+    return BOILER_STATUS_OTHER;
+}
+
+MachineStatus machine_status_from_string(const char* status) {
+    if (!status || !status[0]) return MACHINE_STATUS_UNKNOWN;
+    return machine_status_lookup(status, strlen(status));
+}
+
+BoilerStatus boiler_status_from_string(const char* status) {
+    if (!status || !status[0]) return BOILER_STATUS_UNKNOWN;
+    return boiler_status_lookup(status, strlen(status));
+}
+
+const char* machine_status_name(MachineStatus status) {
+    switch (status) {
+        MACHINE_STATUS_CODES(DASHBOARD_NAME_CASE)
+        case MACHINE_STATUS_OTHER: return "Other";
+        default: return "Unknown";
+    }
+}
+
+const char* boiler_status_name(BoilerStatus status) {
+    switch (status) {
+        BOILER_STATUS_CODES(DASHBOARD_NAME_CASE)
+        case BOILER_STATUS_OTHER: return "Other";
+        default: return "Unknown";
+    }
+}
+
+bool machine_status_is_on(MachineStatus status) {
+    return status != MACHINE_STATUS_UNKNOWN &&
+           status != MACHINE_STATUS_OFF &&
+           status != MACHINE_STATUS_STANDBY;
+}
+
+static bool boiler_changed(const BoilerSnapshot& a, const BoilerSnapshot& b) {
+    return a.status != b.status || a.ready_start_time != b.ready_start_time;
+}
+
+uint32_t machine_state_diff(const MachineState& previous, const MachineState& current) {
+    uint32_t mask = 0;
+    if (previous.machine != current.machine) {
+        mask |= MACHINE_CHANGED_STATUS;
+    }
+    if (previous.brewing != current.brewing ||
+        previous.brewing_start_time != current.brewing_start_time) {
+        mask |= MACHINE_CHANGED_BREWING;
+    }
+    if (boiler_changed(previous.boilers[BOILER_COFFEE], current.boilers[BOILER_COFFEE])) {
+        mask |= MACHINE_CHANGED_COFFEE;
+    }
+    if (boiler_changed(previous.boilers[BOILER_STEAM], current.boilers[BOILER_STEAM])) {
+        mask |= MACHINE_CHANGED_STEAM;
+    }
+    if (strcmp(previous.boilers[BOILER_COFFEE].target, current.boilers[BOILER_COFFEE].target) != 0) {
+        mask |= MACHINE_CHANGED_COFFEE_TARGET;
+    }
+    if (strcmp(previous.boilers[BOILER_STEAM].target, current.boilers[BOILER_STEAM].target) != 0) {
+        mask |= MACHINE_CHANGED_STEAM_TARGET;
+    }
+    if (previous.no_water != current.no_water) {
+        mask |= MACHINE_CHANGED_NO_WATER;
+    }
+    return mask;
+}
@@ -14,6 +14,13 @@
 #include "boiler_display.h"
 #include "water_alarm.h"
 #include "brewing_display.h"
+#include "machine_events.h"
+#include "command_queue.h"
+#include "control_display.h"
+#include "json_allocator.h"
+#include "app_log.h"
+#include "update_trace.h"
+#include <esp_heap_caps.h>
 
 Preferences preferences;
 LaMarzoccoClient* g_client = nullptr;
@@ -23,6 +30,7 @@ LaMarzoccoMachine* g_machine = nullptr;
 LilyGo_Class amoled;
 SemaphoreHandle_t gui_mutex;
 void Task_LVGL(void *pvParameters);
+void Task_Network(void *pvParameters);
 
 // WiFi connection variables
 const int MAX_WIFI_RETRIES = 10;
@@ -88,9 +96,15 @@ void enterDeepSleep() {
 void setup()
 {
   Serial.begin(115200);
+  app_log_begin();
   preferences.begin("config", false);
   pinMode(0, INPUT_PULLUP);
 
+  // JSON documents live in PSRAM arenas, away from the TLS buffers
+  if (!json_dashboard_arena.begin() || !json_api_arena.begin()) {
+    debugln("JSON arenas unavailable - documents will use the heap");
+  }
+
   bool rslt = false;
 
   // Automatically determine the access device
@@ -105,7 +119,8 @@ void setup()
     }
   }
 
-  gui_mutex = xSemaphoreCreateMutex();
+  // Recursive: Task_LVGL applies queued machine events while holding it
+  gui_mutex = xSemaphoreCreateRecursiveMutex();
   if (gui_mutex == NULL)
   {
     // Handle semaphore creation failure
@@ -208,6 +223,11 @@ void setup()
             g_websocket = new LaMarzoccoWebSocket(*g_client);
             g_machine = new LaMarzoccoMachine(*g_client, *g_websocket);
             
+            // Power / steam buttons hand their commands to this worker
+            if (!command_queue_begin(g_machine)) {
+              debugln("Command worker not started - buttons disabled");
+            }
+            
             debugln("La Marzocco client initialized");
             
             // Auto-connect WebSocket on startup
@@ -218,6 +238,20 @@ void setup()
               debugln("✗ Failed to initiate WebSocket connection on startup");
               // Note: WebSocket failures are not critical, will retry automatically
             }
+            
+#if TRACE_HTTP
+            // Latency histograms at http://<device>/latency
+            setupStatusWEB();
+#endif
+            
+            // From here on the network stack is pumped by its own task
+            xTaskCreatePinnedToCore(Task_Network,
+                                    "Task_Network",
+                                    1024 * 16,  // TLS + ECDSA signing on reconnect
+                                    NULL,
+                                    2,
+                                    NULL,
+                                    1);
           }
         } else {
           debugln("Failed to initialize La Marzocco client");
@@ -255,47 +289,9 @@ void loop()
   // Check GPIO 15 for brewing simulation mode
   brewing_display_check_gpio_simulation();
   
-  // Handle websocket and machine loop - MUST be called frequently
-  // WebSocket requires regular loop() calls to process messages
-  if (g_machine) {
-    g_machine->loop();  // This calls websocket.loop()
-  }
-  
-  // Small delay to prevent watchdog issues, but keep loop responsive
+  // Small delay to prevent watchdog issues
   delay(10);
   
-  // Fast reconnection check (every 5 seconds)
-  static unsigned long last_check = 0;
-  static unsigned long last_reconnect_attempt = 0;
-  static const unsigned long CHECK_INTERVAL = 5000;     // Check every 5 seconds
-  static const unsigned long RECONNECT_INTERVAL = 10000; // Try reconnect every 10 seconds
-  
-  if (millis() - last_check > CHECK_INTERVAL) {
-    last_check = millis();
-    if (g_machine) {
-      if (g_machine->is_websocket_connected()) {
-        // Connected - only log occasionally to reduce noise
-        static unsigned long last_log = 0;
-        if (millis() - last_log > 60000) { // Log every 60 seconds when connected
-          Serial.println("[STATUS] ✓ WebSocket connected");
-          last_log = millis();
-        }
-      } else {
-        // Disconnected - try to reconnect quickly
-        if (millis() - last_reconnect_attempt > RECONNECT_INTERVAL) {
-          last_reconnect_attempt = millis();
-          Serial.println("[RECONNECT] WebSocket disconnected, reconnecting...");
-          
-          // Try to reconnect
-          if (g_machine->connect_websocket()) {
-            Serial.println("[RECONNECT] ✓ Reconnection initiated");
-          } else {
-            Serial.println("[RECONNECT] ✗ Reconnection failed, will retry in 10s");
-          }
-        }
-      }
-    }
-  }
   // Check if BOOT button (GPIO 0) is held down to turn OFF
     // (GPIO 0 is LOW when pressed)
     if (digitalRead(0) == LOW) {
@@ -312,9 +308,198 @@ void loop()
     }
 }
 
+// Internal heap fragmentation and JSON arena usage
+static void printHeapStatus()
+{
+  const JsonArenaStats& da = json_dashboard_arena.get_stats();
+  const JsonArenaStats& aa = json_api_arena.get_stats();
+  APP_LOGI(STATUS, "Internal heap: %u free, largest block %u, min free %u",
+           (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+           (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL),
+           (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+  APP_LOGI(STATUS, "JSON arena dashboard: %u/%u bytes, %u resets, %u fallbacks",
+           da.high_water, (unsigned)json_dashboard_arena.capacity(), da.resets, da.fallbacks);
+  APP_LOGI(STATUS, "JSON arena api: %u/%u bytes, %u resets, %u fallbacks",
+           aa.high_water, (unsigned)json_api_arena.capacity(), aa.resets, aa.fallbacks);
+}
+
+static void printWebSocketStatus()
+{
+  APP_LOGI(STATUS, "%s", g_machine->is_websocket_connected() ? "✓ WebSocket connected" : "✗ WebSocket not connected");
+  if (!g_websocket) {
+    return;
+  }
+  const WebSocketMetrics& m = g_websocket->get_metrics();
+  APP_LOGI(STATUS, "Link state %d, %u attempts / %u successes, reconnect %u ms (max %u ms), last drop: %s",
+           (int)g_websocket->get_state(), m.connect_attempts, m.connect_successes,
+           m.reconnect_ms_last, m.reconnect_ms_max, LaMarzoccoWebSocket::reason_name(m.last_reason));
+  char hist[APP_LOG_LINE_LEN] = "";
+  size_t used = 0;
+  for (size_t i = 0; i < WS_LOOP_HIST_BUCKETS && used < sizeof(hist); i++) {
+    int n = i < WS_LOOP_HIST_BUCKETS - 1
+                ? snprintf(hist + used, sizeof(hist) - used, " <%ums:%u", WS_LOOP_HIST_BOUNDS_US[i] / 1000, m.loop_hist[i])
+                : snprintf(hist + used, sizeof(hist) - used, " slower:%u", m.loop_hist[i]);
+    if (n < 0) {
+      break;
+    }
+    used += (size_t)n;
+  }
+  APP_LOGI(STATUS, "WS loop() latency:%s, max %u us (state %d)", hist, m.loop_us_max, (int)m.loop_max_state);
+  APP_LOGI(STATUS, "STOMP frames: %u decoded, %u failed, decode %u us (max %u us)",
+           m.frames_decoded, m.decode_failures, m.decode_us_last, m.decode_us_max);
+  APP_LOGI(STATUS, "Last inbound frame %lu ms ago, heart-beats %u sent / %u received, %u stale-link reconnects",
+           g_websocket->ms_since_last_rx(), m.heartbeats_sent, m.heartbeats_received,
+           m.stale_link_reconnects);
+  APP_LOGI(STATUS, "Reassembled %u frames, %u overflows, %u content-length mismatches",
+           m.frames_reassembled, m.assembler_overflows, m.length_mismatches);
+}
+
+static void printClientStatus()
+{
+  if (!g_client) {
+    return;
+  }
+  SignedHeaderPoolStats p = g_client->get_signed_header_stats();
+  uint32_t takes = p.hits + p.misses;
+  APP_LOGI(STATUS, "Signed headers: %u hits / %u misses (%u%%), %u expired, sign %u us avg, %llu ms saved",
+           p.hits, p.misses, takes ? (p.hits * 100 / takes) : 0, p.expired, p.sign_us_avg,
+           (unsigned long long)(p.saved_us / 1000));
+  const HttpClientStats& h = g_client->get_http_stats();
+  APP_LOGI(STATUS, "HTTPS: %u requests, %u kept alive, %u handshakes, %u retried, %u failed",
+           h.requests, h.reused, h.handshakes, h.retries, h.failures);
+  APP_LOGI(STATUS, "HTTPS: last %u ms (max %u ms), kept-alive avg %u ms, with handshake avg %u ms",
+           h.request_ms_last, h.request_ms_max, h.reused_ms_avg, h.handshake_ms_avg);
+  APP_LOGI(STATUS, "Boot: first dashboard at %u ms, tokens %s, registration %s",
+           g_machine->get_first_dashboard_ms(),
+           g_client->tokens_restored() ? "restored" : "from sign-in",
+           g_client->registration_skipped() ? "skipped" : "sent");
+  TokenRefreshStats t = g_client->get_token_stats();
+  APP_LOGI(STATUS, "Token: %u refreshes, %u sign-ins, %u failed, %u inline, expires in %d s",
+           t.refreshes, t.sign_ins, t.failures, t.inline_renewals, (int)t.expires_in_s);
+  APP_LOGI(STATUS, "Token renewal %u ms (avg %u, max %u ms)",
+           t.refresh_ms_last, t.refresh_ms_avg, t.refresh_ms_max);
+}
+
+static void printDashboardStatus()
+{
+  const DashboardDiffStats& d = g_machine->get_dashboard_stats();
+  APP_LOGI(STATUS, "Dashboards: %u processed, %u skipped as identical",
+           d.processed, d.skipped);
+  const DashboardParseStats& ps = g_machine->get_parse_stats();
+  APP_LOGI(STATUS, "Dashboard JSON (%s): parse %u us (max %u us), %u bytes (max %u bytes)",
+           DASHBOARD_PARSER == DASHBOARD_PARSER_STREAM ? "stream extractor" :
+           DASHBOARD_JSON_FILTER ? "ArduinoJson, filtered" : "ArduinoJson",
+           ps.parse_us_last, ps.parse_us_max,
+           ps.json_peak_last, ps.json_peak_max);
+  APP_LOGI(STATUS, "Message handler %u us (max %u us)", ps.handler_us_last, ps.handler_us_max);
+  AppLogStats l = app_log_get_stats();
+  APP_LOGI(STATUS, "Log %s: %u lines, %u dropped, %u truncated, ring peak %u/%u",
+           APP_LOG_ASYNC ? "async" : "sync",
+           l.written, l.dropped, l.truncated, l.high_water, (unsigned)APP_LOG_RING_SLOTS);
+  const WidgetRegistryStats& w = g_machine->get_widget_stats();
+  APP_LOGI(STATUS, "Widget handlers: %u dispatched, %u changed, %u unhandled",
+           w.dispatched, w.changed, w.unhandled);
+  MachineEventStats e = machine_events_get_stats();
+  APP_LOGI(STATUS, "UI events: %u queued, %u applied, %u dropped",
+           e.pushed, e.applied, e.dropped);
+}
+
+static void printCommandStatus()
+{
+  CommandTrackerStats c = g_machine->get_command_stats();
+  APP_LOGI(STATUS, "Commands: %u sent, %u confirmed, %u failed, %u timed out, %u unknown",
+           c.issued, c.confirmed, c.failed, c.timed_out, c.unknown);
+  APP_LOGI(STATUS, "Commands: confirm %u ms (avg %u, max %u ms), POST %u ms",
+           c.confirm_ms_last, c.confirm_ms_avg, c.confirm_ms_max, c.post_ms_last);
+  CommandQueueStats q = command_queue_get_stats();
+  APP_LOGI(STATUS, "Command queue: %u queued, %u rejected, %u expired; wait max %u ms, send %u ms (max %u ms)",
+           q.submitted, q.rejected, q.expired, q.wait_ms_max, q.send_ms_last, q.send_ms_max);
+  ControlStats cs = g_machine->get_control_stats();
+  APP_LOGI(STATUS, "Buttons: %u requested, %u reported as requested, %u rolled back",
+           cs.requested, cs.reconciled, cs.rolled_back);
+  APP_LOGI(STATUS, "Buttons shown %u ms ahead of the dashboard (max %u ms)",
+           cs.reconcile_ms_last, cs.reconcile_ms_max);
+#if STOMP_CAPTURE_MODE != 0
+  StompCaptureStats cap = stomp_capture_get_stats();
+  APP_LOGI(STATUS, "Capture: %u records, %u bytes, %u dropped",
+           cap.records, cap.bytes, cap.dropped);
+#endif
+}
+
+// Periodic status report (runs on the network task). Reconnects are owned by
+// LaMarzoccoWebSocket's backoff controller.
+//
+// The report goes through the log ring like any other line, one section per
+// call: ~40 lines at once would overflow the ring, so the next section waits
+// until Task_Log has written at least half of what is queued.
+static void checkWebSocketConnection()
+{
+  static unsigned long last_log = 0;
+  static int section = -1;   // Next section to log, -1 between reports
+  if (!APP_LOG_ENABLED(STATUS, APP_LOG_INFO)) {
+    return;
+  }
+  if (section < 0) {
+    if (millis() - last_log < 60000) { // Log every 60 seconds
+      return;
+    }
+    last_log = millis();
+    section = 0;
+  }
+  if (app_log_pending() > APP_LOG_RING_SLOTS / 2) {
+    return;
+  }
+
+  switch (section++) {
+    case 0: printWebSocketStatus(); break;
+    case 1: printClientStatus(); break;
+    case 2: printDashboardStatus(); break;
+    case 3: printCommandStatus(); break;
+    case 4: printHeapStatus(); break;
+    case 5: update_trace_print("STATUS"); break;
+    default: section = -1; break;
+  }
+}
+
+// Owns the WebSocket, the STOMP session and the machine message handler.
+// Display changes leave this task only as events (see machine_events.h).
+void Task_Network(void *pvParameters)
+{
+#ifdef STOMP_REPLAY_SPEEDUP
+  // Replay the previous capture before going live (performance regressions)
+  if (g_websocket) {
+    g_websocket->replay(STOMP_CAPTURE_PATH, STOMP_REPLAY_SPEEDUP);
+  }
+#ifdef STOMP_SOAK_HOURS
+  // Soak: keep replaying and watch the largest internal block for fragmentation
+  if (g_websocket) {
+    unsigned long soak_start = millis();
+    uint32_t passes = 1;
+    while (millis() - soak_start < (unsigned long)STOMP_SOAK_HOURS * 3600000UL) {
+      g_websocket->replay(STOMP_CAPTURE_PATH, STOMP_REPLAY_SPEEDUP);
+      passes++;
+      APP_LOGI(STATUS, "Soak: %lu min, pass %u", (millis() - soak_start) / 60000, passes);
+      printHeapStatus();
+      vTaskDelay(pdMS_TO_TICKS(10));
+    }
+  }
+#endif
+#endif
+  stomp_capture_begin();  // No-op unless STOMP_CAPTURE_MODE is set
+  
+  while (1)
+  {
+    // WebSocket requires regular loop() calls to process messages
+    g_machine->loop();  // This calls websocket.loop()
+    checkWebSocketConnection();
+    vTaskDelay(pdMS_TO_TICKS(2));
+  }
+}
+
 void Task_LVGL(void *pvParameters)
 {
   beginLvglHelper(amoled);
+  setLvglFlushDoneCallback(update_trace_flushed);
   ui_init();
   
   // Initialize boiler display system after UI is ready
@@ -329,13 +514,24 @@ void Task_LVGL(void *pvParameters)
   brewing_display_set_mutex((void*)gui_mutex);
   brewing_display_init();
   
+  // Power / steam buttons show the requested state until it is reported
+  control_display_init();
+  
   // Main LVGL loop
   while (1)
   {
-    if (xSemaphoreTake(gui_mutex, portMAX_DELAY) == pdTRUE)
+    if (xSemaphoreTakeRecursive(gui_mutex, portMAX_DELAY) == pdTRUE)
     {
+      // Apply machine state produced by the network task, then render
+      update_trace_apply_begin();
+      machine_events_drain();
+      lv_disp_t* disp = lv_disp_get_default();
+      update_trace_apply_end(disp && disp->inv_p > 0);
+      // Button state from taps and command outcomes (not traced)
+      command_queue_drain();
+      control_display_refresh(g_machine);
       lv_timer_handler();
-      xSemaphoreGive(gui_mutex);
+      xSemaphoreGiveRecursive(gui_mutex);
     }
     vTaskDelay(pdMS_TO_TICKS(1));
   }
@@ -0,0 +1,144 @@
+#include "signed_header_pool.h"
+
+// How often the signer task checks the pool (ms)
+static const uint32_t SIGNER_POLL_MS = 1000;
+
+SignedHeaderPool::SignedHeaderPool()
+    : _mutex(xSemaphoreCreateMutex()), _task(nullptr), _has_key(false),
+      _count(0), _stats(), _sign_us_total(0) {
+}
+
+SignedHeaderPool::~SignedHeaderPool() {
+    if (_task) {
+        vTaskDelete(_task);
+    }
+    if (_mutex) {
+        vSemaphoreDelete(_mutex);
+    }
+}
+
+void SignedHeaderPool::begin(const InstallationKey& key) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _key = key;
+    _has_key = true;
+    _count = 0;  // Sets signed with a previous key are useless
+    xSemaphoreGive(_mutex);
+
+    if (!_task) {
+        xTaskCreatePinnedToCore(_task_main,
+                                "Task_Signer",
+                                1024 * 8,  // ECDSA signing
+                                this,
+                                1,         // Below the network and LVGL tasks
+                                &_task,
+                                0);
+    }
+}
+
+bool SignedHeaderPool::_sign(SignedHeaders& headers) {
+    InstallationKey key;
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    if (!_has_key) {
+        xSemaphoreGive(_mutex);
+        return false;
+    }
+    key = _key;
+    xSemaphoreGive(_mutex);
+
+    unsigned long start_us = micros();
+    LaMarzoccoAuth::generate_extra_request_headers(key, headers.installation_id, headers.timestamp,
+                                                   headers.nonce, headers.signature);
+    uint32_t elapsed_us = micros() - start_us;
+    headers.created_ms = millis();
+
+    if (headers.signature.length() == 0) {
+        return false;
+    }
+
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _stats.signed_sets++;
+    _stats.sign_us_last = elapsed_us;
+    _sign_us_total += elapsed_us;
+    _stats.sign_us_avg = _sign_us_total / _stats.signed_sets;
+    xSemaphoreGive(_mutex);
+    return true;
+}
+
+// Caller holds the mutex
+void SignedHeaderPool::_drop_expired() {
+    size_t kept = 0;
+    for (size_t i = 0; i < _count; i++) {
+        if (millis() - _sets[i].created_ms > SIGNED_HEADER_MAX_AGE_MS) {
+            _stats.expired++;
+            continue;
+        }
+        if (kept != i) {
+            _sets[kept] = _sets[i];
+        }
+        kept++;
+    }
+    _count = kept;
+}
+
+void SignedHeaderPool::_refill() {
+    while (true) {
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        _drop_expired();
+        bool full = (_count >= SIGNED_HEADER_POOL_SIZE);
+        xSemaphoreGive(_mutex);
+        if (full) {
+            return;
+        }
+
+        // Sign without holding the lock so take() never waits on ECDSA
+        SignedHeaders headers;
+        if (!_sign(headers)) {
+            return;
+        }
+
+        xSemaphoreTake(_mutex, portMAX_DELAY);
+        if (_count < SIGNED_HEADER_POOL_SIZE) {
+            _sets[_count++] = headers;
+        }
+        xSemaphoreGive(_mutex);
+    }
+}
+
+bool SignedHeaderPool::take(SignedHeaders& headers) {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    _drop_expired();
+    if (_count > 0) {
+        // Oldest first, so every set is used well inside its validity window
+        headers = _sets[0];
+        for (size_t i = 1; i < _count; i++) {
+            _sets[i - 1] = _sets[i];
+        }
+        _count--;
+        _stats.hits++;
+        _stats.saved_us += _stats.sign_us_avg;
+        xSemaphoreGive(_mutex);
+        if (_task) {
+            xTaskNotifyGive(_task);  // Refill now rather than at the next poll
+        }
+        return true;
+    }
+    _stats.misses++;
+    xSemaphoreGive(_mutex);
+
+    return _sign(headers);
+}
+
+SignedHeaderPoolStats SignedHeaderPool::get_stats() {
+    xSemaphoreTake(_mutex, portMAX_DELAY);
+    SignedHeaderPoolStats stats = _stats;
+    xSemaphoreGive(_mutex);
+    return stats;
+}
+
+void SignedHeaderPool::_task_main(void* arg) {
+    SignedHeaderPool* pool = static_cast<SignedHeaderPool*>(arg);
+    while (1) {
+        pool->_refill();
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SIGNER_POLL_MS));
+    }
+}
@@ -0,0 +1,43 @@
+#include "stomp_assembler.h"
+#include <esp_heap_caps.h>
+#include <stdlib.h>
+#include <string.h>
+
+StompAssembler::StompAssembler(size_t capacity)
+    : _buffer(nullptr), _capacity(capacity), _size(0) {
+}
+
+StompAssembler::~StompAssembler() {
+    free(_buffer);
+}
+
+bool StompAssembler::append(const uint8_t* data, size_t length) {
+    if (!_buffer) {
+        // Prefer PSRAM - the internal heap is needed for TLS buffers
+        _buffer = (char*)heap_caps_malloc(_capacity, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!_buffer) {
+            _buffer = (char*)malloc(_capacity);
+        }
+        if (!_buffer) {
+            return false;
+        }
+    }
+    
+    if (length > _capacity - _size) {
+        _size = 0;
+        return false;
+    }
+    
+    memcpy(_buffer + _size, data, length);
+    _size += length;
+    return true;
+}
+
+void StompAssembler::consume(size_t length) {
+    if (length >= _size) {
+        _size = 0;
+        return;
+    }
+    memmove(_buffer, _buffer + length, _size - length);
+    _size -= length;
+}
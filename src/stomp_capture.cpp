@@ -0,0 +1,255 @@
+#include "stomp_capture.h"
+#include "config.h"
+#include "app_log.h"
+#ifdef ARDUINO
+#include <SPIFFS.h>
+#endif
+#include <esp_heap_caps.h>
+#include <mbedtls/base64.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const uint8_t CAPTURE_MAGIC[4] = { 'L', 'M', 'Z', 'C' };
+
+// File access: SPIFFS on the device, stdio on the host
+#ifdef ARDUINO
+typedef File CaptureFile;
+
+static inline bool capture_file_open(CaptureFile& file, const char* path, bool write) {
+    if (!SPIFFS.begin()) {
+        return false;
+    }
+    file = SPIFFS.open(path, write ? FILE_WRITE : FILE_READ);
+    return (bool)file;
+}
+
+static inline size_t capture_file_read(CaptureFile& file, uint8_t* data, size_t length) {
+    return file.read(data, length);
+}
+
+static inline size_t capture_file_write(CaptureFile& file, const uint8_t* data, size_t length) {
+    return file.write(data, length);
+}
+
+static inline void capture_file_flush(CaptureFile& file) {
+    file.flush();
+}
+
+static inline void capture_file_close(CaptureFile& file) {
+    if (file) {
+        file.close();
+    }
+}
+#else
+typedef FILE* CaptureFile;
+
+static inline bool capture_file_open(CaptureFile& file, const char* path, bool write) {
+    file = fopen(path, write ? "wb" : "rb");
+    return file != nullptr;
+}
+
+static inline size_t capture_file_read(CaptureFile& file, uint8_t* data, size_t length) {
+    return fread(data, 1, length, file);
+}
+
+static inline size_t capture_file_write(CaptureFile& file, const uint8_t* data, size_t length) {
+    return fwrite(data, 1, length, file);
+}
+
+static inline void capture_file_flush(CaptureFile& file) {
+    fflush(file);
+}
+
+static inline void capture_file_close(CaptureFile& file) {
+    if (file) {
+        fclose(file);
+        file = nullptr;
+    }
+}
+#endif
+
+static StompCaptureStats g_stats = {};
+static unsigned long g_start_ms = 0;
+static bool g_active = false;
+#if STOMP_CAPTURE_MODE == 1
+static CaptureFile g_file;
+#endif
+
+void stomp_capture_begin(void) {
+#if STOMP_CAPTURE_MODE == 1
+    if (!capture_file_open(g_file, STOMP_CAPTURE_PATH, true)) {
+        APP_LOGE(CAPTURE, "Cannot create " STOMP_CAPTURE_PATH ", capture disabled");
+        return;
+    }
+    uint8_t header[8] = { 0 };
+    memcpy(header, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+    header[4] = STOMP_CAPTURE_VERSION;
+    capture_file_write(g_file, header, sizeof(header));
+    APP_LOGI(CAPTURE, "Recording to " STOMP_CAPTURE_PATH);
+#elif STOMP_CAPTURE_MODE == 2
+    // Capture lines bypass the log: they must not be dropped, filtered or cut
+    Serial.printf("[CAP] LMZC v%d\n", STOMP_CAPTURE_VERSION);
+#else
+    return;
+#endif
+    g_start_ms = millis();
+    g_stats = {};
+    g_active = true;
+}
+
+#if STOMP_CAPTURE_MODE == 2
+// One "[CAP] " line, reused across records (grows to the largest one)
+static char* g_line = nullptr;
+static size_t g_line_size = 0;
+
+static bool reserve_line(size_t size) {
+    if (size <= g_line_size) {
+        return true;
+    }
+    free(g_line);
+    g_line = (char*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!g_line) {
+        g_line = (char*)malloc(size);
+    }
+    g_line_size = g_line ? size : 0;
+    return g_line != nullptr;
+}
+
+// Base64 in 48-byte chunks (a multiple of 3, so the pieces concatenate)
+static void append_base64(uint8_t* chunk, size_t& used, bool flush, size_t& pos) {
+    if (used == 0 || (used < 48 && !flush)) {
+        return;
+    }
+    size_t out_len = 0;
+    mbedtls_base64_encode((unsigned char*)g_line + pos, g_line_size - pos, &out_len, chunk, used);
+    pos += out_len;
+    used = 0;
+}
+#endif
+
+void stomp_capture_record(uint8_t type, const uint8_t* payload, size_t length) {
+    if (!g_active) {
+        return;
+    }
+    if (!payload) {
+        length = 0;
+    }
+    StompCaptureRecord record;
+    record.rx_ms = millis() - g_start_ms;
+    record.type = type;
+    record.length = length;
+
+#if STOMP_CAPTURE_MODE == 1
+    if (g_stats.bytes + sizeof(record) + length > STOMP_CAPTURE_MAX_BYTES) {
+        g_stats.dropped++;
+        stomp_capture_end();  // Full: close it while it ends on a whole record
+        return;
+    }
+    if (capture_file_write(g_file, (const uint8_t*)&record, sizeof(record)) != sizeof(record) ||
+        (length > 0 && capture_file_write(g_file, payload, length) != length)) {
+        g_stats.dropped++;
+        return;
+    }
+    if ((g_stats.records & 15) == 15) {
+        capture_file_flush(g_file);  // Keep the file usable if the device resets mid-capture
+    }
+#elif STOMP_CAPTURE_MODE == 2
+    // The whole line goes out in one write: another task's output can land
+    // between two writes, and capture_from_log.py drops a record cut in two
+    static const char PREFIX[] = "[CAP] ";
+    size_t raw = sizeof(record) + length;
+    if (!reserve_line(sizeof(PREFIX) - 1 + 4 * ((raw + 2) / 3) + 2)) {  // + newline and NUL
+        g_stats.dropped++;
+        return;
+    }
+    memcpy(g_line, PREFIX, sizeof(PREFIX) - 1);
+    size_t pos = sizeof(PREFIX) - 1;
+    uint8_t chunk[48];
+    size_t used = 0;
+    const uint8_t* parts[2] = { (const uint8_t*)&record, payload };
+    size_t part_lengths[2] = { sizeof(record), length };
+    for (size_t p = 0; p < 2; p++) {
+        for (size_t i = 0; i < part_lengths[p]; i++) {
+            chunk[used++] = parts[p][i];
+            append_base64(chunk, used, false, pos);
+        }
+    }
+    append_base64(chunk, used, true, pos);
+    g_line[pos++] = '\n';
+    Serial.write((const uint8_t*)g_line, pos);
+#endif
+    g_stats.records++;
+    g_stats.bytes += sizeof(record) + length;
+}
+
+void stomp_capture_end(void) {
+    if (!g_active) {
+        return;
+    }
+    g_active = false;
+#if STOMP_CAPTURE_MODE == 1
+    capture_file_close(g_file);
+#endif
+    APP_LOGI(CAPTURE, "Stopped: %u records, %u bytes, %u dropped",
+             g_stats.records, g_stats.bytes, g_stats.dropped);
+}
+
+StompCaptureStats stomp_capture_get_stats(void) {
+    return g_stats;
+}
+
+StompCaptureReader::StompCaptureReader() : _file(), _buffer(nullptr), _capacity(0) {
+}
+
+StompCaptureReader::~StompCaptureReader() {
+    close();
+}
+
+bool StompCaptureReader::open(const char* path) {
+    close();
+    if (!capture_file_open(_file, path, false)) {
+        return false;
+    }
+    uint8_t header[8];
+    if (capture_file_read(_file, header, sizeof(header)) != sizeof(header) ||
+        memcmp(header, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0 ||
+        header[4] != STOMP_CAPTURE_VERSION) {
+        capture_file_close(_file);
+        return false;
+    }
+    return true;
+}
+
+void StompCaptureReader::close() {
+    capture_file_close(_file);
+    free(_buffer);
+    _buffer = nullptr;
+    _capacity = 0;
+}
+
+bool StompCaptureReader::next(StompCaptureRecord& record, uint8_t*& payload) {
+    if (!_file || capture_file_read(_file, (uint8_t*)&record, sizeof(record)) != sizeof(record)) {
+        return false;
+    }
+    if (record.length > STOMP_CAPTURE_MAX_BYTES) {
+        return false;  // Corrupt record
+    }
+    if (record.length + 1 > _capacity) {
+        free(_buffer);
+        // Prefer PSRAM - replay must not starve the TLS buffers
+        _buffer = (uint8_t*)heap_caps_malloc(record.length + 1, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!_buffer) {
+            _buffer = (uint8_t*)malloc(record.length + 1);
+        }
+        _capacity = _buffer ? record.length + 1 : 0;
+        if (!_buffer) {
+            return false;
+        }
+    }
+    if (capture_file_read(_file, _buffer, record.length) != record.length) {
+        return false;
+    }
+    _buffer[record.length] = '\0';
+    payload = _buffer;
+    return true;
+}
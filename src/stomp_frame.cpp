@@ -0,0 +1,166 @@
+#include "stomp_frame.h"
+#include <string.h>
+
+bool StompSpan::equals(const char* str) const {
+    size_t len = strlen(str);
+    return len == length && memcmp(data, str, len) == 0;
+}
+
+bool StompFrame::header(const char* name, StompSpan& value) const {
+    for (size_t i = 0; i < header_count; i++) {
+        if (headers[i].name.equals(name)) {
+            value = headers[i].value;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool stomp_parse_uint(const StompSpan& span, size_t& value) {
+    if (span.length == 0 || span.length > 9) {
+        return false;
+    }
+    size_t result = 0;
+    for (size_t i = 0; i < span.length; i++) {
+        char c = span.data[i];
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        result = result * 10 + (c - '0');
+    }
+    value = result;
+    return true;
+}
+
+bool stomp_parse_heartbeat(const StompSpan& span, uint32_t& x, uint32_t& y) {
+    const char* comma = (const char*)memchr(span.data, ',', span.length);
+    if (!comma) {
+        return false;
+    }
+    StompSpan first = { span.data, (size_t)(comma - span.data) };
+    StompSpan second = { comma + 1, span.length - first.length - 1 };
+    size_t a = 0;
+    size_t b = 0;
+    if (!stomp_parse_uint(first, a) || !stomp_parse_uint(second, b)) {
+        return false;
+    }
+    x = a;
+    y = b;
+    return true;
+}
+
+// Strip a trailing \r (STOMP 1.2 allows \r\n line endings)
+static const char* trim_eol(const char* line_start, const char* line_end) {
+    if (line_end > line_start && line_end[-1] == '\r') {
+        return line_end - 1;
+    }
+    return line_end;
+}
+
+StompParseResult stomp_parse(const char* data, size_t length, bool at_message_end,
+                             StompFrame& frame, size_t& consumed) {
+    // STOMP frame format: COMMAND\nHEADERS\n\nBODY\x00
+    // Example:
+    // MESSAGE\n
+    // destination:/ws/...\n
+    // content-type:application/json\n
+    // content-length:2048\n
+    // \n
+    // {"json":"data"}\x00
+    frame.header_count = 0;
+    frame.body.data = nullptr;
+    frame.body.length = 0;
+    frame.length_mismatch = false;
+    consumed = 0;
+
+    const char* p = data;
+    const char* end = data + length;
+
+    // Skip leading EOLs (heart-beats may precede a frame)
+    while (p < end && (*p == '\n' || *p == '\r')) {
+        p++;
+    }
+    if (p == end) {
+        consumed = length;
+        return length > 0 ? STOMP_PARSE_HEARTBEAT : STOMP_PARSE_INCOMPLETE;
+    }
+
+    // Without the full header block we can only wait or give up
+    const StompParseResult truncated = at_message_end ? STOMP_PARSE_INVALID : STOMP_PARSE_INCOMPLETE;
+
+    // Command line
+    const char* nl = (const char*)memchr(p, '\n', end - p);
+    if (!nl) {
+        consumed = at_message_end ? length : 0;
+        return truncated;
+    }
+    const char* command_end = trim_eol(p, nl);
+    while (command_end > p && (command_end[-1] == ' ' || command_end[-1] == '\t')) {
+        command_end--;
+    }
+    frame.command.data = p;
+    frame.command.length = command_end - p;
+    p = nl + 1;
+
+    // Header lines until the blank separator line
+    while (true) {
+        nl = (p < end) ? (const char*)memchr(p, '\n', end - p) : nullptr;
+        if (!nl) {
+            consumed = at_message_end ? length : 0;
+            return truncated;
+        }
+        const char* line_end = trim_eol(p, nl);
+        if (line_end == p) {
+            p = nl + 1;  // Blank line - body follows
+            break;
+        }
+        const char* colon = (const char*)memchr(p, ':', line_end - p);
+        if (colon && frame.header_count < STOMP_MAX_HEADERS) {
+            StompHeader& h = frame.headers[frame.header_count++];
+            h.name.data = p;
+            h.name.length = colon - p;
+            h.value.data = colon + 1;
+            h.value.length = line_end - (colon + 1);
+        }
+        p = nl + 1;
+    }
+
+    size_t available = end - p;
+    frame.body.data = p;
+
+    // Body sized by content-length: must be followed by the null terminator
+    StompSpan content_length;
+    size_t body_len = 0;
+    if (frame.header("content-length", content_length) && stomp_parse_uint(content_length, body_len)) {
+        if (body_len < available && p[body_len] == '\0') {
+            frame.body.length = body_len;
+            consumed = (p - data) + body_len + 1;
+            return STOMP_PARSE_FRAME;
+        }
+        if (body_len == available && at_message_end) {
+            // Terminator missing at the very end of the message - accept
+            frame.body.length = body_len;
+            consumed = length;
+            return STOMP_PARSE_FRAME;
+        }
+        if (body_len >= available) {
+            return STOMP_PARSE_INCOMPLETE;  // Frame continues in the next message
+        }
+        // Length disagrees with the stream - fall back to the terminator
+        frame.length_mismatch = true;
+    }
+
+    // Body terminated by the null byte
+    const char* nul = (const char*)memchr(p, '\0', available);
+    if (nul) {
+        frame.body.length = nul - p;
+        consumed = (nul - data) + 1;
+        return STOMP_PARSE_FRAME;
+    }
+    if (at_message_end) {
+        frame.body.length = available;
+        consumed = length;
+        return STOMP_PARSE_FRAME;
+    }
+    return STOMP_PARSE_INCOMPLETE;
+}
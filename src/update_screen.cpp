@@ -34,9 +34,9 @@ bool updateDateTime(void)
              timeinfo.tm_min);
 
     // Update label with mutex protection
-    if (gui_mutex && xSemaphoreTake(gui_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+    if (gui_mutex && xSemaphoreTakeRecursive(gui_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
         lv_label_set_text(ui_timeLabel, timeStr);
-        xSemaphoreGive(gui_mutex);
+        xSemaphoreGiveRecursive(gui_mutex);
     }
 
     timeUpdate = millis();
@@ -100,7 +100,7 @@ void updateBatteryImages(void)
     }
     
     // Update all battery images on all screens with mutex protection
-    if (gui_mutex && xSemaphoreTake(gui_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+    if (gui_mutex && xSemaphoreTakeRecursive(gui_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
         // NoConnectionScreen - BatImage
         if (ui_BatImage) {
             lv_img_set_src(ui_BatImage, batteryImg);
@@ -119,7 +119,7 @@ void updateBatteryImages(void)
             lv_obj_clear_flag(ui_BatImage2, LV_OBJ_FLAG_HIDDEN);
         }
         
-        xSemaphoreGive(gui_mutex);
+        xSemaphoreGiveRecursive(gui_mutex);
     }
 }
 
@@ -137,7 +137,7 @@ void updateWiFiImages(void)
     }
     
     // Update WiFi images on all screens with mutex protection
-    if (gui_mutex && xSemaphoreTake(gui_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+    if (gui_mutex && xSemaphoreTakeRecursive(gui_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
         // NoConnectionScreen - NoWifiImage
         if (ui_NoWifiImage) {
             lv_img_set_src(ui_NoWifiImage, wifiImg);
@@ -156,7 +156,7 @@ void updateWiFiImages(void)
             lv_obj_clear_flag(ui_WifiImage, LV_OBJ_FLAG_HIDDEN);
         }
         
-        xSemaphoreGive(gui_mutex);
+        xSemaphoreGiveRecursive(gui_mutex);
     }
 }
 
@@ -181,7 +181,7 @@ void updateStatusImages(void)
 void showNoConnectionScreen(const char* errorMessage)
 {
     // LVGL calls with mutex protection
-    if (gui_mutex && xSemaphoreTake(gui_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+    if (gui_mutex && xSemaphoreTakeRecursive(gui_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
         // Check if we're already on NoConnectionScreen to avoid recursive screen loading
         if (lv_scr_act() != ui_NoConnectionScreen)
         {
@@ -194,7 +194,7 @@ void showNoConnectionScreen(const char* errorMessage)
             lv_label_set_text(ui_ErrorLabel, errorMessage);
         }
         
-        xSemaphoreGive(gui_mutex);
+        xSemaphoreGiveRecursive(gui_mutex);
     }
 }
 
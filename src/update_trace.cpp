@@ -0,0 +1,216 @@
+#include "update_trace.h"
+#include "spsc_ring.h"
+#include "app_log.h"
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+struct UpdateTrace {
+    uint32_t stamp_us[TRACE_STAGE_COUNT];
+    uint8_t reached;   // Bit per stamped stage
+};
+
+static const char* const SPAN_NAMES[TRACE_SPAN_COUNT] = {
+    "decode", "parse", "state", "queue", "apply", "render", "total",
+    "cloud_brewing", "cloud_ready"
+};
+
+// Network task
+static UpdateTrace g_current;
+static bool g_current_active = false;
+static int64_t g_received_ms = 0;
+
+// Network task -> Task_LVGL, in the same order as the display events
+static SpscRing<UpdateTrace, 4> g_handoff;
+
+// Task_LVGL (disp_flush runs inside lv_timer_handler on the same task)
+static UpdateTrace g_applying;
+static bool g_applying_active = false;
+static UpdateTrace g_awaiting_flush;
+static bool g_awaiting_flush_active = false;
+
+static TraceHistogram g_histograms[TRACE_SPAN_COUNT];
+static UpdateTraceStats g_stats = {};
+
+static void stamp(UpdateTrace& trace, TraceStage stage) {
+    trace.stamp_us[stage] = micros();
+    trace.reached |= 1u << stage;
+}
+
+static void record(TraceSpan span, uint32_t us) {
+    TraceHistogram& h = g_histograms[span];
+    size_t bucket = 0;
+    while (bucket < TRACE_HIST_BUCKETS - 1 && us >= TRACE_HIST_BOUNDS_US[bucket]) {
+        bucket++;
+    }
+    h.buckets[bucket]++;
+    h.count++;
+    h.sum_us += us;
+    if (us > h.max_us) {
+        h.max_us = us;
+    }
+}
+
+static void record_span(const UpdateTrace& trace, TraceSpan span, TraceStage from, TraceStage to) {
+    uint8_t needed = (1u << from) | (1u << to);
+    if ((trace.reached & needed) == needed) {
+        record(span, trace.stamp_us[to] - trace.stamp_us[from]);
+    }
+}
+
+void update_trace_begin() {
+    memset(&g_current, 0, sizeof(g_current));
+    stamp(g_current, TRACE_WS_RX);
+    g_current_active = true;
+
+    // Wall clock for cloud delay; unusable until NTP has set the time
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    g_received_ms = tv.tv_sec > 1600000000 ? (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000 : 0;
+}
+
+void update_trace_mark(TraceStage stage) {
+    if (g_current_active) {
+        stamp(g_current, stage);
+    }
+}
+
+int64_t update_trace_received_ms() {
+    return g_current_active ? g_received_ms : 0;
+}
+
+void update_trace_cloud(TraceSpan span, int64_t event_ms) {
+    int64_t received_ms = update_trace_received_ms();
+    if (received_ms == 0 || event_ms <= 0) {
+        return;
+    }
+    int64_t delay_ms = received_ms - event_ms;
+    if (delay_ms < 0) {
+        g_stats.clock_skew++;
+        return;
+    }
+    record(span, delay_ms > UINT32_MAX / 1000 ? UINT32_MAX : (uint32_t)delay_ms * 1000);
+}
+
+void update_trace_end(bool queued) {
+    if (!g_current_active) {
+        return;
+    }
+    g_current_active = false;
+    stamp(g_current, TRACE_STATE_QUEUED);
+    record_span(g_current, TRACE_SPAN_DECODE, TRACE_WS_RX, TRACE_STOMP_DECODED);
+    record_span(g_current, TRACE_SPAN_PARSE, TRACE_STOMP_DECODED, TRACE_JSON_PARSED);
+    record_span(g_current, TRACE_SPAN_STATE, TRACE_JSON_PARSED, TRACE_STATE_QUEUED);
+    if (queued && !g_handoff.push(g_current)) {
+        g_stats.handoff_dropped++;
+    }
+}
+
+void update_trace_apply_begin() {
+    // Popped before the events are drained, so the events of every trace
+    // taken here are already in the event ring
+    UpdateTrace trace;
+    while (g_handoff.pop(trace)) {
+        stamp(trace, TRACE_STATE_APPLIED);
+        record_span(trace, TRACE_SPAN_QUEUE, TRACE_STATE_QUEUED, TRACE_STATE_APPLIED);
+        if (g_applying_active) {
+            g_stats.superseded++;
+        }
+        g_applying = trace;
+        g_applying_active = true;
+    }
+}
+
+void update_trace_apply_end(bool invalidated) {
+    if (!g_applying_active) {
+        return;
+    }
+    g_applying_active = false;
+    stamp(g_applying, TRACE_LVGL_INVALIDATED);
+    record_span(g_applying, TRACE_SPAN_APPLY, TRACE_STATE_APPLIED, TRACE_LVGL_INVALIDATED);
+    if (!invalidated) {
+        g_stats.no_redraw++;
+        return;
+    }
+    if (g_awaiting_flush_active) {
+        g_stats.superseded++;
+    }
+    g_awaiting_flush = g_applying;
+    g_awaiting_flush_active = true;
+}
+
+void update_trace_flushed() {
+    if (!g_awaiting_flush_active) {
+        return;
+    }
+    g_awaiting_flush_active = false;
+    stamp(g_awaiting_flush, TRACE_FLUSHED);
+    record_span(g_awaiting_flush, TRACE_SPAN_RENDER, TRACE_LVGL_INVALIDATED, TRACE_FLUSHED);
+    record_span(g_awaiting_flush, TRACE_SPAN_TOTAL, TRACE_WS_RX, TRACE_FLUSHED);
+    g_stats.completed++;
+}
+
+const TraceHistogram& update_trace_histogram(TraceSpan span) {
+    return g_histograms[span];
+}
+
+const char* update_trace_span_name(TraceSpan span) {
+    return span < TRACE_SPAN_COUNT ? SPAN_NAMES[span] : "?";
+}
+
+const UpdateTraceStats& update_trace_get_stats() {
+    return g_stats;
+}
+
+static void format_bound(char* out, size_t size, uint32_t us) {
+    if (us >= 1000000) {
+        snprintf(out, size, "%us", (unsigned)(us / 1000000));
+    } else if (us >= 1000) {
+        snprintf(out, size, "%ums", (unsigned)(us / 1000));
+    } else {
+        snprintf(out, size, "%uus", (unsigned)us);
+    }
+}
+
+void update_trace_print(const char* module) {
+    app_log_write(APP_LOG_INFO, module,
+                  "Update traces: %u completed, %u without redraw, %u superseded, %u hand-offs dropped, %u skewed",
+                  g_stats.completed, g_stats.no_redraw, g_stats.superseded,
+                  g_stats.handoff_dropped, g_stats.clock_skew);
+    for (size_t span = 0; span < TRACE_SPAN_COUNT; span++) {
+        const TraceHistogram& h = g_histograms[span];
+        if (h.count == 0) {
+            continue;
+        }
+        app_log_write(APP_LOG_INFO, module, "  %-13s n=%u avg %u us, max %u us",
+                      SPAN_NAMES[span], h.count, (uint32_t)(h.sum_us / h.count), h.max_us);
+
+        // Buckets on their own lines, a new one whenever the next bucket would not fit
+        static const char BUCKET_INDENT[] = "    ";
+        char buckets[APP_LOG_LINE_LEN - (sizeof(BUCKET_INDENT) - 1)];
+        size_t used = 0;
+        for (size_t i = 0; i < TRACE_HIST_BUCKETS; i++) {
+            if (h.buckets[i] == 0) {
+                continue;
+            }
+            char bound[8];
+            format_bound(bound, sizeof(bound), TRACE_HIST_BOUNDS_US[i < TRACE_HIST_BUCKETS - 1 ? i : i - 1]);
+            char entry[32];
+            int n = snprintf(entry, sizeof(entry), " %s%s:%u",
+                             i < TRACE_HIST_BUCKETS - 1 ? "<" : ">=", bound, h.buckets[i]);
+            if (n < 0) {
+                break;
+            }
+            if (used + (size_t)n >= sizeof(buckets) && used > 0) {
+                app_log_write(APP_LOG_INFO, module, "%s%s", BUCKET_INDENT, buckets);
+                used = 0;
+            }
+            memcpy(buckets + used, entry, (size_t)n + 1);
+            used += (size_t)n;
+        }
+        if (used > 0) {
+            app_log_write(APP_LOG_INFO, module, "%s%s", BUCKET_INDENT, buckets);
+        }
+    }
+}
@@ -1,28 +1,20 @@
 #include "water_alarm.h"
 #include "brewing_display.h"  // Need to check brewing state
+#include "app_log.h"
 #include "ui/ui.h"
 #include <Arduino.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 
-// Debug output
-#define DEBUG_WATER 1
-#if DEBUG_WATER
-#define water_debug(x) Serial.print(x)
-#define water_debugln(x) Serial.println(x)
-#else
-#define water_debug(x)
-#define water_debugln(x)
-#endif
-
 // Global variables
 static bool g_initialized = false;
 static bool g_alarm_active = false;
 static SemaphoreHandle_t g_gui_mutex = NULL;
 
 // Helper macro for mutex protection
-#define TAKE_MUTEX() if (g_gui_mutex && xSemaphoreTake(g_gui_mutex, pdMS_TO_TICKS(100)) == pdTRUE)
-#define GIVE_MUTEX() if (g_gui_mutex) xSemaphoreGive(g_gui_mutex)
+// The GUI mutex is recursive: events are applied from Task_LVGL while it already holds it
+#define TAKE_MUTEX() if (g_gui_mutex && xSemaphoreTakeRecursive(g_gui_mutex, pdMS_TO_TICKS(100)) == pdTRUE)
+#define GIVE_MUTEX() if (g_gui_mutex) xSemaphoreGiveRecursive(g_gui_mutex)
 
 
 /**
@@ -30,7 +22,7 @@ static SemaphoreHandle_t g_gui_mutex = NULL;
  */
 void water_alarm_set_mutex(void* mutex) {
     g_gui_mutex = (SemaphoreHandle_t)mutex;
-    water_debugln("[WaterAlarm] Mutex set for thread-safe operation");
+    APP_LOGD(WATER, "Mutex set for thread-safe operation");
 }
 
 /**
@@ -38,11 +30,11 @@ void water_alarm_set_mutex(void* mutex) {
  */
 void water_alarm_init(void) {
     if (g_initialized) {
-        water_debugln("[WaterAlarm] Already initialized");
+        APP_LOGD(WATER, "Already initialized");
         return;
     }
     
-    water_debugln("[WaterAlarm] Initializing water alarm system...");
+    APP_LOGD(WATER, "Initializing water alarm system...");
     
     TAKE_MUTEX() {
         // Hide water alarm elements by default (they are created in SquareLine Studio)
@@ -58,7 +50,7 @@ void water_alarm_init(void) {
     
     g_initialized = true;
     g_alarm_active = false;
-    water_debugln("[WaterAlarm] Initialization complete");
+    APP_LOGD(WATER, "Initialization complete");
 }
 
 /**
@@ -66,7 +58,7 @@ void water_alarm_init(void) {
  */
 void water_alarm_set(bool alarm_active) {
     if (!g_initialized) {
-        water_debugln("[WaterAlarm] ERROR: Not initialized!");
+        APP_LOGE(WATER, "Not initialized!");
         return;
     }
     
@@ -77,13 +69,12 @@ void water_alarm_set(bool alarm_active) {
     
     g_alarm_active = alarm_active;
     
-    water_debug("[WaterAlarm] Setting alarm state to: ");
-    water_debugln(alarm_active ? "ACTIVE" : "INACTIVE");
+    APP_LOGI(WATER, "Setting alarm state to: %s", alarm_active ? "ACTIVE" : "INACTIVE");
     
     TAKE_MUTEX() {
         if (alarm_active) {
             // ALARM ACTIVE: Show water elements, hide boiler elements
-            water_debugln("[WaterAlarm] Showing water alarm, hiding boiler elements");
+            APP_LOGD(WATER, "Showing water alarm, hiding boiler elements");
             
             // Show water alarm elements from SquareLine Studio (waterImage and waterAlarmLabel)
             if (ui_waterImage) {
@@ -137,7 +128,7 @@ void water_alarm_set(bool alarm_active) {
             
         } else {
             // ALARM INACTIVE: Hide water elements, restore boiler elements ONLY if brewing is NOT active
-            water_debugln("[WaterAlarm] Hiding water alarm");
+            APP_LOGD(WATER, "Hiding water alarm");
             
             // Hide water alarm elements
             if (ui_waterImage) {
@@ -152,7 +143,7 @@ void water_alarm_set(bool alarm_active) {
             // Only show boiler elements if brewing is NOT active (includes flashing state)
             bool brewing_active = brewing_display_is_active();
             if (!brewing_active) {
-                water_debugln("[WaterAlarm] Brewing not active, showing boiler elements");
+                APP_LOGD(WATER, "Brewing not active, showing boiler elements");
             
             // Show boiler arcs
             if (ui_Arc2) {
@@ -194,7 +185,7 @@ void water_alarm_set(bool alarm_active) {
                     lv_obj_invalidate(ui_BoilerTempLabel);
                 }
             } else {
-                water_debugln("[WaterAlarm] Brewing is active, keeping boiler elements hidden");
+                APP_LOGD(WATER, "Brewing is active, keeping boiler elements hidden");
             }
         }
         
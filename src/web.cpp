@@ -69,3 +69,14 @@ void setupWEB(void)
     // Increased stack to 16k, lowered priority to 1, moved to Core 1
     xTaskCreatePinnedToCore((void (*)(void *))webTask, "webTask", 16384, NULL, 1, &t1, 1);
 }
+
+void setupStatusWEB(void)
+{
+    server.on("/latency", HTTP_GET, latencyHandler);
+    server.begin();
+    log_i("Status HTTP server started");
+
+    // Only a JSON endpoint here, so a smaller stack than the setup portal
+    TaskHandle_t t1;
+    xTaskCreatePinnedToCore((void (*)(void *))webTask, "webTask", 6144, NULL, 1, &t1, 1);
+}
@@ -6,6 +6,7 @@
 #include "config.h"
 #include "Preferences.h"
 #include "lamarzocco_auth.h"
+#include "update_trace.h"
 #include <set>
 
 extern Preferences preferences;
@@ -92,6 +93,35 @@ void sendStatus(void)
     server.send(200, "application/json", jsonString);
 }
 
+void latencyHandler(void)
+{
+    JsonDocument jsonDoc;
+    const UpdateTraceStats &stats = update_trace_get_stats();
+    jsonDoc["completed"] = stats.completed;
+    jsonDoc["no_redraw"] = stats.no_redraw;
+    jsonDoc["superseded"] = stats.superseded;
+    jsonDoc["handoff_dropped"] = stats.handoff_dropped;
+    jsonDoc["clock_skew"] = stats.clock_skew;
+    JsonArray bounds = jsonDoc["bounds_us"].to<JsonArray>();
+    for (size_t i = 0; i < TRACE_HIST_BUCKETS - 1; i++)
+        bounds.add(TRACE_HIST_BOUNDS_US[i]);
+    JsonObject spans = jsonDoc["spans"].to<JsonObject>();
+    for (int span = 0; span < TRACE_SPAN_COUNT; span++)
+    {
+        const TraceHistogram &h = update_trace_histogram((TraceSpan)span);
+        JsonObject entry = spans[update_trace_span_name((TraceSpan)span)].to<JsonObject>();
+        entry["count"] = h.count;
+        entry["avg_us"] = h.count ? (uint32_t)(h.sum_us / h.count) : 0;
+        entry["max_us"] = h.max_us;
+        JsonArray buckets = entry["buckets"].to<JsonArray>();
+        for (size_t i = 0; i < TRACE_HIST_BUCKETS; i++)
+            buckets.add(h.buckets[i]);
+    }
+    String jsonString;
+    serializeJson(jsonDoc, jsonString);
+    server.send(200, "application/json", jsonString);
+}
+
 void saveWifiHandler(void)
 {
     String ssid = server.arg("ssid");
@@ -0,0 +1,53 @@
+#include "widget_handler.h"
+
+WidgetRegistry::WidgetRegistry() : _seen(0), _changed(0), _stats() {
+    for (size_t i = 0; i < WIDGET_CODE_COUNT; i++) {
+        _handlers[i] = nullptr;
+    }
+}
+
+bool WidgetRegistry::add(DashboardWidgetCode code, WidgetHandler& handler) {
+    if (code == WIDGET_UNKNOWN || code >= WIDGET_CODE_COUNT || _handlers[code]) {
+        return false;
+    }
+    _handlers[code] = &handler;
+    return true;
+}
+
+void WidgetRegistry::begin_frame() {
+    _seen = 0;
+    _changed = 0;
+}
+
+void WidgetRegistry::dispatch(DashboardWidgetCode code, const WidgetOutput& output) {
+    WidgetHandler* handler = find(code);
+    if (!handler) {
+        _stats.unhandled++;
+        return;
+    }
+    _seen |= 1u << code;
+    _stats.dispatched++;
+    if (handler->update(code, output)) {
+        _changed |= 1u << code;
+        _stats.changed++;
+    }
+}
+
+void WidgetRegistry::end_frame() {
+    for (size_t code = 1; code < WIDGET_CODE_COUNT; code++) {
+        if (_handlers[code] && !((_seen >> code) & 1u)) {
+            if (_handlers[code]->clear((DashboardWidgetCode)code)) {
+                _changed |= 1u << code;
+                _stats.changed++;
+            }
+        }
+    }
+}
+
+void WidgetRegistry::print_changed() const {
+    for (size_t code = 1; code < WIDGET_CODE_COUNT; code++) {
+        if (_handlers[code] && changed((DashboardWidgetCode)code)) {
+            _handlers[code]->print((DashboardWidgetCode)code);
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""
+Rebuild a capture file from a serial log recorded with STOMP_CAPTURE_MODE 2.
+
+Each "[CAP] " line holds one record (StompCaptureRecord header and payload)
+base64-encoded; the "[CAP] LMZC v<n>" line marks the start of a capture. The
+output is the file STOMP_CAPTURE_MODE 1 would have written, ready to replay
+on the device (upload it to SPIFFS as STOMP_CAPTURE_PATH) or in the native
+bench:
+
+    python3 tools/capture_from_log.py monitor.log capture.bin
+    .pio/build/native/program --replay capture.bin
+
+Lines that do not decode to a whole record (cut off, or mixed with other log
+output) are skipped and counted. If the log holds several captures (the
+device rebooted), the last one is written unless --index picks another.
+"""
+
+import argparse
+import base64
+import binascii
+import re
+import struct
+import sys
+
+MAGIC = b"LMZC"
+VERSION = 1
+RECORD_HEADER = struct.Struct("<IBI")  # rx_ms, type, length (packed)
+START = re.compile(r"\[CAP\] LMZC v(\d+)\s*$")
+RECORD = re.compile(r"\[CAP\] ([A-Za-z0-9+/=]+)\s*$")
+
+
+def read_captures(lines):
+    """Split the log into captures: lists of (header, payload) records."""
+    captures = []
+    skipped = 0
+    for line in lines:
+        start = START.search(line)
+        if start:
+            if int(start.group(1)) != VERSION:
+                sys.exit("capture version %s, expected %d" % (start.group(1), VERSION))
+            captures.append([])
+            continue
+        match = RECORD.search(line)
+        if not match or not captures:
+            continue
+        try:
+            data = base64.b64decode(match.group(1), validate=True)
+        except binascii.Error:
+            skipped += 1
+            continue
+        if len(data) < RECORD_HEADER.size:
+            skipped += 1
+            continue
+        _, _, length = RECORD_HEADER.unpack_from(data)
+        if len(data) != RECORD_HEADER.size + length:
+            skipped += 1
+            continue
+        captures[-1].append(data)
+    return captures, skipped
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("log", help="serial log with [CAP] lines ('-' for stdin)")
+    parser.add_argument("output", help="capture file to write")
+    parser.add_argument("--index", type=int, default=-1,
+                        help="capture to write when the log holds several (default: last)")
+    args = parser.parse_args()
+
+    if args.log == "-":
+        captures, skipped = read_captures(sys.stdin)
+    else:
+        with open(args.log, encoding="utf-8", errors="replace") as log:
+            captures, skipped = read_captures(log)
+    if not captures:
+        sys.exit("no [CAP] LMZC start line in %s" % args.log)
+
+    records = captures[args.index]
+    with open(args.output, "wb") as out:
+        out.write(MAGIC + bytes([VERSION, 0, 0, 0]))
+        for record in records:
+            out.write(record)
+    print("%s: %d records, %d bytes (%d of %d captures in the log, %d lines skipped)" %
+          (args.output, len(records), sum(len(r) for r in records),
+           args.index % len(captures) + 1, len(captures), skipped))
+
+
+if __name__ == "__main__":
+    main()
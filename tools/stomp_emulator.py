@@ -0,0 +1,313 @@
+#!/usr/bin/env python3
+"""
+Local stand-in for lion.lamarzocco.io: the customer-app REST endpoints used by
+the firmware and STOMP over WebSocket on /ws/connect.
+
+Point the firmware at it with build flags, e.g. in platformio.ini:
+
+    -D WS_BASE_URL=\\"192.168.1.10\\"
+    -D WS_PORT=8443
+    -D CUSTOMER_APP_URL=\\"https://192.168.1.10:8443/api/customer-app\\"
+
+The firmware talks TLS (certificates are not verified), so the emulator needs
+a certificate. A self-signed one is enough:
+
+    openssl req -x509 -newkey rsa:2048 -nodes -days 365 -subj /CN=emulator \\
+        -keyout emulator.key -out emulator.crt
+
+    python3 tools/stomp_emulator.py --cert emulator.crt --key emulator.key --rate 10
+
+Fault injection: --disconnect-every, --error-every, --slow-consumer (bursts
+without waiting for the socket to drain), --split / --concat (STOMP frames
+spread over or packed into WebSocket messages).
+
+Requires aiohttp (pip install aiohttp).
+"""
+
+import argparse
+import asyncio
+import json
+import random
+import ssl
+import time
+import uuid
+
+from aiohttp import WSMsgType, web
+
+SIGNED_HEADERS = ("X-App-Installation-Id", "X-Timestamp", "X-Nonce", "X-Request-Signature")
+
+
+def now_ms():
+    return int(time.time() * 1000)
+
+
+class Machine:
+    """Dashboard state, changed by commands and by the brew simulation."""
+
+    def __init__(self, serial):
+        self.serial = serial
+        self.mode = "BrewingMode"
+        self.brewing_since = None
+        self.steam_enabled = True
+        self.no_water = False
+        self.commands = []  # [{"id", "status"}], reported once then dropped
+
+    def tick(self, brew_every, brew_seconds):
+        # Start a shot every brew_every seconds, stop it after brew_seconds
+        t = time.time()
+        if self.mode != "BrewingMode" or brew_every <= 0:
+            self.brewing_since = None
+        elif self.brewing_since is None and int(t) % brew_every == 0:
+            self.brewing_since = now_ms()
+        elif self.brewing_since and now_ms() - self.brewing_since > brew_seconds * 1000:
+            self.brewing_since = None
+
+    def apply_command(self, name, body):
+        if name == "CoffeeMachineChangeMode":
+            self.mode = body.get("mode", self.mode)
+        elif name == "CoffeeMachineSettingSteamBoilerEnabled":
+            self.steam_enabled = bool(body.get("enabled", self.steam_enabled))
+        command_id = str(uuid.uuid4())
+        self.commands.append({"id": command_id, "status": "Success"})
+        return command_id
+
+    def dashboard(self):
+        on = self.mode == "BrewingMode"
+        if not on:
+            status = "StandBy"
+        elif self.brewing_since:
+            status = "Brewing"
+        else:
+            status = "PoweredOn"
+        widgets = [
+            {"code": "CMMachineStatus", "index": 1, "output": {
+                "status": status, "availableModes": ["BrewingMode", "StandBy"], "mode": self.mode,
+                "nextStatus": None, "brewingStartTime": self.brewing_since,
+                "lastCoffee": None, "lastFlush": None}},
+            {"code": "CMCoffeeBoiler", "index": 1, "output": {
+                "status": "Ready" if on else "StandBy", "enabled": True, "enabledSupported": False,
+                "targetTemperature": 94.00, "targetTemperatureMin": 80, "targetTemperatureMax": 100,
+                "targetTemperatureStep": 0.1, "readyStartTime": None}},
+            {"code": "CMSteamBoilerLevel", "index": 1, "output": {
+                "status": "Ready" if on and self.steam_enabled else "Off",
+                "enabled": self.steam_enabled, "enabledSupported": True, "targetLevel": "Level2",
+                "targetLevelSupported": True, "readyStartTime": None}},
+            {"code": "CMPreBrewing", "index": 1, "output": {
+                "availableModes": ["PreBrewing", "Disabled"], "mode": "PreBrewing",
+                "times": {"PreBrewing": [{"doseIndex": "ByGroup", "seconds": {"Out": 3.00, "In": 2.00},
+                                          "secondsMin": {"Out": 1, "In": 1},
+                                          "secondsMax": {"Out": 9, "In": 9},
+                                          "secondsStep": {"Out": 0.1, "In": 0.1}}]},
+                "doseIndexSupported": False}},
+            {"code": "CMBackFlush", "index": 1, "output": {
+                "lastCleaningStartTime": 1761071774016, "status": "Off"}},
+        ]
+        if self.no_water:
+            widgets.append({"code": "CMNoWater", "index": 1, "output": {"allarm": True}})
+        commands, self.commands = self.commands, []
+        return {"connected": True, "removedWidgets": [], "connectionDate": now_ms(),
+                "widgets": widgets, "uuid": str(uuid.uuid4()), "commands": commands}
+
+
+def stomp_frame(command, headers, body=b""):
+    lines = [command] + ["%s:%s" % (k, v) for k, v in headers]
+    return ("\n".join(lines) + "\n\n").encode() + body + b"\x00"
+
+
+def stomp_parse(data):
+    """Split a WebSocket message into (command, headers, body) frames."""
+    frames = []
+    for raw in data.split(b"\x00"):
+        raw = raw.lstrip(b"\r\n")
+        if not raw:
+            continue
+        head, _, body = raw.partition(b"\n\n")
+        lines = head.decode(errors="replace").split("\n")
+        headers = {}
+        for line in lines[1:]:
+            name, _, value = line.rstrip("\r").partition(":")
+            headers.setdefault(name, value)
+        frames.append((lines[0].strip(), headers, body))
+    return frames
+
+
+class Session:
+    def __init__(self, args, machine, ws, peer):
+        self.args = args
+        self.machine = machine
+        self.ws = ws
+        self.peer = peer
+        self.subscription = None
+        self.send_hb_ms = 0
+        self.pending = []  # Encoded frames waiting for --concat
+
+    def log(self, msg):
+        print("[%s] %s" % (self.peer, msg), flush=True)
+
+    async def send(self, frame, shaped=False):
+        # Only MESSAGE frames are split / concatenated, control frames go out as-is
+        if shaped and self.args.concat > 1:
+            self.pending.append(frame)
+            if len(self.pending) < self.args.concat:
+                return
+            frame, self.pending = b"".join(self.pending), []
+        if shaped and self.args.split > 1:
+            # Several WebSocket messages for one STOMP frame
+            step = max(1, len(frame) // self.args.split)
+            for i in range(0, len(frame), step):
+                await self.ws.send_str(frame[i:i + step].decode(errors="replace"))
+            return
+        await self.ws.send_str(frame.decode())
+
+    async def on_frame(self, command, headers, body):
+        if command in ("CONNECT", "STOMP"):
+            if not headers.get("Authorization", "").startswith("Bearer "):
+                await self.send(stomp_frame("ERROR", [("message", "missing Authorization")]))
+                await self.ws.close()
+                return
+            cx, _, cy = headers.get("heart-beat", "0,0").partition(",")
+            # Offer server heart-beats (at most every 5 s) only if the client wants them
+            self.send_hb_ms = max(int(cy or 0), 5000) if int(cy or 0) else 0
+            await self.send(stomp_frame("CONNECTED", [
+                ("version", "1.2"), ("heart-beat", "%d,0" % self.send_hb_ms), ("server", "stomp-emulator")]))
+            self.log("CONNECTED (heart-beat client %s,%s)" % (cx, cy))
+        elif command == "SUBSCRIBE":
+            expected = "/ws/sn/%s/dashboard" % self.machine.serial
+            if headers.get("destination") != expected and self.machine.serial != "*":
+                self.log("SUBSCRIBE to unexpected destination %s" % headers.get("destination"))
+            self.subscription = (headers.get("id", "0"), headers.get("destination", expected))
+            self.log("SUBSCRIBED %s" % self.subscription[1])
+            await self.push_dashboard()
+        elif command == "UNSUBSCRIBE":
+            self.subscription = None
+        elif command == "DISCONNECT":
+            await self.ws.close()
+
+    async def push_dashboard(self):
+        if not self.subscription:
+            return
+        body = json.dumps(self.machine.dashboard(), separators=(",", ":")).encode()
+        sub_id, destination = self.subscription
+        await self.send(stomp_frame("MESSAGE", [
+            ("destination", destination), ("content-type", "application/json"),
+            ("subscription", sub_id), ("message-id", str(uuid.uuid4())),
+            ("content-length", str(len(body)))], body), shaped=True)
+
+    async def producer(self):
+        args = self.args
+        started = time.monotonic()
+        last_hb = time.monotonic()
+        interval = 1.0 / args.rate
+        while not self.ws.closed:
+            self.machine.tick(args.brew_every, args.brew_seconds)
+            elapsed = time.monotonic() - started
+            if args.disconnect_every and elapsed >= args.disconnect_every:
+                self.log("injecting disconnect")
+                await self.ws.close()
+                return
+            if args.error_every and elapsed >= args.error_every:
+                self.log("injecting ERROR frame")
+                await self.send(stomp_frame("ERROR", [("message", "injected by emulator")]))
+                await self.ws.close()
+                return
+            if self.subscription:
+                burst = args.slow_consumer if args.slow_consumer > 1 else 1
+                for _ in range(burst):
+                    await self.push_dashboard()
+            if self.send_hb_ms and time.monotonic() - last_hb >= self.send_hb_ms / 1000:
+                await self.ws.send_str("\n")
+                last_hb = time.monotonic()
+            await asyncio.sleep(interval * (1 + random.uniform(-args.jitter, args.jitter)))
+
+
+def make_app(args):
+    machine = Machine(args.serial)
+    routes = web.RouteTableDef()
+    prefix = "/api/customer-app"
+
+    def token_response():
+        return web.json_response({"accessToken": "emulator-" + uuid.uuid4().hex,
+                                  "refreshToken": "emulator-refresh",
+                                  "expiresIn": args.token_lifetime})
+
+    @routes.post(prefix + "/auth/init")
+    async def auth_init(request):
+        return web.json_response({}, status=201)
+
+    @routes.post(prefix + "/auth/signin")
+    async def signin(request):
+        return token_response()
+
+    @routes.post(prefix + "/auth/refreshtoken")
+    async def refresh(request):
+        return token_response()
+
+    @routes.post(prefix + "/things/{serial}/command/{name}")
+    async def command(request):
+        try:
+            body = await request.json()
+        except json.JSONDecodeError:
+            body = {}
+        command_id = machine.apply_command(request.match_info["name"], body)
+        print("[REST] %s %s -> %s" % (request.match_info["name"], body, command_id), flush=True)
+        return web.json_response({"id": command_id, "status": "Pending"})
+
+    @routes.get("/ws/connect")
+    async def ws_connect(request):
+        missing = [h for h in SIGNED_HEADERS if h not in request.headers]
+        if missing:
+            return web.Response(status=401, text="missing headers: " + ", ".join(missing))
+        ws = web.WebSocketResponse(heartbeat=None)
+        await ws.prepare(request)
+        session = Session(args, machine, ws, request.remote)
+        session.log("WebSocket open")
+        producer = asyncio.ensure_future(session.producer())
+        try:
+            async for msg in ws:
+                if msg.type == WSMsgType.TEXT:
+                    data = msg.data.encode()
+                elif msg.type == WSMsgType.BINARY:
+                    data = msg.data
+                else:
+                    break
+                for command_name, headers, body in stomp_parse(data):
+                    await session.on_frame(command_name, headers, body)
+        finally:
+            producer.cancel()
+            session.log("WebSocket closed")
+        return ws
+
+    app = web.Application()
+    app.add_routes(routes)
+    return app
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=8443)
+    parser.add_argument("--cert", required=True, help="TLS certificate (PEM)")
+    parser.add_argument("--key", required=True, help="TLS private key (PEM)")
+    parser.add_argument("--serial", default="*", help="expected machine serial (* = any)")
+    parser.add_argument("--rate", type=float, default=1.0, help="dashboard messages per second (1-100)")
+    parser.add_argument("--jitter", type=float, default=0.0, help="random +/- fraction of the interval")
+    parser.add_argument("--brew-every", type=int, default=60, help="simulate a shot every N seconds (0 = never)")
+    parser.add_argument("--brew-seconds", type=int, default=25)
+    parser.add_argument("--token-lifetime", type=int, default=3600, help="expiresIn of issued tokens (s)")
+    parser.add_argument("--disconnect-every", type=float, default=0, help="close the socket after N seconds")
+    parser.add_argument("--error-every", type=float, default=0, help="send an ERROR frame after N seconds")
+    parser.add_argument("--slow-consumer", type=int, default=0,
+                        help="push N messages back to back per tick without pacing")
+    parser.add_argument("--split", type=int, default=0, help="split each STOMP frame into N WebSocket messages")
+    parser.add_argument("--concat", type=int, default=0, help="pack N STOMP frames into one WebSocket message")
+    args = parser.parse_args()
+    if not 1 <= args.rate <= 100:
+        parser.error("--rate must be between 1 and 100")
+
+    context = ssl.create_default_context(ssl.Purpose.CLIENT_AUTH)
+    context.load_cert_chain(args.cert, args.key)
+    web.run_app(make_app(args), host=args.host, port=args.port, ssl_context=context)
+
+
+if __name__ == "__main__":
+    main()